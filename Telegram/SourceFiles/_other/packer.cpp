@@ -19,6 +19,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 bool AlphaChannel = false;
 quint64 BetaVersion = 0;
+QString BaseDir;
+quint64 BaseVersion = 0;
 
 #if BETTERGRAM_UPDATES
 // There are original Bettergram updates publc keys
@@ -148,6 +150,86 @@ int32 *hashSha1(const void *data, uint32 len, void *dest) {
 	return (int32*)sha1To;
 }
 
+// Delta packages start with this marker and the base version number,
+// instead of files they contain patches for the files of the base version.
+// A patch is a list of commands, each copies a part of the base file
+// or adds new bytes, see ApplyUpdatePatch() in core/update_checker.cpp.
+const quint32 DeltaPackageMarker = 0x7FFFFFFE;
+const quint8 PatchCopy = 0;
+const quint8 PatchAdd = 1;
+const int32 PatchBlockSize = 64;
+
+QByteArray countPatch(const QByteArray &original, const QByteArray &updated) {
+	const uchar *from = (const uchar*)original.constData();
+	const uchar *to = (const uchar*)updated.constData();
+	const int32 fromSize = original.size(), toSize = updated.size();
+
+	// Rolling checksum from rsync: low 16 bits of a and b.
+	const auto blockHash = [](uint32 a, uint32 b) {
+		return (b << 16) | (a & 0xFFFF);
+	};
+
+	QHash<uint32, int32> blocks;
+	for (int32 offset = 0; offset + PatchBlockSize <= fromSize; offset += PatchBlockSize) {
+		uint32 a = 0, b = 0;
+		for (int32 i = 0; i != PatchBlockSize; ++i) {
+			a += from[offset + i];
+			b += (PatchBlockSize - i) * from[offset + i];
+		}
+		const uint32 hash = blockHash(a, b);
+		if (!blocks.contains(hash)) {
+			blocks.insert(hash, offset);
+		}
+	}
+
+	QByteArray result;
+	QDataStream stream(&result, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	int32 added = 0, position = 0;
+	uint32 a = 0, b = 0;
+	bool hashed = false;
+	while (position + PatchBlockSize <= toSize) {
+		if (!hashed) {
+			a = b = 0;
+			for (int32 i = 0; i != PatchBlockSize; ++i) {
+				a += to[position + i];
+				b += (PatchBlockSize - i) * to[position + i];
+			}
+			hashed = true;
+		}
+		const auto i = blocks.constFind(blockHash(a, b));
+		if (i != blocks.cend() && !memcmp(from + i.value(), to + position, PatchBlockSize)) {
+			int32 start = i.value(), begin = position, length = PatchBlockSize;
+			while (start + length < fromSize && begin + length < toSize && from[start + length] == to[begin + length]) {
+				++length;
+			}
+			while (start > 0 && begin > added && from[start - 1] == to[begin - 1]) {
+				--start;
+				--begin;
+				++length;
+			}
+			if (begin > added) {
+				stream << PatchAdd << QByteArray(updated.constData() + added, begin - added);
+			}
+			stream << PatchCopy << quint32(start) << quint32(length);
+			position = added = begin + length;
+			hashed = false;
+		} else {
+			if (position + PatchBlockSize < toSize) {
+				const uint32 out = to[position], in = to[position + PatchBlockSize];
+				a = a - out + in;
+				b = b - PatchBlockSize * out + a;
+			}
+			++position;
+		}
+	}
+	if (toSize > added) {
+		stream << PatchAdd << QByteArray(updated.constData() + added, toSize - added);
+	}
+	return result;
+}
+
 QString BetaSignature;
 
 int main(int argc, char *argv[])
@@ -168,6 +250,10 @@ int main(int argc, char *argv[])
 			target32 = (string("mac32") == argv[i + 1]);
 		} else if (string("-version") == argv[i] && i + 1 < argc) {
 			version = QString(argv[i + 1]).toInt();
+		} else if (string("-base") == argv[i] && i + 1 < argc) {
+			BaseDir = QFileInfo(workDir + QString(argv[i + 1])).absoluteFilePath() + '/';
+		} else if (string("-baseversion") == argv[i] && i + 1 < argc) {
+			BaseVersion = QString(argv[i + 1]).toULongLong();
 		} else if (string("-alpha") == argv[i]) {
 			AlphaChannel = true;
 		} else if (string("-beta") == argv[i] && i + 1 < argc) {
@@ -193,6 +279,11 @@ int main(int argc, char *argv[])
 #else
 		cout << "Usage: Packer -path {file} -version {version} OR Packer -path {dir} -version {version}\n";
 #endif
+		cout << "Add -base {dir} -baseversion {version} to pack a delta update for the files in {dir}.\n";
+		return -1;
+	}
+	if (BaseDir.isEmpty() != !BaseVersion) {
+		cout << "Both -base and -baseversion should be passed for a delta update.\n";
 		return -1;
 	}
 
@@ -235,6 +326,10 @@ int main(int argc, char *argv[])
 		QDataStream stream(&buffer);
 		stream.setVersion(QDataStream::Qt_5_1);
 
+		if (BaseVersion) {
+			stream << DeltaPackageMarker;
+			stream << quint64(BaseVersion);
+		}
 		if (BetaVersion) {
 			stream << quint32(0x7FFFFFFF);
 			stream << quint64(BetaVersion);
@@ -256,7 +351,25 @@ int main(int argc, char *argv[])
 				return -1;
 			}
 			QByteArray inner = f.readAll();
-			stream << name << quint32(inner.size()) << inner;
+			if (BaseVersion) {
+				QByteArray original;
+				QFile base(BaseDir + name);
+				if (base.exists()) {
+					if (!base.open(QIODevice::ReadOnly)) {
+						cout << "Can't open '" << (BaseDir + name).toUtf8().constData() << "' for read..\n";
+						return -1;
+					}
+					original = base.readAll();
+				}
+				QByteArray patch = countPatch(original, inner);
+				cout << "Patch for " << name.toUtf8().constData() << " (" << patch.size() << ")\n";
+
+				char sha1[20];
+				hashSha1(inner.constData(), inner.size(), sha1);
+				stream << name << quint32(inner.size()) << patch << QByteArray(sha1, 20);
+			} else {
+				stream << name << quint32(inner.size()) << inner;
+			}
 #if defined Q_OS_MAC || defined Q_OS_LINUX
 			stream << (QFileInfo(fullName).isExecutable() ? true : false);
 #endif
@@ -480,6 +593,9 @@ int main(int argc, char *argv[])
 	if (BetaVersion) {
 		outName += "_" + BetaSignature;
 	}
+	if (BaseVersion) {
+		outName += QString("_delta%1").arg(BaseVersion);
+	}
 	QFile out(outName);
 	if (!out.open(QIODevice::WriteOnly)) {
 		cout << "Can't open '" << outName.toUtf8().constData() << "' for write..\n";
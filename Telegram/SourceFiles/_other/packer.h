@@ -14,6 +14,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include <QtCore/QStringList>
 #include <QtCore/QBuffer>
 #include <QtCore/QDataStream>
+#include <QtCore/QHash>
 
 #include <zlib.h>
 
@@ -67,6 +67,8 @@ constexpr auto kFileLoaderQueueStopTimeout = TimeMs(5000);
 constexpr auto kFeedReadTimeout = TimeMs(1000);
 constexpr auto kStickersByEmojiInvalidateTimeout = TimeMs(60 * 60 * 1000);
 constexpr auto kNotifySettingSaveTimeout = TimeMs(1000);
+constexpr auto kPeersPerRequest = 100;
+constexpr auto kPeerRequestsInFlightLimit = 4;
 
 using SimpleFileLocationId = Data::SimpleFileLocationId;
 using DocumentFileLocationId = Data::DocumentFileLocationId;
@@ -80,6 +82,12 @@ bool IsSilentPost(not_null<HistoryItem*> item, bool silent) {
 		&& !history->peer->isMegagroup();
 }
 
+// Only the newest slice and the count are kept locally,
+// that is what Info shows first when it is opened.
+bool IsSharedMediaCacheSlice(MsgId messageId) {
+	return !messageId || (messageId >= ServerMaxMsgId - 1);
+}
+
 MTPVector<MTPDocumentAttribute> ComposeSendingDocumentAttributes(
 		not_null<DocumentData*> document) {
 	const auto filenameAttribute = MTP_documentAttributeFilename(
@@ -147,6 +155,8 @@ ApiWrap::MessageToSend::MessageToSend(not_null<History*> history)
 ApiWrap::ApiWrap(not_null<AuthSession*> session)
 : _session(session)
 , _messageDataResolveDelayed([=] { resolveMessageDatas(); })
+, _peerRequestsResolveDelayed([=] { resolvePeers(); })
+, _peerRequestsFloodTimer([=] { resolvePeers(); })
 , _webPagesTimer([=] { resolveWebPages(); })
 , _draftsSaveTimer([=] { saveDraftsToCloud(); })
 , _featuredSetsReadTimer([=] { readFeaturedSets(); })
@@ -959,55 +969,174 @@ void ApiWrap::gotUserFull(UserData *user, const MTPUserFull &result, mtpRequestI
 void ApiWrap::requestPeer(PeerData *peer) {
 	if (!peer || _fullPeerRequests.contains(peer) || _peerRequests.contains(peer)) return;
 
-	auto sendRequest = [this, peer] {
-		auto failHandler = [this, peer](const RPCError &error) {
-			_peerRequests.remove(peer);
-		};
-		auto chatHandler = [this, peer](const MTPmessages_Chats &result) {
-			_peerRequests.remove(peer);
-
-			if (auto chats = Api::getChatsFromMessagesChats(result)) {
-				auto &v = chats->v;
-				bool badVersion = false;
-				if (const auto chat = peer->asChat()) {
-					badVersion = !v.isEmpty()
-						&& (v[0].type() == mtpc_chat)
-						&& (v[0].c_chat().vversion.v < chat->version);
-				} else if (const auto channel = peer->asChannel()) {
-					badVersion = !v.isEmpty()
-						&& (v[0].type() == mtpc_channel)
-						&& (v[0].c_channel().vversion.v < channel->version);
-				}
-				auto chat = App::feedChats(*chats);
-				if (chat == peer) {
-					if (badVersion) {
-						if (auto chat = peer->asChat()) {
-							chat->version = v[0].c_chat().vversion.v;
-						} else if (auto channel = peer->asChannel()) {
-							channel->version = v[0].c_channel().vversion.v;
-						}
-						requestPeer(peer);
-					}
-				}
+	_peerRequests.insert(peer, mtpRequestId(0));
+	_peerRequestsPending.emplace(peer);
+	_peerRequestsResolveDelayed.call();
+}
+
+void ApiWrap::resolvePeers() {
+	if (_peerRequestsFloodTimer.isActive()) {
+		return;
+	}
+	auto users = std::vector<not_null<PeerData*>>();
+	auto chats = std::vector<not_null<PeerData*>>();
+	auto channels = std::vector<not_null<PeerData*>>();
+	for (const auto peer : _peerRequestsPending) {
+		if (peer->isUser()) {
+			users.push_back(peer);
+		} else if (peer->isChat()) {
+			chats.push_back(peer);
+		} else if (peer->isChannel()) {
+			channels.push_back(peer);
+		}
+	}
+	const auto takeBatch = [&](std::vector<not_null<PeerData*>> &list) {
+		const auto count = std::min(int(list.size()), kPeersPerRequest);
+		auto result = std::vector<not_null<PeerData*>>(
+			list.begin(),
+			list.begin() + count);
+		list.erase(list.begin(), list.begin() + count);
+		for (const auto peer : result) {
+			_peerRequestsPending.remove(peer);
+		}
+		return result;
+	};
+	while (_peerRequestsInFlight < kPeerRequestsInFlightLimit) {
+		if (!users.empty()) {
+			sendPeersRequest(takeBatch(users));
+		} else if (!chats.empty()) {
+			sendPeersRequest(takeBatch(chats));
+		} else if (!channels.empty()) {
+			sendPeersRequest(takeBatch(channels));
+		} else {
+			break;
+		}
+	}
+	DEBUG_LOG(("API: peer requests queued %1, in flight %2."
+		).arg(_peerRequestsPending.size()
+		).arg(_peerRequestsInFlight));
+}
+
+void ApiWrap::sendPeersRequest(std::vector<not_null<PeerData*>> &&peers) {
+	Expects(!peers.empty());
+
+	const auto failHandler = [=](
+			const RPCError &error,
+			mtpRequestId requestId) {
+		finishPeersRequest(peers, requestId);
+		if (!MTP::isFloodError(error)) {
+			return;
+		}
+		for (const auto peer : peers) {
+			if (!_peerRequests.contains(peer)
+				&& !_fullPeerRequests.contains(peer)) {
+				_peerRequests.insert(peer, mtpRequestId(0));
+				_peerRequestsPending.emplace(peer);
 			}
-		};
-		if (auto user = peer->asUser()) {
-			return request(MTPusers_GetUsers(MTP_vector<MTPInputUser>(1, user->inputUser))).done([this, user](const MTPVector<MTPUser> &result) {
-				_peerRequests.remove(user);
+		}
+		const auto seconds = error.type().mid(
+			qstr("FLOOD_WAIT_").size()).toInt();
+		_peerRequestsFloodTimer.callOnce(std::max(seconds, 1) * TimeMs(1000));
+	};
+	const auto requestId = [&] {
+		if (peers.front()->isUser()) {
+			auto inputs = QVector<MTPInputUser>();
+			inputs.reserve(peers.size());
+			for (const auto peer : peers) {
+				inputs.push_back(peer->asUser()->inputUser);
+			}
+			return request(MTPusers_GetUsers(
+				MTP_vector<MTPInputUser>(inputs)
+			)).done([=](
+					const MTPVector<MTPUser> &result,
+					mtpRequestId requestId) {
+				finishPeersRequest(peers, requestId);
 				App::feedUsers(result);
 			}).fail(failHandler).send();
-		} else if (auto chat = peer->asChat()) {
-			return request(MTPmessages_GetChats(MTP_vector<MTPint>(1, chat->inputChat))).done(chatHandler).fail(failHandler).send();
-		} else if (auto channel = peer->asChannel()) {
-			return request(MTPchannels_GetChannels(MTP_vector<MTPInputChannel>(1, channel->inputChannel))).done(chatHandler).fail(failHandler).send();
+		} else if (peers.front()->isChat()) {
+			auto inputs = QVector<MTPint>();
+			inputs.reserve(peers.size());
+			for (const auto peer : peers) {
+				inputs.push_back(peer->asChat()->inputChat);
+			}
+			return request(MTPmessages_GetChats(
+				MTP_vector<MTPint>(inputs)
+			)).done([=](
+					const MTPmessages_Chats &result,
+					mtpRequestId requestId) {
+				finishPeersRequest(peers, requestId);
+				gotPeersChats(result);
+			}).fail(failHandler).send();
 		}
-		return 0;
-	};
-	if (auto requestId = sendRequest()) {
+		auto inputs = QVector<MTPInputChannel>();
+		inputs.reserve(peers.size());
+		for (const auto peer : peers) {
+			inputs.push_back(peer->asChannel()->inputChannel);
+		}
+		return request(MTPchannels_GetChannels(
+			MTP_vector<MTPInputChannel>(inputs)
+		)).done([=](
+				const MTPmessages_Chats &result,
+				mtpRequestId requestId) {
+			finishPeersRequest(peers, requestId);
+			gotPeersChats(result);
+		}).fail(failHandler).send();
+	}();
+	++_peerRequestsInFlight;
+	for (const auto peer : peers) {
 		_peerRequests.insert(peer, requestId);
 	}
 }
 
+void ApiWrap::finishPeersRequest(
+		const std::vector<not_null<PeerData*>> &peers,
+		mtpRequestId requestId) {
+	--_peerRequestsInFlight;
+	for (const auto peer : peers) {
+		const auto i = _peerRequests.find(peer);
+		if (i != _peerRequests.end() && i.value() == requestId) {
+			_peerRequests.erase(i);
+		}
+	}
+	if (!_peerRequestsPending.empty()) {
+		_peerRequestsResolveDelayed.call();
+	}
+}
+
+void ApiWrap::gotPeersChats(const MTPmessages_Chats &result) {
+	const auto chats = Api::getChatsFromMessagesChats(result);
+	if (!chats) {
+		return;
+	}
+
+	// If the server version is older than ours, take it and ask again.
+	auto outdated = std::vector<std::pair<not_null<PeerData*>, int>>();
+	for (const auto &chat : chats->v) {
+		if (chat.type() == mtpc_chat) {
+			const auto &data = chat.c_chat();
+			const auto peer = App::chatLoaded(data.vid.v);
+			if (peer && data.vversion.v < peer->version) {
+				outdated.push_back({ peer, data.vversion.v });
+			}
+		} else if (chat.type() == mtpc_channel) {
+			const auto &data = chat.c_channel();
+			const auto peer = App::channelLoaded(data.vid.v);
+			if (peer && data.vversion.v < peer->version) {
+				outdated.push_back({ peer, data.vversion.v });
+			}
+		}
+	}
+	App::feedChats(*chats);
+	for (const auto [peer, version] : outdated) {
+		if (const auto chat = peer->asChat()) {
+			chat->version = version;
+		} else if (const auto channel = peer->asChannel()) {
+			channel->version = version;
+		}
+		requestPeer(peer);
+	}
+}
+
 void ApiWrap::markMediaRead(
 		const base::flat_set<not_null<HistoryItem*>> &items) {
 	auto markedIds = QVector<MTPint>();
@@ -1068,37 +1197,8 @@ void ApiWrap::markMediaRead(not_null<HistoryItem*> item) {
 }
 
 void ApiWrap::requestPeers(const QList<PeerData*> &peers) {
-	QVector<MTPint> chats;
-	QVector<MTPInputChannel> channels;
-	QVector<MTPInputUser> users;
-	chats.reserve(peers.size());
-	channels.reserve(peers.size());
-	users.reserve(peers.size());
-	for (QList<PeerData*>::const_iterator i = peers.cbegin(), e = peers.cend(); i != e; ++i) {
-		if (!*i || _fullPeerRequests.contains(*i) || _peerRequests.contains(*i)) continue;
-		if ((*i)->isUser()) {
-			users.push_back((*i)->asUser()->inputUser);
-		} else if ((*i)->isChat()) {
-			chats.push_back((*i)->asChat()->inputChat);
-		} else if ((*i)->isChannel()) {
-			channels.push_back((*i)->asChannel()->inputChannel);
-		}
-	}
-	auto handleChats = [=](const MTPmessages_Chats &result) {
-		if (auto chats = Api::getChatsFromMessagesChats(result)) {
-			App::feedChats(*chats);
-		}
-	};
-	if (!chats.isEmpty()) {
-		request(MTPmessages_GetChats(MTP_vector<MTPint>(chats))).done(handleChats).send();
-	}
-	if (!channels.isEmpty()) {
-		request(MTPchannels_GetChannels(MTP_vector<MTPInputChannel>(channels))).done(handleChats).send();
-	}
-	if (!users.isEmpty()) {
-		request(MTPusers_GetUsers(MTP_vector<MTPInputUser>(users))).done([=](const MTPVector<MTPUser> &result) {
-			App::feedUsers(result);
-		}).send();
+	for (const auto peer : peers) {
+		requestPeer(peer);
 	}
 }
 
@@ -3478,6 +3578,10 @@ void ApiWrap::requestSharedMedia(
 		SharedMediaType type,
 		MsgId messageId,
 		SliceType slice) {
+	if (!_sharedMediaCache.contains(peer)) {
+		applySharedMediaCache(peer);
+	}
+
 	auto key = std::make_tuple(peer, type, messageId, slice);
 	if (_sharedMediaRequests.contains(key)) {
 		return;
@@ -3518,6 +3622,21 @@ void ApiWrap::sharedMediaDone(
 		messageId,
 		slice,
 		result);
+	reconcileSharedMediaCache(
+		peer,
+		type,
+		parsed.messageIds,
+		parsed.noSkipRange);
+	if (IsSharedMediaCacheSlice(messageId)) {
+		storeSharedMediaCache(
+			peer,
+			type,
+			messageId,
+			slice,
+			parsed.messageIds,
+			parsed.noSkipRange,
+			parsed.fullCount);
+	}
 	_session->storage().add(Storage::SharedMediaAddSlice(
 		peer->id,
 		type,
@@ -3527,6 +3646,118 @@ void ApiWrap::sharedMediaDone(
 	));
 }
 
+void ApiWrap::applySharedMediaCache(not_null<PeerData*> peer) {
+	auto &slices = _sharedMediaCache[peer];
+	const auto channel = peerToChannel(peer->id);
+	for (auto &slice : Local::readSharedMedia(peer->id)) {
+		if (!Storage::IsValidSharedMediaType(slice.type)
+			|| !IsSharedMediaCacheSlice(slice.messageId)) {
+			continue;
+		}
+
+		// Only the ids of the messages are stored, not the messages,
+		// so that nothing stale or deleted is brought back. Messages
+		// loaded in this session are shown right away, and the covered
+		// range ends before the newest id that is not loaded yet.
+		// Everything else is shown when the server answers.
+		auto ids = slice.messageIds;
+		ranges::sort(ids, std::greater<>());
+		auto noSkipRange = slice.noSkipRange;
+		const auto missing = ranges::find_if(ids, [&](MsgId messageId) {
+			return !App::histItemById(channel, messageId);
+		});
+		if (missing != ids.end()) {
+			noSkipRange = (*missing < noSkipRange.till)
+				? MsgRange(*missing + 1, noSkipRange.till)
+				: MsgRange();
+			ids.erase(missing, ids.end());
+		}
+		auto &cached = _sharedMediaCachedIds[{ peer, slice.type }];
+		for (const auto messageId : ids) {
+			cached.emplace(messageId);
+		}
+		_session->storage().add(Storage::SharedMediaAddSlice(
+			peer->id,
+			slice.type,
+			std::move(ids),
+			noSkipRange,
+			slice.fullCount
+		));
+		slices.push_back(std::move(slice));
+	}
+
+	// Refresh everything that was shown from the local cache.
+	const auto refresh = slices;
+	for (const auto &slice : refresh) {
+		requestSharedMedia(
+			peer,
+			slice.type,
+			slice.messageId,
+			slice.direction);
+	}
+}
+
+void ApiWrap::storeSharedMediaCache(
+		not_null<PeerData*> peer,
+		SharedMediaType type,
+		MsgId messageId,
+		SliceType slice,
+		const std::vector<MsgId> &messageIds,
+		MsgRange noSkipRange,
+		int fullCount) {
+	auto &slices = _sharedMediaCache[peer];
+	const auto i = ranges::find_if(slices, [&](
+			const Local::SharedMediaSlice &existing) {
+		return (existing.type == type)
+			&& (existing.messageId == messageId)
+			&& (existing.direction == slice);
+	});
+	if (i != slices.end()) {
+		i->messageIds = messageIds;
+		i->noSkipRange = noSkipRange;
+		i->fullCount = fullCount;
+	} else {
+		slices.push_back({
+			type,
+			messageId,
+			slice,
+			messageIds,
+			noSkipRange,
+			fullCount });
+	}
+	Local::writeSharedMedia(peer->id, slices);
+}
+
+void ApiWrap::reconcileSharedMediaCache(
+		not_null<PeerData*> peer,
+		SharedMediaType type,
+		const std::vector<MsgId> &messageIds,
+		MsgRange noSkipRange) {
+	const auto i = _sharedMediaCachedIds.find({ peer, type });
+	if (i == _sharedMediaCachedIds.end()) {
+		return;
+	}
+	auto &cached = i->second;
+	for (auto j = cached.begin(); j != cached.end();) {
+		const auto messageId = *j;
+		if (messageId < noSkipRange.from || messageId > noSkipRange.till) {
+			++j;
+			continue;
+		}
+		j = cached.erase(j);
+		if (ranges::find(messageIds, messageId) == messageIds.end()) {
+			// Deleted or edited to have no such media while we were away.
+			_session->storage().remove(Storage::SharedMediaRemoveOne(
+				peer->id,
+				type,
+				messageId));
+		}
+	}
+	if (cached.empty()) {
+		_sharedMediaCachedIds.erase(i);
+	}
+}
+
 void ApiWrap::requestUserPhotos(
 		not_null<UserData*> user,
 		PhotoId afterId) {
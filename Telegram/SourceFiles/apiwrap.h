@@ -37,6 +37,10 @@ namespace Dialogs {
 class Key;
 } // namespace Dialogs
 
+namespace Local {
+struct SharedMediaSlice;
+} // namespace Local
+
 namespace Api {
 
 inline const MTPVector<MTPChat> *getChatsFromMessagesChats(const MTPmessages_Chats &chats) {
@@ -362,6 +366,13 @@ private:
 		not_null<Data::Feed*> feed,
 		const MTPmessages_Dialogs &dialogs);
 
+	void resolvePeers();
+	void sendPeersRequest(std::vector<not_null<PeerData*>> &&peers);
+	void finishPeersRequest(
+		const std::vector<not_null<PeerData*>> &peers,
+		mtpRequestId requestId);
+	void gotPeersChats(const MTPmessages_Chats &result);
+
 	void gotChatFull(PeerData *peer, const MTPmessages_ChatFull &result, mtpRequestId req);
 	void gotUserFull(UserData *user, const MTPUserFull &result, mtpRequestId req);
 	void applyLastParticipantsList(
@@ -433,6 +444,20 @@ private:
 		MsgId messageId,
 		SliceType slice,
 		const MTPmessages_Messages &result);
+	void applySharedMediaCache(not_null<PeerData*> peer);
+	void storeSharedMediaCache(
+		not_null<PeerData*> peer,
+		SharedMediaType type,
+		MsgId messageId,
+		SliceType slice,
+		const std::vector<MsgId> &messageIds,
+		MsgRange noSkipRange,
+		int fullCount);
+	void reconcileSharedMediaCache(
+		not_null<PeerData*> peer,
+		SharedMediaType type,
+		const std::vector<MsgId> &messageIds,
+		MsgRange noSkipRange);
 
 	void userPhotosDone(
 		not_null<UserData*> user,
@@ -513,6 +538,13 @@ private:
 	PeerRequests _fullPeerRequests;
 	PeerRequests _peerRequests;
 
+	// Peers are collected during an event loop tick and requested in
+	// batches, with a limited number of batches sent at the same time.
+	base::flat_set<not_null<PeerData*>> _peerRequestsPending;
+	SingleQueuedInvokation _peerRequestsResolveDelayed;
+	base::Timer _peerRequestsFloodTimer;
+	int _peerRequestsInFlight = 0;
+
 	PeerRequests _participantsRequests;
 	PeerRequests _botsRequests;
 	PeerRequests _adminsRequests;
@@ -590,6 +622,15 @@ private:
 		MsgId,
 		SliceType>, mtpRequestId> _sharedMediaRequests;
 
+	// Top slices stored locally, loaded on the first request for a peer.
+	// Ids shown from them are checked against the server results.
+	base::flat_map<
+		not_null<PeerData*>,
+		std::vector<Local::SharedMediaSlice>> _sharedMediaCache;
+	base::flat_map<
+		std::pair<not_null<PeerData*>, SharedMediaType>,
+		base::flat_set<MsgId>> _sharedMediaCachedIds;
+
 	base::flat_map<not_null<UserData*>, mtpRequestId> _userPhotosRequests;
 
 	base::flat_set<not_null<Data::Feed*>> _feedChannelsGetRequests;
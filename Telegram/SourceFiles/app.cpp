@@ -79,7 +79,6 @@ namespace {
 		*pressedLinkItem = nullptr,
 		*mousedItem = nullptr;
 
-	QPixmap *emoji = nullptr, *emojiLarge = nullptr;
 	style::font monofont;
 
 	struct CornersPixmaps {
@@ -1448,14 +1447,6 @@ namespace App {
 			::monofont = style::font(st::normalFont->f.pixelSize(), 0, family);
 		}
 		Ui::Emoji::Init();
-		if (!::emoji) {
-			::emoji = new QPixmap(Ui::Emoji::Filename(Ui::Emoji::Index()));
-            if (cRetina()) ::emoji->setDevicePixelRatio(cRetinaFactor());
-		}
-		if (!::emojiLarge) {
-			::emojiLarge = new QPixmap(Ui::Emoji::Filename(Ui::Emoji::Index() + 1));
-			if (cRetina()) ::emojiLarge->setDevicePixelRatio(cRetinaFactor());
-		}
 
 		createCorners();
 
@@ -1498,10 +1489,7 @@ namespace App {
 	}
 
 	void deinitMedia() {
-		delete ::emoji;
-		::emoji = nullptr;
-		delete ::emojiLarge;
-		::emojiLarge = nullptr;
+		Ui::Emoji::Clear();
 
 		clearCorners();
 
@@ -1565,14 +1553,6 @@ namespace App {
 		return ::monofont;
 	}
 
-	const QPixmap &emoji() {
-		return *::emoji;
-	}
-
-	const QPixmap &emojiLarge() {
-		return *::emojiLarge;
-	}
-
 	const QPixmap &emojiSingle(EmojiPtr emoji, int32 fontHeight) {
 		auto &map = (fontHeight == st::msgFont->height) ? MainEmojiMap : OtherEmojiMap[fontHeight];
 		auto i = map.constFind(emoji->index());
@@ -1594,6 +1574,7 @@ namespace App {
 		if (nowImageCacheSize > serviceImageCacheSize + MemoryForImageCache) {
 			App::forgetMedia();
 			Auth().data().forgetMedia();
+			Ui::Emoji::ClearIrrelevantCache();
 			serviceImageCacheSize = imageCacheSize();
 		}
 	}
@@ -1620,6 +1601,7 @@ namespace App {
 		}
 		if (auto mainwidget = main()) {
 			mainwidget->saveDraftToCloud();
+			Local::writeDialogsSnapshot();
 		}
 		Messenger::QuitAttempt();
 	}
@@ -14,6 +14,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/file_upload.h"
 #include "storage/localstorage.h"
 #include "storage/storage_facade.h"
+#include "storage/storage_search_index.h"
 #include "storage/serialize_common.h"
 #include "data/data_session.h"
 #include "window/notifications_manager.h"
@@ -314,6 +315,7 @@ AuthSession::AuthSession(UserId userId)
 , _downloader(std::make_unique<Storage::Downloader>())
 , _uploader(std::make_unique<Storage::Uploader>())
 , _storage(std::make_unique<Storage::Facade>())
+, _searchIndex(std::make_unique<Storage::SearchIndex>())
 , _notifications(std::make_unique<Window::Notifications::System>(this))
 , _data(std::make_unique<Data::Session>(this))
 , _changelogs(Core::Changelogs::Create(this)) {
@@ -23,6 +23,7 @@ namespace Storage {
 class Downloader;
 class Uploader;
 class Facade;
+class SearchIndex;
 } // namespace Storage
 
 namespace Window {
@@ -224,6 +225,9 @@ public:
 	Storage::Facade &storage() {
 		return *_storage;
 	}
+	Storage::SearchIndex &searchIndex() {
+		return *_searchIndex;
+	}
 
 	base::Observable<void> &downloaderTaskFinished();
 
@@ -270,6 +274,7 @@ private:
 	const std::unique_ptr<Storage::Downloader> _downloader;
 	const std::unique_ptr<Storage::Uploader> _uploader;
 	const std::unique_ptr<Storage::Facade> _storage;
+	const std::unique_ptr<Storage::SearchIndex> _searchIndex;
 	const std::unique_ptr<Window::Notifications::System> _notifications;
 
 	// _data depends on _downloader / _uploader, including destructor.
@@ -8,6 +8,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "catch.hpp"
 
 #include "base/flat_map.h"
+#include <chrono>
+#include <cstdint>
 #include <string>
 
 struct int_wrap {
@@ -70,3 +72,40 @@ TEST_CASE("flat_maps custom comparator", "[flat_map]") {
 		checkSorted();
 	}
 }
+
+TEST_CASE("flat_maps keep a sliding window of message ids", "[flat_map][benchmark]") {
+	// Same access pattern as MTP::internal::ReceivedMsgIds has.
+	constexpr auto kCount = 1000000;
+	constexpr auto kWindow = 400;
+
+	base::flat_map<uint64_t, bool> ids;
+	auto registered = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (auto i = 0; i != kCount; ++i) {
+		// Every 16th id comes out of order, every 64th is a duplicate.
+		auto id = uint64_t(i) * 4 + 1000;
+		if (i % 16 == 15) {
+			id -= 30;
+		} else if (i % 64 == 0 && i > 0) {
+			id -= 8;
+		}
+		if (ids.contains(id)) {
+			continue;
+		} else if (ids.size() < kWindow || id > ids.front().first) {
+			ids.emplace(id, (i % 2) != 0);
+			++registered;
+		}
+		if (ids.size() > kWindow) {
+			ids.erase(ids.begin(), ids.begin() + (ids.size() - kWindow));
+		}
+	}
+	const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	WARN("Registered " << kCount << " message ids in " << elapsed << "us.");
+
+	REQUIRE(registered == kCount - (kCount - 1) / 64);
+	REQUIRE(ids.size() == kWindow);
+	for (auto i = ids.begin() + 1; i != ids.end(); ++i) {
+		REQUIRE((i - 1)->first < i->first);
+	}
+}
@@ -0,0 +1,86 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace base {
+
+// Unbounded lock-free queue with many producers and a single consumer.
+//
+// push() may be called from any thread, it does one allocation and one
+// atomic exchange and never waits for other producers or the consumer.
+// try_pop() and empty() may be called only from the consumer thread.
+//
+// A pushed value may become visible to the consumer a bit later than push()
+// returns, while some other producer is in the middle of its own push(),
+// so every producer should notify the consumer after pushing.
+// Values pushed by one producer are popped in the push order.
+template <typename Type>
+class mpsc_queue {
+public:
+	mpsc_queue() : _head(new node()), _tail(_head.load()) {
+	}
+	mpsc_queue(const mpsc_queue &other) = delete;
+	mpsc_queue &operator=(const mpsc_queue &other) = delete;
+	~mpsc_queue() {
+		while (auto next = _tail->next.load(std::memory_order_acquire)) {
+			delete _tail;
+			_tail = next;
+		}
+		delete _tail;
+	}
+
+	// Returns the approximate queue size including the pushed value.
+	int push(Type &&value) {
+		const auto added = new node(std::move(value));
+		const auto result = _size.fetch_add(1, std::memory_order_relaxed) + 1;
+		const auto previous = _head.exchange(added, std::memory_order_acq_rel);
+		previous->next.store(added, std::memory_order_release);
+		return result;
+	}
+
+	bool try_pop(Type &result) {
+		const auto next = _tail->next.load(std::memory_order_acquire);
+		if (!next) {
+			return false;
+		}
+		delete _tail;
+		_tail = next;
+		_size.fetch_sub(1, std::memory_order_relaxed);
+		result = std::move(next->value);
+		return true;
+	}
+
+	bool empty() const {
+		return !_tail->next.load(std::memory_order_acquire);
+	}
+
+	// May be called from any thread, the result may be already outdated.
+	int size() const {
+		return _size.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct node {
+		node() = default;
+		explicit node(Type &&value) : value(std::move(value)) {
+		}
+
+		std::atomic<node*> next = { nullptr };
+		Type value = Type();
+	};
+
+	std::atomic<node*> _head; // Last pushed node, used by producers.
+	node *_tail = nullptr; // Already popped node, used by the consumer.
+	std::atomic<int> _size = { 0 };
+
+};
+
+} // namespace base
@@ -0,0 +1,85 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "base/mpsc_queue.h"
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST_CASE("mpsc queue pops values in the push order", "[mpsc_queue]") {
+	base::mpsc_queue<int> queue;
+	REQUIRE(queue.empty());
+	REQUIRE(queue.size() == 0);
+
+	REQUIRE(queue.push(1) == 1);
+	REQUIRE(queue.push(2) == 2);
+	REQUIRE(queue.push(3) == 3);
+	REQUIRE(!queue.empty());
+
+	auto value = 0;
+	REQUIRE(queue.try_pop(value));
+	REQUIRE(value == 1);
+	REQUIRE(queue.size() == 2);
+	REQUIRE(queue.try_pop(value));
+	REQUIRE(value == 2);
+	REQUIRE(queue.try_pop(value));
+	REQUIRE(value == 3);
+	REQUIRE(!queue.try_pop(value));
+	REQUIRE(value == 3);
+	REQUIRE(queue.empty());
+}
+
+TEST_CASE("mpsc queue destroys values left in it", "[mpsc_queue]") {
+	auto alive = std::make_shared<int>(0);
+	{
+		base::mpsc_queue<std::shared_ptr<int>> queue;
+		queue.push(std::shared_ptr<int>(alive));
+		queue.push(std::shared_ptr<int>(alive));
+
+		auto popped = std::shared_ptr<int>();
+		REQUIRE(queue.try_pop(popped));
+		REQUIRE(alive.use_count() == 3);
+	}
+	REQUIRE(alive.use_count() == 1);
+}
+
+TEST_CASE("mpsc queue keeps every producer order", "[mpsc_queue]") {
+	constexpr auto kProducers = 4;
+	constexpr auto kValues = 100000;
+
+	base::mpsc_queue<std::pair<int, int>> queue;
+	auto producers = std::vector<std::thread>();
+	for (auto producer = 0; producer != kProducers; ++producer) {
+		producers.emplace_back([&queue, producer] {
+			for (auto i = 0; i != kValues; ++i) {
+				queue.push({ producer, i });
+			}
+		});
+	}
+
+	auto next = std::vector<int>(kProducers, 0);
+	auto received = 0;
+	auto ordered = true;
+	auto value = std::pair<int, int>();
+	while (received != kProducers * kValues) {
+		if (!queue.try_pop(value)) {
+			std::this_thread::yield();
+			continue;
+		}
+		ordered = ordered && (value.second == next[value.first]);
+		next[value.first] = value.second + 1;
+		++received;
+	}
+	for (auto &producer : producers) {
+		producer.join();
+	}
+	REQUIRE(ordered);
+	REQUIRE(queue.empty());
+	REQUIRE(queue.size() == 0);
+}
@@ -7,16 +7,161 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "base/timer.h"
 
+#include <QtCore/QThreadStorage>
+#include <atomic>
+
 namespace base {
 namespace {
 
+constexpr auto kDefaultCoarseSlack = 5;
+constexpr auto kVeryCoarseAlign = TimeMs(1000);
+
+std::atomic<int> CoarseSlack = { kDefaultCoarseSlack };
+
 QObject *TimersAdjuster() {
 	static QObject adjuster;
 	return &adjuster;
 }
 
+TimeMs AlignedExpiration(TimeMs when, TimeMs timeout, Qt::TimerType type) {
+	if (type == Qt::PreciseTimer) {
+		return when;
+	} else if (type == Qt::VeryCoarseTimer) {
+		return ((when + kVeryCoarseAlign - 1) / kVeryCoarseAlign)
+			* kVeryCoarseAlign;
+	}
+	const auto slack = (timeout * CoarseSlack.load()) / 100;
+	if (slack < 2) {
+		return when;
+	}
+
+	// Round up to the largest power of two not exceeding the slack,
+	// so that the coarse timers with close timeouts share the wakeup.
+	auto align = TimeMs(1);
+	while (align * 2 <= slack) {
+		align *= 2;
+	}
+	return (when + align - 1) & ~(align - 1);
+}
+
 } // namespace
 
+namespace details {
+
+class TimersManager final : public QObject {
+public:
+	using Wheel = timer_wheel<TimerTarget>;
+
+	TimersManager();
+
+	static TimersManager *Instance();
+
+	void schedule(not_null<Wheel::entry*> entry, TimeMs when);
+	void unschedule(not_null<Wheel::entry*> entry);
+
+protected:
+	void timerEvent(QTimerEvent *e) override;
+
+private:
+	void reschedule();
+	void adjust();
+
+	Wheel _wheel;
+	int _timerId = 0;
+	TimeMs _timerAt = 0;
+
+};
+
+TimersManager::TimersManager() : _wheel(getms(true)) {
+	connect(
+		TimersAdjuster(),
+		&QObject::destroyed,
+		this,
+		[this] { adjust(); },
+		Qt::QueuedConnection);
+}
+
+TimersManager *TimersManager::Instance() {
+	static QThreadStorage<TimersManager*> Managers;
+	if (!Managers.hasLocalData()) {
+		Managers.setLocalData(new TimersManager());
+	}
+	return Managers.localData();
+}
+
+void TimersManager::schedule(not_null<Wheel::entry*> entry, TimeMs when) {
+	_wheel.insert(entry, when);
+	reschedule();
+}
+
+void TimersManager::unschedule(not_null<Wheel::entry*> entry) {
+	// The system timer is left as is, it will just find nothing to fire.
+	_wheel.remove(entry);
+}
+
+void TimersManager::reschedule() {
+	const auto next = _wheel.next_expiration();
+	if (next < 0) {
+		if (_timerId) {
+			killTimer(base::take(_timerId));
+		}
+		return;
+	} else if (_timerId && _timerAt <= next) {
+		// Removed entries are not tracked, waking up earlier is fine.
+		return;
+	}
+	if (_timerId) {
+		killTimer(base::take(_timerId));
+	}
+	const auto now = getms(true);
+	const auto timeout = (next > now) ? (next - now) : TimeMs(0);
+	_timerId = startTimer(
+		int(std::min(timeout, TimeMs(std::numeric_limits<int>::max()))),
+		Qt::PreciseTimer);
+	_timerAt = next;
+}
+
+void TimersManager::adjust() {
+	if (_timerId) {
+		killTimer(base::take(_timerId));
+	}
+	reschedule();
+}
+
+void TimersManager::timerEvent(QTimerEvent *e) {
+	if (e->timerId() != _timerId) {
+		killTimer(e->timerId());
+		return;
+	}
+	killTimer(base::take(_timerId));
+
+	_wheel.advance(getms(true));
+	while (const auto target = _wheel.take_expired()) {
+		target->timerFired();
+	}
+	reschedule();
+}
+
+TimerTarget::TimerTarget() : _entry(this) {
+}
+
+TimeMs TimerTarget::schedule(TimeMs timeout, Qt::TimerType type) {
+	const auto when = AlignedExpiration(
+		getms(true) + timeout,
+		timeout,
+		type);
+	TimersManager::Instance()->schedule(&_entry, when);
+	return when;
+}
+
+void TimerTarget::unschedule() {
+	if (scheduled()) {
+		TimersManager::Instance()->unschedule(&_entry);
+	}
+}
+
+} // namespace details
+
 Timer::Timer(
 	not_null<QThread*> thread,
 	Fn<void()> callback)
@@ -28,15 +173,8 @@ Timer::Timer(
 Timer::Timer(Fn<void()> callback)
 : QObject(nullptr)
 , _callback(std::move(callback))
-, _type(Qt::PreciseTimer)
-, _adjusted(false) {
+, _type(Qt::PreciseTimer) {
 	setRepeat(Repeat::Interval);
-	connect(
-		TimersAdjuster(),
-		&QObject::destroyed,
-		this,
-		[this] { adjust(); },
-		Qt::QueuedConnection);
 }
 
 void Timer::start(TimeMs timeout, Qt::TimerType type, Repeat repeat) {
@@ -44,20 +182,12 @@ void Timer::start(TimeMs timeout, Qt::TimerType type, Repeat repeat) {
 
 	_type = type;
 	setRepeat(repeat);
-	_adjusted = false;
 	setTimeout(timeout);
-	_timerId = startTimer(_timeout, _type);
-	if (_timerId) {
-		_next = getms(true) + _timeout;
-	} else {
-		_next = 0;
-	}
+	_next = schedule(_timeout, _type);
 }
 
 void Timer::cancel() {
-	if (isActive()) {
-		killTimer(base::take(_timerId));
-	}
+	unschedule();
 }
 
 TimeMs Timer::remainingTime() const {
@@ -77,13 +207,10 @@ void Timer::Adjust() {
 		&QObject::destroyed);
 }
 
-void Timer::adjust() {
-	auto remaining = remainingTime();
-	if (remaining >= 0) {
-		cancel();
-		_timerId = startTimer(remaining, _type);
-		_adjusted = true;
-	}
+void Timer::SetCoarseSlack(int percent) {
+	Expects(percent >= 0 && percent <= 100);
+
+	CoarseSlack = percent;
 }
 
 void Timer::setTimeout(TimeMs timeout) {
@@ -96,15 +223,9 @@ int Timer::timeout() const {
 	return _timeout;
 }
 
-void Timer::timerEvent(QTimerEvent *e) {
+void Timer::timerFired() {
 	if (repeat() == Repeat::Interval) {
-		if (_adjusted) {
-			start(_timeout, _type, repeat());
-		} else {
-			_next = getms(true) + _timeout;
-		}
-	} else {
-		cancel();
+		_next = schedule(_timeout, _type);
 	}
 
 	if (_callback) {
@@ -112,6 +233,40 @@ void Timer::timerEvent(QTimerEvent *e) {
 	}
 }
 
+class DelayedCallTimer::Call final : public details::TimerTarget {
+public:
+	Call(
+		not_null<DelayedCallTimer*> owner,
+		int id,
+		FnMut<void()> callback)
+	: _owner(owner)
+	, _id(id)
+	, _callback(std::move(callback)) {
+	}
+
+	void start(TimeMs timeout, Qt::TimerType type) {
+		schedule(timeout, type);
+	}
+	FnMut<void()> takeCallback() {
+		return std::move(_callback);
+	}
+
+	void timerFired() override {
+		// This call is destroyed by the owner, don't touch it after.
+		_owner->fired(_id);
+	}
+
+private:
+	not_null<DelayedCallTimer*> _owner;
+	int _id = 0;
+	FnMut<void()> _callback;
+
+};
+
+DelayedCallTimer::DelayedCallTimer() = default;
+
+DelayedCallTimer::~DelayedCallTimer() = default;
+
 int DelayedCallTimer::call(
 		TimeMs timeout,
 		FnMut<void()> callback,
@@ -121,28 +276,31 @@ int DelayedCallTimer::call(
 	if (!callback) {
 		return 0;
 	}
-	auto timerId = startTimer(static_cast<int>(timeout), type);
-	if (timerId) {
-		_callbacks.emplace(timerId, std::move(callback));
-	}
-	return timerId;
+	do {
+		if (++_lastCallId <= 0) {
+			_lastCallId = 1;
+		}
+	} while (_calls.contains(_lastCallId));
+
+	const auto callId = _lastCallId;
+	const auto i = _calls.emplace(
+		callId,
+		std::make_unique<Call>(this, callId, std::move(callback))).first;
+	i->second->start(timeout, type);
+	return callId;
 }
 
 void DelayedCallTimer::cancel(int callId) {
 	if (callId) {
-		killTimer(callId);
-		_callbacks.remove(callId);
+		_calls.remove(callId);
 	}
 }
 
-void DelayedCallTimer::timerEvent(QTimerEvent *e) {
-	auto timerId = e->timerId();
-	killTimer(timerId);
-
-	auto it = _callbacks.find(timerId);
-	if (it != _callbacks.end()) {
-		auto callback = std::move(it->second);
-		_callbacks.erase(it);
+void DelayedCallTimer::fired(int callId) {
+	const auto i = _calls.find(callId);
+	if (i != _calls.end()) {
+		auto callback = i->second->takeCallback();
+		_calls.erase(i);
 
 		callback();
 	}
@@ -11,10 +11,42 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include <QtCore/QThread>
 #include "base/observer.h"
 #include "base/flat_map.h"
+#include "base/timer_wheel.h"
 
 namespace base {
+namespace details {
 
-class Timer final : private QObject {
+class TimersManager;
+
+// All timers of a thread are kept in one wheel of the TimersManager
+// which holds a single system timer for the nearest expiration.
+class TimerTarget {
+public:
+	TimerTarget();
+	TimerTarget(const TimerTarget &other) = delete;
+	TimerTarget &operator=(const TimerTarget &other) = delete;
+	virtual ~TimerTarget() = default;
+
+	virtual void timerFired() = 0;
+
+protected:
+	// Returns the time when the target will be fired.
+	TimeMs schedule(TimeMs timeout, Qt::TimerType type);
+	void unschedule();
+	bool scheduled() const {
+		return _entry.linked();
+	}
+
+private:
+	friend class TimersManager;
+
+	timer_wheel<TimerTarget>::entry _entry;
+
+};
+
+} // namespace details
+
+class Timer final : private QObject, private details::TimerTarget {
 public:
 	explicit Timer(
 		not_null<QThread*> thread,
@@ -47,7 +79,7 @@ public:
 	}
 
 	bool isActive() const {
-		return (_timerId != 0);
+		return scheduled();
 	}
 
 	void cancel();
@@ -55,8 +87,9 @@ public:
 
 	static void Adjust();
 
-protected:
-	void timerEvent(QTimerEvent *e) override;
+	// Coarse timers may be delayed by up to this percent of their
+	// timeout so that the nearby ones are fired in a single wakeup.
+	static void SetCoarseSlack(int percent);
 
 private:
 	enum class Repeat : unsigned {
@@ -64,7 +97,7 @@ private:
 		SingleShot = 1,
 	};
 	void start(TimeMs timeout, Qt::TimerType type, Repeat repeat);
-	void adjust();
+	void timerFired() override;
 
 	void setTimeout(TimeMs timeout);
 	int timeout() const;
@@ -79,16 +112,19 @@ private:
 	Fn<void()> _callback;
 	TimeMs _next = 0;
 	int _timeout = 0;
-	int _timerId = 0;
 
 	Qt::TimerType _type : 2;
-	bool _adjusted : 1;
 	unsigned _repeat : 1;
 
 };
 
-class DelayedCallTimer final : private QObject {
+class DelayedCallTimer final {
 public:
+	DelayedCallTimer();
+	DelayedCallTimer(const DelayedCallTimer &other) = delete;
+	DelayedCallTimer &operator=(const DelayedCallTimer &other) = delete;
+	~DelayedCallTimer();
+
 	int call(TimeMs timeout, FnMut<void()> callback) {
 		return call(
 			timeout,
@@ -102,11 +138,13 @@ public:
 		Qt::TimerType type);
 	void cancel(int callId);
 
-protected:
-	void timerEvent(QTimerEvent *e) override;
-
 private:
-	base::flat_map<int, FnMut<void()>> _callbacks;
+	class Call;
+
+	void fired(int callId);
+
+	base::flat_map<int, std::unique_ptr<Call>> _calls;
+	int _lastCallId = 0;
 
 };
 
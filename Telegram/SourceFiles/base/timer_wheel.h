@@ -0,0 +1,311 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace base {
+
+// Hierarchical timer wheel with millisecond resolution.
+//
+// Entry is intrusive, so insert() and remove() are O(1) and never allocate.
+// Level L holds entries which expiration time differs from the current time
+// first in the L-th group of kSlotBits bits, so all entries of a lower level
+// expire before all entries of a higher level. When the current time reaches
+// a slot of a higher level its entries are cascaded to the lower levels.
+//
+// The nearest expiration is cached, so arming a timer and asking for the
+// next expiration is O(1), the wheel is scanned again only after the
+// nearest entry is removed or the current time is moved.
+template <typename Owner>
+class timer_wheel {
+public:
+	using time_type = std::int64_t;
+
+	class entry {
+	public:
+		explicit entry(Owner *owner) : _owner(owner) {
+		}
+		entry(const entry &other) = delete;
+		entry &operator=(const entry &other) = delete;
+		~entry() {
+			if (_wheel) {
+				_wheel->remove(this);
+			}
+		}
+
+		Owner *owner() const {
+			return _owner;
+		}
+		bool linked() const {
+			return (_wheel != nullptr);
+		}
+		time_type when() const {
+			return _when;
+		}
+
+	private:
+		friend class timer_wheel;
+
+		Owner *_owner = nullptr;
+		timer_wheel *_wheel = nullptr;
+		entry *_next = nullptr;
+		entry **_prev = nullptr;
+		time_type _when = 0;
+		int _level = 0;
+		int _slot = 0;
+
+	};
+
+	explicit timer_wheel(time_type now) : _now(now) {
+		_heads.fill(nullptr);
+		_occupied.fill(0);
+	}
+	timer_wheel(const timer_wheel &other) = delete;
+	timer_wheel &operator=(const timer_wheel &other) = delete;
+	~timer_wheel() {
+		clear();
+	}
+
+	time_type now() const {
+		return _now;
+	}
+	int size() const {
+		return _size;
+	}
+	bool empty() const {
+		return (_size == 0);
+	}
+
+	// Entries with expiration in the past expire on the next advance().
+	void insert(entry *value, time_type when) {
+		if (value->_wheel) {
+			value->_wheel->remove(value);
+		}
+		value->_when = (when > _now) ? when : _now;
+		place(value);
+		++_size;
+		if (_nextKnown && (_next < 0 || value->_when < _next)) {
+			_next = value->_when;
+		}
+	}
+
+	void remove(entry *value) {
+		if (value->_wheel != this) {
+			return;
+		}
+		if (value->_when == _next) {
+			_nextKnown = false;
+		}
+		unlink(value);
+		--_size;
+	}
+
+	void clear() {
+		for (auto &head : _heads) {
+			while (head) {
+				remove(head);
+			}
+		}
+		while (_expired) {
+			remove(_expired);
+		}
+	}
+
+	// Exact nearest expiration time or -1 if there are no entries.
+	time_type next_expiration() const {
+		if (_expired) {
+			return _now;
+		} else if (!_nextKnown) {
+			_next = next_in_wheel();
+			_nextKnown = true;
+		}
+		return _next;
+	}
+
+	// Moves the current time forward and queues all entries
+	// expiring till then, take them one by one by take_expired().
+	void advance(time_type now) {
+		while (true) {
+			const auto next = next_in_wheel();
+			if (next < 0 || next > now) {
+				break;
+			}
+			move_to(next);
+			auto &head = _heads[index(0, group(_now, 0))];
+			while (head) {
+				const auto value = head;
+				unlink(value);
+				push_expired(value);
+			}
+		}
+		if (now > _now) {
+			move_to(now);
+		}
+		_nextKnown = false;
+	}
+
+	// Returns owner of the next expired entry or nullptr.
+	// The entry is unlinked, so the owner may insert it back.
+	Owner *take_expired() {
+		if (const auto value = _expired) {
+			remove(value);
+			return value->_owner;
+		}
+		return nullptr;
+	}
+
+private:
+	static constexpr auto kSlotBits = 6;
+	static constexpr auto kSlots = (1 << kSlotBits);
+	static constexpr auto kLevels = 4;
+	static constexpr auto kFarIndex = kLevels * kSlots;
+	static constexpr auto kExpiredLevel = kLevels + 1;
+
+	time_type next_in_wheel() const {
+		for (auto level = 0; level != kLevels; ++level) {
+			const auto first = (level > 0) ? (group(_now, level) + 1) : 0;
+			const auto occupied = (first < kSlots)
+				? (_occupied[level] & (~std::uint64_t(0) << first))
+				: std::uint64_t(0);
+			if (!occupied) {
+				continue;
+			}
+			const auto slot = lowest_bit(occupied);
+			if (!level) {
+				// All entries of a zero level slot expire at the same time.
+				return _heads[index(level, slot)]->_when;
+			}
+			auto result = std::numeric_limits<time_type>::max();
+			for (auto i = _heads[index(level, slot)]; i; i = i->_next) {
+				if (i->_when < result) {
+					result = i->_when;
+				}
+			}
+			return result;
+		}
+		if (const auto far = _heads[kFarIndex]) {
+			auto result = std::numeric_limits<time_type>::max();
+			for (auto i = far; i; i = i->_next) {
+				if (i->_when < result) {
+					result = i->_when;
+				}
+			}
+			return result;
+		}
+		return -1;
+	}
+
+	static int group(time_type time, int level) {
+		return int((time >> (level * kSlotBits)) & (kSlots - 1));
+	}
+	static int index(int level, int slot) {
+		return level * kSlots + slot;
+	}
+	static int lowest_bit(std::uint64_t value) {
+		auto result = 0;
+		while (!(value & 1)) {
+			value >>= 1;
+			++result;
+		}
+		return result;
+	}
+	static int highest_different_level(time_type a, time_type b) {
+		auto difference = std::uint64_t(a ^ b) >> kSlotBits;
+		auto result = 0;
+		while (difference) {
+			difference >>= kSlotBits;
+			++result;
+		}
+		return result;
+	}
+
+	void place(entry *value) {
+		const auto level = highest_different_level(value->_when, _now);
+		if (level >= kLevels) {
+			link(value, kLevels, 0, _heads[kFarIndex]);
+		} else {
+			const auto slot = group(value->_when, level);
+			link(value, level, slot, _heads[index(level, slot)]);
+			_occupied[level] |= (std::uint64_t(1) << slot);
+		}
+	}
+
+	void push_expired(entry *value) {
+		// Keep expiration order, so append to the end of the list.
+		link(value, kExpiredLevel, 0, *_expiredTail);
+		_expiredTail = &value->_next;
+	}
+
+	void link(entry *value, int level, int slot, entry *&head) {
+		value->_wheel = this;
+		value->_level = level;
+		value->_slot = slot;
+		value->_next = head;
+		value->_prev = &head;
+		if (head) {
+			head->_prev = &value->_next;
+		}
+		head = value;
+	}
+
+	void unlink(entry *value) {
+		if (_expiredTail == &value->_next) {
+			_expiredTail = value->_prev;
+		}
+		*value->_prev = value->_next;
+		if (value->_next) {
+			value->_next->_prev = value->_prev;
+		}
+		if (value->_level < kLevels) {
+			const auto &head = _heads[index(value->_level, value->_slot)];
+			if (!head) {
+				_occupied[value->_level] &= ~(std::uint64_t(1) << value->_slot);
+			}
+		}
+		value->_wheel = nullptr;
+		value->_next = nullptr;
+		value->_prev = nullptr;
+	}
+
+	// All entries expire not earlier than the target time.
+	void move_to(time_type target) {
+		const auto level = highest_different_level(_now, target);
+		_now = target;
+		if (!level) {
+			return;
+		}
+
+		// Entries of the lower levels would have expired before the
+		// target, so only one slot of the highest changed level is left.
+		auto &head = (level >= kLevels)
+			? _heads[kFarIndex]
+			: _heads[index(level, group(target, level))];
+		auto list = head;
+		while (list) {
+			const auto value = list;
+			list = list->_next;
+			unlink(value);
+			place(value);
+		}
+	}
+
+	time_type _now = 0;
+	std::array<entry*, kLevels * kSlots + 1> _heads;
+	std::array<std::uint64_t, kLevels> _occupied;
+	entry *_expired = nullptr;
+	entry **_expiredTail = &_expired;
+	int _size = 0;
+	mutable time_type _next = -1;
+	mutable bool _nextKnown = true;
+
+};
+
+} // namespace base
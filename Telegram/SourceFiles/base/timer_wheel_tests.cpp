@@ -0,0 +1,180 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "base/timer_wheel.h"
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct target;
+using wheel = base::timer_wheel<target>;
+
+struct target {
+	target() : entry(this) {
+	}
+
+	wheel::entry entry;
+	wheel::time_type when = -1;
+};
+
+std::vector<target*> take_all(wheel &w) {
+	auto result = std::vector<target*>();
+	while (const auto value = w.take_expired()) {
+		result.push_back(value);
+	}
+	return result;
+}
+
+} // namespace
+
+TEST_CASE("timer wheel fires entries in expiration order", "[timer_wheel]") {
+	wheel w(1000);
+	target a, b, c;
+	w.insert(&a.entry, 1300);
+	w.insert(&b.entry, 1010);
+	w.insert(&c.entry, 1000 + (1 << 20));
+	REQUIRE(w.size() == 3);
+	REQUIRE(w.next_expiration() == 1010);
+
+	w.advance(1009);
+	REQUIRE(take_all(w).empty());
+
+	w.advance(1500);
+	auto fired = take_all(w);
+	REQUIRE(fired.size() == 2);
+	REQUIRE(fired[0] == &b);
+	REQUIRE(fired[1] == &a);
+	REQUIRE(!a.entry.linked());
+	REQUIRE(w.next_expiration() == 1000 + (1 << 20));
+
+	w.advance(1000 + (1 << 20));
+	fired = take_all(w);
+	REQUIRE(fired.size() == 1);
+	REQUIRE(fired[0] == &c);
+	REQUIRE(w.empty());
+	REQUIRE(w.next_expiration() == -1);
+}
+
+TEST_CASE("timer wheel entries can be removed and reinserted", "[timer_wheel]") {
+	wheel w(0);
+	target a, b;
+	w.insert(&a.entry, 100);
+	w.insert(&b.entry, 200);
+	w.remove(&a.entry);
+	REQUIRE(w.size() == 1);
+	REQUIRE(w.next_expiration() == 200);
+
+	w.insert(&b.entry, 50);
+	REQUIRE(w.size() == 1);
+	REQUIRE(w.next_expiration() == 50);
+
+	SECTION("past expiration fires on the next advance") {
+		w.insert(&a.entry, -10);
+		REQUIRE(w.next_expiration() == 0);
+		w.advance(0);
+		auto fired = take_all(w);
+		REQUIRE(fired.size() == 1);
+		REQUIRE(fired[0] == &a);
+	}
+
+	SECTION("destroyed entry leaves the wheel") {
+		{
+			target temporary;
+			w.insert(&temporary.entry, 10);
+			REQUIRE(w.size() == 2);
+		}
+		REQUIRE(w.size() == 1);
+		w.advance(1000);
+		REQUIRE(take_all(w).size() == 1);
+	}
+}
+
+TEST_CASE("timer wheel matches brute force on random input", "[timer_wheel]") {
+	auto generator = std::mt19937(239);
+	auto now = wheel::time_type(1000);
+	wheel w(now);
+	auto targets = std::vector<target>(500);
+	const auto random = [&](int limit) {
+		return wheel::time_type(generator() % limit);
+	};
+	for (auto step = 0; step != 20000; ++step) {
+		auto &value = targets[generator() % targets.size()];
+		switch (generator() % 4) {
+		case 0: {
+			const auto when = now + ((generator() % 8)
+				? random(100000)
+				: random(1 << 30));
+			w.insert(&value.entry, when);
+			value.when = when;
+		} break;
+		case 1:
+			w.remove(&value.entry);
+			value.when = -1;
+			break;
+		case 2: {
+			auto expected = wheel::time_type(-1);
+			for (const auto &other : targets) {
+				if (other.when >= 0
+					&& (expected < 0 || other.when < expected)) {
+					expected = other.when;
+				}
+			}
+			REQUIRE(w.next_expiration() == expected);
+		} break;
+		case 3: {
+			now += (generator() % 16) ? random(1000) : random(1 << 26);
+			w.advance(now);
+			auto last = wheel::time_type(-1);
+			for (const auto fired : take_all(w)) {
+				REQUIRE(fired->when >= last);
+				REQUIRE(fired->when <= now);
+				last = fired->when;
+				fired->when = -1;
+			}
+			for (const auto &other : targets) {
+				REQUIRE((other.when < 0 || other.when > now));
+			}
+		} break;
+		}
+	}
+}
+
+TEST_CASE("timer wheel arms and cancels many timers", "[timer_wheel][benchmark]") {
+	constexpr auto kCount = 100000;
+	wheel w(0);
+	auto generator = std::mt19937(239);
+	auto targets = std::vector<target>(kCount);
+
+	// Each arm and cancel asks for the next expiration,
+	// like the timers manager does to rearm the system timer.
+	auto nearest = wheel::time_type(-1);
+	const auto start = std::chrono::steady_clock::now();
+	for (auto &value : targets) {
+		const auto when = 1 + wheel::time_type(generator() % 60000);
+		w.insert(&value.entry, when);
+		if (nearest < 0 || when < nearest) {
+			nearest = when;
+		}
+		REQUIRE(w.next_expiration() == nearest);
+	}
+	REQUIRE(w.size() == kCount);
+	for (auto &value : targets) {
+		w.remove(&value.entry);
+		const auto next = w.next_expiration();
+		REQUIRE((w.empty() || next >= nearest));
+		nearest = next;
+	}
+	const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	REQUIRE(w.empty());
+	WARN("Armed and cancelled " << kCount << " timers in " << elapsed << "us.");
+}
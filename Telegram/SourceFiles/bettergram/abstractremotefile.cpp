@@ -1,6 +1,5 @@
 #include "abstractremotefile.h"
 
-#include <QTimer>
 #include <QtNetwork/QNetworkAccessManager>
 #include <QtNetwork/QNetworkRequest>
 #include <QtNetwork/QNetworkReply>
@@ -10,12 +9,14 @@ namespace Bettergram {
 AbstractRemoteFile::AbstractRemoteFile(QObject *parent) :
 	QObject(parent)
 {
+	_downloadLaterTimer.setSingleShot(true);
+	connect(&_downloadLaterTimer, &QTimer::timeout, this, [this]() { download(); });
 }
 
 AbstractRemoteFile::AbstractRemoteFile(const QUrl &link, QObject *parent) :
-	QObject(parent),
-	_link(link)
+	AbstractRemoteFile(parent)
 {
+	_link = link;
 	download();
 }
 
@@ -38,8 +39,21 @@ void AbstractRemoteFile::setLink(const QUrl &link)
 	}
 }
 
+void AbstractRemoteFile::stopDownloading()
+{
+	_downloadLaterTimer.stop();
+
+	if (QNetworkReply *reply = _reply.data()) {
+		_reply = nullptr;
+		reply->abort();
+	}
+}
+
 void AbstractRemoteFile::download()
 {
+	stopDownloading();
+	resetStreamedData();
+
 	if (!_link.isValid()) {
 		resetData();
 		return;
@@ -51,8 +65,24 @@ void AbstractRemoteFile::download()
 	request.setUrl(_link);
 
 	QNetworkReply *reply = networkManager->get(request);
+	_reply = reply;
+
+	if (isStreamed()) {
+		connect(reply, &QNetworkReply::readyRead, this, [this, reply]() {
+			if (_reply == reply) {
+				dataPartDownloaded(reply->readAll());
+			}
+		});
+	}
 
 	connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+		if (_reply != reply) {
+			// The request is stopped or the link is changed while downloading
+			return;
+		}
+
+		_reply = nullptr;
+
 		if(reply->error() == QNetworkReply::NoError) {
 			dataDownloaded(reply->readAll());
 		} else {
@@ -82,7 +112,7 @@ void AbstractRemoteFile::downloadLater()
 	qsrand(static_cast<uint>(QDateTime::currentMSecsSinceEpoch() / (5 * 1000 * 1000)));
 
 	//TODO: bettergram: increase the timeout after each call of this method
-	QTimer::singleShot(2000 + (qrand() % 3000), this, [this](){ download(); });
+	_downloadLaterTimer.start(2000 + (qrand() % 3000));
 }
 
 bool AbstractRemoteFile::checkLink(const QUrl &link)
@@ -92,4 +122,18 @@ bool AbstractRemoteFile::checkLink(const QUrl &link)
 	return true;
 }
 
+bool AbstractRemoteFile::isStreamed() const
+{
+	return false;
+}
+
+void AbstractRemoteFile::dataPartDownloaded(const QByteArray &data)
+{
+	Q_UNUSED(data);
+}
+
+void AbstractRemoteFile::resetStreamedData()
+{
+}
+
 } // namespace Bettergrams
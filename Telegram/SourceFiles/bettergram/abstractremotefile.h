@@ -1,6 +1,10 @@
 #pragma once
 
 #include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+class QNetworkReply;
 
 namespace Bettergram {
 
@@ -17,6 +21,10 @@ public:
 	const QUrl &link() const;
 	void setLink(const QUrl &link);
 
+	/// Aborts the current request and the pending retry,
+	/// dataDownloaded() is not called for them
+	void stopDownloading();
+
 public slots:
 
 signals:
@@ -28,11 +36,26 @@ protected:
 
 	virtual bool checkLink(const QUrl &link);
 
+	/// If it returns true then dataPartDownloaded() is called as soon as
+	/// each part of data arrives and dataDownloaded() gets only the rest of data
+	virtual bool isStreamed() const;
+	virtual void dataPartDownloaded(const QByteArray &data);
+
+	/// It is called before each request, including retries after errors,
+	/// so parts of data streamed by the previous request should be dropped here
+	virtual void resetStreamedData();
+
 	void download();
 
 private:
 	QUrl _link;
 
+	/// Replies of previous requests are ignored, only this one is handled
+	QPointer<QNetworkReply> _reply;
+
+	/// Retries the failed request, it is stopped when a new request starts
+	QTimer _downloadLaterTimer;
+
 	void downloadLater();
 };
 
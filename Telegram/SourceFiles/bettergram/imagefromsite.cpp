@@ -2,31 +2,44 @@
 
 #include <QUrl>
 #include <QRegExp>
+#include <QHash>
+#include <QDateTime>
 
 namespace Bettergram {
 
 const int ImageFromSite::DEFAULT_WIDTH = 550;
 const int ImageFromSite::DEFAULT_HEIGHT = 310;
+const int ImageFromSite::MAX_SITE_CONTENT_SIZE = 512 * 1024;
+const qint64 ImageFromSite::IMAGE_LINK_CACHE_TIMEOUT = 12 * 60 * 60 * 1000LL;
+const int ImageFromSite::IMAGE_LINK_CACHE_MAX_SIZE = 1000;
+
+namespace {
+
+struct CachedImageLink {
+	QUrl imageLink;
+	qint64 time = 0;
+};
+
+/// Page link -> image link found at this page
+QHash<QString, CachedImageLink> &imageLinksCache()
+{
+	static QHash<QString, CachedImageLink> cache;
+	return cache;
+}
+
+} // namespace
 
 ImageFromSite::ImageFromSite(QObject *parent) :
 	QObject(parent)
 {
-	connect(&_siteContent, &RemoteTempData::downloaded,
-			this, &ImageFromSite::onSiteContentDownloaded);
-
-	connect(&_image, &RemoteImage::imageChanged,
-			this, &ImageFromSite::imageChanged);
+	init();
 }
 
 ImageFromSite::ImageFromSite(const QUrl &link, QObject *parent) :
-	QObject(parent),
-	_siteContent(link)
+	QObject(parent)
 {
-	connect(&_siteContent, &RemoteTempData::downloaded,
-			this, &ImageFromSite::onSiteContentDownloaded);
-
-	connect(&_image, &RemoteImage::imageChanged,
-			this, &ImageFromSite::imageChanged);
+	init();
+	setLink(link);
 }
 
 ImageFromSite::ImageFromSite(int scaledWidth, int scaledHeight, QObject *parent) :
@@ -34,20 +47,52 @@ ImageFromSite::ImageFromSite(int scaledWidth, int scaledHeight, QObject *parent)
 	_siteContent(),
 	_image(scaledWidth, scaledHeight)
 {
+	init();
+}
+
+void ImageFromSite::init()
+{
+	_siteContent.setIsStreamed(true);
+
+	connect(&_siteContent, &RemoteTempData::partDownloaded,
+			this, &ImageFromSite::onSiteContentPartDownloaded);
+
 	connect(&_siteContent, &RemoteTempData::downloaded,
 			this, &ImageFromSite::onSiteContentDownloaded);
 
+	connect(&_siteContent, &RemoteTempData::streamedDataReset,
+			this, &ImageFromSite::resetSiteContent);
+
 	connect(&_image, &RemoteImage::imageChanged,
 			this, &ImageFromSite::imageChanged);
 }
 
 const QUrl &ImageFromSite::link() const
 {
-	return _siteContent.link();
+	return _link;
 }
 
 void Bettergram::ImageFromSite::setLink(const QUrl &link)
 {
+	if (_link == link) {
+		return;
+	}
+
+	_link = link;
+	resetSiteContent();
+
+	const QUrl cachedImageLink = getCachedImageLink(link);
+
+	if (cachedImageLink.isValid()) {
+		// Forget the previous site link, so the site is downloaded again
+		// if we return to it after its cached image link is expired
+		_siteContent.stopDownloading();
+		_siteContent.setLink(QUrl());
+
+		_image.setLink(cachedImageLink);
+		return;
+	}
+
 	_siteContent.setLink(link);
 }
 
@@ -138,7 +183,169 @@ QStringRef ImageFromSite::parseStringAttribute(const QStringRef &source,
 	return QStringRef();
 }
 
+QUrl ImageFromSite::getCachedImageLink(const QUrl &link)
+{
+	QHash<QString, CachedImageLink> &cache = imageLinksCache();
+	const auto it = cache.find(link.toString());
+
+	if (it == cache.end()) {
+		return QUrl();
+	}
+
+	if (QDateTime::currentMSecsSinceEpoch() - it->time > IMAGE_LINK_CACHE_TIMEOUT) {
+		cache.erase(it);
+		return QUrl();
+	}
+
+	return it->imageLink;
+}
+
+void ImageFromSite::setCachedImageLink(const QUrl &link, const QUrl &imageLink)
+{
+	CachedImageLink cachedImageLink;
+	cachedImageLink.imageLink = imageLink;
+	cachedImageLink.time = QDateTime::currentMSecsSinceEpoch();
+
+	QHash<QString, CachedImageLink> &cache = imageLinksCache();
+
+	for (auto it = cache.begin(); it != cache.end();) {
+		if (cachedImageLink.time - it->time > IMAGE_LINK_CACHE_TIMEOUT) {
+			it = cache.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	if (cache.size() >= IMAGE_LINK_CACHE_MAX_SIZE && !cache.contains(link.toString())) {
+		auto oldest = cache.begin();
+
+		for (auto it = cache.begin(); it != cache.end(); ++it) {
+			if (it->time < oldest->time) {
+				oldest = it;
+			}
+		}
+
+		cache.erase(oldest);
+	}
+
+	cache.insert(link.toString(), cachedImageLink);
+}
+
+QUrl ImageFromSite::getFaviconLink(const QUrl &link)
+{
+	if (link.host().isEmpty()) {
+		return QUrl();
+	}
+
+	QUrl result;
+	result.setScheme(link.scheme());
+	result.setHost(link.host());
+	result.setPort(link.port());
+	result.setPath(QStringLiteral("/favicon.ico"));
+
+	return result;
+}
+
+void ImageFromSite::resetSiteContent()
+{
+	_siteContentDecoder.reset(QTextCodec::codecForName("UTF-8")->makeDecoder());
+	_siteContentText.clear();
+
+	_metaTagsPosition = 0;
+	_imageTagsPosition = 0;
+	_isHeadParsed = false;
+
+	_imageLinkInImageTags.clear();
+	_maxWidthInImageTags = 0;
+	_maxHeightInImageTags = 0;
+	_positionInImageTags = 0;
+}
+
+void ImageFromSite::setFoundImageLink(const QUrl &imageLink)
+{
+	// If the site does not contain any image we use its favicon,
+	// and we do not download the site content again till the cache is expired
+	const QUrl resultLink = imageLink.isValid() ? imageLink : getFaviconLink(_link);
+
+	setCachedImageLink(_link, resultLink);
+
+	if (resultLink.isValid()) {
+		_image.setLink(resultLink);
+	}
+}
+
+QString ImageFromSite::getMetaImage(bool isFinished)
+{
+	// Sites usually set the preview image of a page by Open Graph or Twitter meta tags.
+	// These tags can be only in <head> section, so we stop searching them after </head>
+
+	if (_isHeadParsed) {
+		return QString();
+	}
+
+	const QString startMetaTag = QStringLiteral("<meta");
+	const QString endMetaTag = QStringLiteral(">");
+	const QString endHeadTag = QStringLiteral("</head");
+
+	const QString startContentAttribute = QStringLiteral("content=\"");
+	const QString endContentAttribute = QStringLiteral("\"");
+
+	int endHeadTagIndex = _siteContentText.indexOf(endHeadTag, _metaTagsPosition, Qt::CaseInsensitive);
+
+	if (endHeadTagIndex != -1 || isFinished) {
+		_isHeadParsed = true;
+	}
+
+	if (endHeadTagIndex == -1) {
+		endHeadTagIndex = _siteContentText.size();
+	}
+
+	while (true) {
+		int startMetaTagIndex = _siteContentText.indexOf(startMetaTag,
+														 _metaTagsPosition,
+														 Qt::CaseInsensitive);
+
+		if (startMetaTagIndex == -1 || startMetaTagIndex >= endHeadTagIndex) {
+			if (!_isHeadParsed) {
+				// The last tag may not be received completely yet
+				_metaTagsPosition = qMax(_metaTagsPosition, _siteContentText.size() - startMetaTag.size());
+			}
+			break;
+		}
+
+		int endMetaTagIndex = _siteContentText.indexOf(endMetaTag, startMetaTagIndex, Qt::CaseInsensitive);
+
+		if (endMetaTagIndex == -1) {
+			// Wait for the rest of the tag
+			_metaTagsPosition = startMetaTagIndex;
+			break;
+		}
+
+		_metaTagsPosition = endMetaTagIndex;
+
+		QStringRef metaTag = _siteContentText.midRef(startMetaTagIndex,
+													 endMetaTagIndex - startMetaTagIndex);
+
+		if (!metaTag.contains(QStringLiteral("\"og:image\""), Qt::CaseInsensitive)
+				&& !metaTag.contains(QStringLiteral("\"twitter:image\""), Qt::CaseInsensitive)) {
+			continue;
+		}
+
+		QStringRef imageLink = parseStringAttribute(metaTag,
+													startContentAttribute,
+													endContentAttribute);
+
+		if (!imageLink.isEmpty()) {
+			return imageLink.toString();
+		}
+	}
+
+	return QString();
+}
+
 QStringRef ImageFromSite::getLargestImageInImageTags(const QString &source,
+													 int &startIndex,
+													 bool isFinished,
 													 int &maxWidth,
 													 int &maxHeight,
 													 int &position)
@@ -157,24 +364,33 @@ QStringRef ImageFromSite::getLargestImageInImageTags(const QString &source,
 	const QString startHeightAttribute = QStringLiteral("height=\"");
 	const QString endHeightAttribute = QStringLiteral("\"");
 
-	int startIndex = 0;
-
 	while (true) {
 		int startImageTagIndex = source.indexOf(startImageTag, startIndex, Qt::CaseInsensitive);
 
 		if (startImageTagIndex == -1) {
+			if (!isFinished) {
+				// The last tag may not be received completely yet
+				startIndex = qMax(startIndex, source.size() - startImageTag.size());
+			}
 			break;
 		}
 
-		startImageTagIndex += startImageTag.size();
-		startIndex = startImageTagIndex;
-
-		int endImageTagIndex = source.indexOf(endImageTag, startImageTagIndex, Qt::CaseInsensitive);
+		int endImageTagIndex = source.indexOf(endImageTag,
+											  startImageTagIndex + startImageTag.size(),
+											  Qt::CaseInsensitive);
 
 		if (endImageTagIndex == -1) {
+			if (!isFinished) {
+				// Wait for the rest of the tag
+				startIndex = startImageTagIndex;
+				break;
+			}
+
 			endImageTagIndex = source.size();
 		}
 
+		startImageTagIndex += startImageTag.size();
+
 		startIndex = endImageTagIndex;
 
 		QStringRef imageTag = source.midRef(startImageTagIndex,
@@ -272,51 +488,93 @@ QString ImageFromSite::getLargestImageInFileNames(const QString &source,
 	return imageLink;
 }
 
+void ImageFromSite::onSiteContentPartDownloaded(QByteArray data)
+{
+	_siteContentText += _siteContentDecoder->toUnicode(data);
+
+	if (parseSiteContent(false)) {
+		// We have already found an image, so we do not need the rest of the site content
+		_siteContent.stopDownloading();
+	}
+}
+
 void Bettergram::ImageFromSite::onSiteContentDownloaded(QByteArray data)
 {
+	_siteContentText += _siteContentDecoder->toUnicode(data);
+
+	parseSiteContent(true);
+}
+
+bool ImageFromSite::parseSiteContent(bool isFinished)
+{
+	if (_siteContentText.size() >= MAX_SITE_CONTENT_SIZE) {
+		isFinished = true;
+	}
+
+	const QString metaImage = getMetaImage(isFinished);
+
+	if (!metaImage.isEmpty()) {
+		setFoundImageLink(QUrl(metaImage));
+		return true;
+	}
+
 	// Here we should find all images with sizes and find the largest one
 
-	const QString source = QString::fromUtf8(data);
+	QStringRef imageLinkInImageTags = getLargestImageInImageTags(_siteContentText,
+																 _imageTagsPosition,
+																 isFinished,
+																 _maxWidthInImageTags,
+																 _maxHeightInImageTags,
+																 _positionInImageTags);
 
-	int maxWidthInImageTags = 0;
-	int maxHeightInImageTags = 0;
-	int positionInImageTags = 0;
+	if (!imageLinkInImageTags.isEmpty()) {
+		_imageLinkInImageTags = imageLinkInImageTags.toString();
+	}
+
+	// We do not need to continue parsing the site content
+	// if we have already got a big enough image
+	if (_maxWidthInImageTags >= DEFAULT_WIDTH && _maxHeightInImageTags >= DEFAULT_HEIGHT) {
+		setFoundImageLink(QUrl(_imageLinkInImageTags));
+		return true;
+	}
 
-	QStringRef imageLinkInImageTags = getLargestImageInImageTags(source,
-																 maxWidthInImageTags,
-																 maxHeightInImageTags,
-																 positionInImageTags);
+	if (!isFinished) {
+		return false;
+	}
 
 	int maxWidthInFileNames = 0;
 	int maxHeightInFileNames = 0;
 	int positionInFileNames = 0;
 
-	QString imageLinkInFileName = getLargestImageInFileNames(source,
+	QString imageLinkInFileName = getLargestImageInFileNames(_siteContentText,
 															 maxWidthInFileNames,
 															 maxHeightInFileNames,
 															 positionInFileNames);
 
 	QUrl imageUrl;
 
-	if (maxHeightInImageTags >= DEFAULT_HEIGHT && maxWidthInFileNames >= DEFAULT_WIDTH
+	if (_maxHeightInImageTags >= DEFAULT_HEIGHT && maxWidthInFileNames >= DEFAULT_WIDTH
 			&& maxHeightInFileNames >= DEFAULT_HEIGHT && maxWidthInFileNames >= DEFAULT_WIDTH) {
-		if (positionInImageTags <= positionInFileNames) {
-			imageUrl = imageLinkInImageTags.toString();
+		if (_positionInImageTags <= positionInFileNames) {
+			imageUrl = _imageLinkInImageTags;
 		} else {
 			imageUrl = imageLinkInFileName;
 		}
-	} else if (maxHeightInFileNames > maxHeightInImageTags) {
+	} else if (maxHeightInFileNames > _maxHeightInImageTags) {
 		imageUrl = imageLinkInFileName;
-	} else if (maxHeightInFileNames == maxHeightInImageTags
-			   && maxWidthInFileNames > maxWidthInImageTags) {
+	} else if (maxHeightInFileNames == _maxHeightInImageTags
+			   && maxWidthInFileNames > _maxWidthInImageTags) {
 		imageUrl = imageLinkInFileName;
 	} else {
-		imageUrl = imageLinkInImageTags.toString();
+		imageUrl = _imageLinkInImageTags;
 	}
 
-	if (imageUrl.isValid()) {
-		_image.setLink(imageUrl);
-	}
+	setFoundImageLink(imageUrl);
+
+	// The site content is not needed anymore
+	_siteContentText.clear();
+
+	return true;
 }
 
 } // namespace Bettergrams
@@ -3,11 +3,16 @@
 #include "remotetempdata.h"
 #include "remoteimage.h"
 
+#include <QTextCodec>
+
 namespace Bettergram {
 
 /**
  * @brief The ImageFromSite class is used to download the biggest image from a site.
  * We use this class to fetch RSS thumbnail if all other ways are broken.
+ * The site content is parsed while it is downloading and the request is stopped
+ * as soon as a good enough image is found. Found image links are cached for some time,
+ * so the same site is not downloaded again at each RSS feeds update.
  */
 class ImageFromSite : public QObject {
 	Q_OBJECT
@@ -47,9 +52,43 @@ private:
 	static const int DEFAULT_WIDTH;
 	static const int DEFAULT_HEIGHT;
 
+	/// We stop downloading the site content if we have not found any image at this size
+	static const int MAX_SITE_CONTENT_SIZE;
+
+	/// How long found image links are stored in cache, in milliseconds
+	static const qint64 IMAGE_LINK_CACHE_TIMEOUT;
+
+	/// How many found image links are stored in cache at most
+	static const int IMAGE_LINK_CACHE_MAX_SIZE;
+
+	QUrl _link;
 	RemoteTempData _siteContent;
 	RemoteImage _image;
 
+	std::unique_ptr<QTextDecoder> _siteContentDecoder;
+	QString _siteContentText;
+
+	/// Positions in _siteContentText from which we continue parsing after the next part arrives
+	int _metaTagsPosition = 0;
+	int _imageTagsPosition = 0;
+	bool _isHeadParsed = false;
+
+	QString _imageLinkInImageTags;
+	int _maxWidthInImageTags = 0;
+	int _maxHeightInImageTags = 0;
+	int _positionInImageTags = 0;
+
+	static QUrl getCachedImageLink(const QUrl &link);
+	static void setCachedImageLink(const QUrl &link, const QUrl &imageLink);
+	static QUrl getFaviconLink(const QUrl &link);
+
+	void init();
+	void resetSiteContent();
+	bool parseSiteContent(bool isFinished);
+	void setFoundImageLink(const QUrl &imageLink);
+
+	QString getMetaImage(bool isFinished);
+
 	int parseIntAttribute(const QStringRef &source,
 						  const QString &startAttribute,
 						  const QString &endAttribute);
@@ -59,6 +98,8 @@ private:
 									const QString &endAttribute);
 
 	QStringRef getLargestImageInImageTags(const QString &source,
+										  int &startIndex,
+										  bool isFinished,
 										  int &maxWidth,
 										  int &maxHeight,
 										  int &position);
@@ -69,6 +110,7 @@ private:
 									   int &position);
 
 private slots:
+	void onSiteContentPartDownloaded(QByteArray data);
 	void onSiteContentDownloaded(QByteArray data);
 };
 
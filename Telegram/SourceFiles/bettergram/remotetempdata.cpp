@@ -12,6 +12,21 @@ RemoteTempData::RemoteTempData(const QUrl &link, QObject *parent) :
 {
 }
 
+bool RemoteTempData::isStreamed() const
+{
+	return _isStreamed;
+}
+
+void RemoteTempData::setIsStreamed(bool isStreamed)
+{
+	_isStreamed = isStreamed;
+}
+
+void RemoteTempData::dataPartDownloaded(const QByteArray &data)
+{
+	emit partDownloaded(data);
+}
+
 void RemoteTempData::dataDownloaded(const QByteArray &data)
 {
 	emit downloaded(data);
@@ -21,4 +36,9 @@ void RemoteTempData::resetData()
 {
 }
 
+void RemoteTempData::resetStreamedData()
+{
+	emit streamedDataReset();
+}
+
 } // namespace Bettergrams
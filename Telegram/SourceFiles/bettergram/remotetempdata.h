@@ -16,16 +16,28 @@ public:
 
 	explicit RemoteTempData(const QUrl &link, QObject *parent = nullptr);
 
+	/// If it is true then partDownloaded() signal is emitted for each received part of data
+	/// and downloaded() signal contains only the rest of data
+	void setIsStreamed(bool isStreamed);
+
 public slots:
 
 signals:
+	void partDownloaded(QByteArray data);
 	void downloaded(QByteArray data);
 
+	/// Parts of data emitted by partDownloaded() before are not valid anymore
+	void streamedDataReset();
+
 protected:
+	bool isStreamed() const override;
+	void dataPartDownloaded(const QByteArray &data) override;
 	void dataDownloaded(const QByteArray &data) override;
 	void resetData() override;
+	void resetStreamedData() override;
 
 private:
+	bool _isStreamed = false;
 };
 
 } // namespace Bettergram
@@ -612,7 +612,7 @@ void SetupChannelBox::prepare() {
 	connect(&_checkTimer, &QTimer::timeout, [=] { check(); });
 
 	_privacyGroup->setChangedCallback([this](Privacy value) { privacyChanged(value); });
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(Notify::PeerUpdate::Flag::InviteLinkChanged, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(Notify::PeerUpdate::Flag::InviteLinkChanged), Notify::PeerUpdatedHandler("SetupChannelBox::prepare", [this](const Notify::PeerUpdate &update) {
 		if (update.peer == _channel) {
 			rtlupdate(_invitationLink);
 		}
@@ -1163,7 +1163,7 @@ void EditChannelBox::prepare() {
 	addButton(langFactory(lng_settings_save), [this] { save(); });
 	addButton(langFactory(lng_cancel), [this] { closeBox(); });
 
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(Notify::PeerUpdate::Flag::NameChanged, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(Notify::PeerUpdate::Flag::NameChanged), Notify::PeerUpdatedHandler("EditChannelBox::prepare", [this](const Notify::PeerUpdate &update) {
 		if (update.peer == _channel) {
 			handleChannelNameChange();
 		}
@@ -267,7 +267,7 @@ void MaxInviteBox::prepare() {
 	_textHeight = qMin(_text.countHeight(_textWidth), 16 * st::boxLabelStyle.lineHeight);
 	setDimensions(st::boxWidth, st::boxPadding.top() + _textHeight + st::boxTextFont->height + st::boxTextFont->height * 2 + st::newGroupLinkPadding.bottom());
 
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(Notify::PeerUpdate::Flag::InviteLinkChanged, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(Notify::PeerUpdate::Flag::InviteLinkChanged), Notify::PeerUpdatedHandler("MaxInviteBox::prepare", [this](const Notify::PeerUpdate &update) {
 		if (update.peer == _channel) {
 			rtlupdate(_invitationLink);
 		}
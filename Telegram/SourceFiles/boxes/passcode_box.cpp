@@ -294,7 +294,7 @@ void PasscodeBox::handleSrpIdInvalid() {
 }
 
 void PasscodeBox::save(bool force) {
-	if (_setRequest) return;
+	if (_setRequest || _checkingOldPasscode) return;
 
 	QString old = _oldPasscode->text(), pwd = _newPasscode->text(), conf = _reenterPasscode->text();
 	const auto has = currentlyHave();
@@ -307,15 +307,24 @@ void PasscodeBox::save(bool force) {
 			return;
 		}
 
-		if (Local::checkPasscode(old.toUtf8())) {
-			cSetPasscodeBadTries(0);
-			if (_turningOff) pwd = conf = QString();
-		} else {
-			cSetPasscodeBadTries(cPasscodeBadTries() + 1);
-			cSetPasscodeLastTry(getms(true));
-			badOldPasscode();
+		if (old != _checkedOldPasscode) {
+			_checkingOldPasscode = true;
+			Local::checkPasscodeAsync(old.toUtf8(), crl::guard(this, [=](
+					bool correct) {
+				_checkingOldPasscode = false;
+				if (correct) {
+					_checkedOldPasscode = old;
+					save(force);
+				} else {
+					cSetPasscodeBadTries(cPasscodeBadTries() + 1);
+					cSetPasscodeLastTry(getms(true));
+					badOldPasscode();
+				}
+			}));
 			return;
 		}
+		cSetPasscodeBadTries(0);
+		if (_turningOff) pwd = conf = QString();
 	}
 	if (!_turningOff && pwd.isEmpty()) {
 		_newPasscode->setFocus();
@@ -362,8 +371,11 @@ void PasscodeBox::save(bool force) {
 		}
 	} else {
 		cSetPasscodeBadTries(0);
-		Local::setPasscode(pwd.toUtf8());
-		Auth().checkAutoLock();
+		Local::setPasscodeAsync(pwd.toUtf8(), [] {
+			if (AuthSession::Exists()) {
+				Auth().checkAutoLock();
+			}
+		});
 		closeBox();
 	}
 }
@@ -108,6 +108,8 @@ private:
 	bool _turningOff = false;
 	bool _cloudPwd = false;
 	mtpRequestId _setRequest = 0;
+	QString _checkedOldPasscode;
+	bool _checkingOldPasscode = false;
 
 	Core::CloudPasswordCheckRequest _curRequest;
 	TimeMs _lastSrpIdInvalidTime = 0;
@@ -552,7 +552,7 @@ PeerListContent::PeerListContent(
 
 	using UpdateFlag = Notify::PeerUpdate::Flag;
 	auto changes = UpdateFlag::NameChanged | UpdateFlag::PhotoChanged;
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(changes, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(changes), Notify::PeerUpdatedHandler("PeerListContent::PeerListContent", [this](const Notify::PeerUpdate &update) {
 		if (update.flags & UpdateFlag::PhotoChanged) {
 			this->update();
 		} else if (update.flags & UpdateFlag::NameChanged) {
@@ -632,7 +632,18 @@ void PeerListContent::invalidatePixmapsCache() {
 
 bool PeerListContent::addingToSearchIndex() const {
 	// If we started indexing already, we continue.
-	return (_searchMode != PeerListSearchMode::Disabled) || !_searchIndex.empty();
+	return _searchIndexBuilt;
+}
+
+void PeerListContent::ensureSearchIndex() {
+	// Large lists are indexed only when they are searched for the first time.
+	if (_searchIndexBuilt) {
+		return;
+	}
+	_searchIndexBuilt = true;
+	for (const auto &row : _rows) {
+		addToSearchIndex(row.get());
+	}
 }
 
 void PeerListContent::addToSearchIndex(not_null<PeerListRow*> row) {
@@ -749,6 +760,7 @@ void PeerListContent::clearAllContent() {
 	_rowsByPeer.clear();
 	_filterResults.clear();
 	_searchIndex.clear();
+	_searchIndexBuilt = false;
 	_rows.clear();
 	_searchRows.clear();
 	_searchQuery
@@ -841,11 +853,6 @@ void PeerListContent::refreshRows() {
 
 void PeerListContent::setSearchMode(PeerListSearchMode mode) {
 	if (_searchMode != mode) {
-		if (!addingToSearchIndex()) {
-			for_const (auto &row, _rows) {
-				addToSearchIndex(row.get());
-			}
-		}
 		_searchMode = mode;
 		if (_controller->hasComplexSearch()) {
 			if (!_searchLoading) {
@@ -1256,6 +1263,7 @@ void PeerListContent::searchQueryChanged(QString query) {
 	if (_normalizedSearchQuery != normalizedQuery) {
 		setSearchQuery(query, normalizedQuery);
 		if (_controller->searchInLocal() && !searchWordsList.isEmpty()) {
+			ensureSearchIndex();
 			auto minimalList = (const std::vector<not_null<PeerListRow*>>*)nullptr;
 			for_const (auto &searchWord, searchWordsList) {
 				auto searchWordStart = searchWord[0].toLower();
@@ -259,6 +259,10 @@ public:
 	virtual int peerListFullRowsCount() = 0;
 	virtual PeerListRow *peerListFindRow(PeerListRowId id) = 0;
 	virtual void peerListSortRows(Fn<bool(const PeerListRow &a, const PeerListRow &b)> compare) = 0;
+	// Other rows should be already sorted with the same compare.
+	virtual void peerListSortChangedRows(
+		const base::flat_set<PeerListRowId> &changed,
+		Fn<bool(const PeerListRow &a, const PeerListRow &b)> compare) = 0;
 	virtual int peerListPartitionRows(Fn<bool(const PeerListRow &a)> border) = 0;
 
 	template <typename PeerDataRange>
@@ -340,6 +344,10 @@ public:
 	virtual void rowClicked(not_null<PeerListRow*> row) = 0;
 	virtual void rowActionClicked(not_null<PeerListRow*> row) {
 	}
+
+	// Called when the list is scrolled near its end. The rows of all the
+	// loaded pages are kept until the box is closed, they are not evicted
+	// when scrolled out of the viewport.
 	virtual void loadMoreRows() {
 	}
 	virtual void itemDeselectedHook(not_null<PeerData*> peer) {
@@ -569,6 +577,7 @@ private:
 	void addRowEntry(not_null<PeerListRow*> row);
 	void addToSearchIndex(not_null<PeerListRow*> row);
 	bool addingToSearchIndex() const;
+	void ensureSearchIndex();
 	void removeFromSearchIndex(not_null<PeerListRow*> row);
 	void setSearchQuery(const QString &query, const QString &normalizedQuery);
 	bool showingSearch() const {
@@ -611,6 +620,7 @@ private:
 	std::map<PeerData*, std::vector<not_null<PeerListRow*>>> _rowsByPeer;
 
 	std::map<QChar, std::vector<not_null<PeerListRow*>>> _searchIndex;
+	bool _searchIndexBuilt = false;
 	QString _searchQuery;
 	QString _normalizedSearchQuery;
 	QString _mentionHighlight;
@@ -711,6 +721,40 @@ public:
 			});
 		});
 	}
+	void peerListSortChangedRows(
+			const base::flat_set<PeerListRowId> &changed,
+			Fn<bool(const PeerListRow &a, const PeerListRow &b)> compare) override {
+		_content->reorderRows([&](
+				auto &&begin,
+				auto &&end) {
+			using Row = std::decay_t<decltype(*begin)>;
+			const auto less = [&](const Row &a, const Row &b) {
+				return compare(*a, *b);
+			};
+
+			// Rows could be moved or appended to the search index since
+			// the last sort, so the ones out of order are sorted as well.
+			auto sorted = std::vector<Row>();
+			auto moved = std::vector<Row>();
+			sorted.reserve(end - begin);
+			for (auto i = begin; i != end; ++i) {
+				if (changed.contains((*i)->id())
+					|| (!sorted.empty() && less(*i, sorted.back()))) {
+					moved.push_back(std::move(*i));
+				} else {
+					sorted.push_back(std::move(*i));
+				}
+			}
+			std::sort(moved.begin(), moved.end(), less);
+			std::merge(
+				std::make_move_iterator(sorted.begin()),
+				std::make_move_iterator(sorted.end()),
+				std::make_move_iterator(moved.begin()),
+				std::make_move_iterator(moved.end()),
+				begin,
+				less);
+		});
+	}
 	int peerListPartitionRows(
 			Fn<bool(const PeerListRow &a)> border) override {
 		auto result = 0;
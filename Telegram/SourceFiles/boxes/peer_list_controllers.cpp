@@ -611,9 +611,11 @@ void EditChatAdminsBoxController::prepare() {
 	rebuildRows();
 	if (!delegate()->peerListFullRowsCount()) {
 		Auth().api().requestFullPeer(_chat);
-		_adminsUpdatedSubscription = subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(
-				Notify::PeerUpdate::Flag::AdminsChanged, [this](
-					const Notify::PeerUpdate &update) {
+		_adminsUpdatedSubscription = subscribe(Notify::PeerUpdated(
+				Notify::PeerUpdate::Flag::AdminsChanged
+			), Notify::PeerUpdatedHandler(
+				"EditChatAdminsBoxController::prepare",
+				[this](const Notify::PeerUpdate &update) {
 			if (update.peer == _chat) {
 				rebuildRows();
 				if (delegate()->peerListFullRowsCount()) {
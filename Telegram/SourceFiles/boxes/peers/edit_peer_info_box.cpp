@@ -727,7 +727,8 @@ object_ptr<Ui::RpWidget> Controller::createInviteLinkEdit() {
 
 	Notify::PeerUpdateValue(
 		_peer,
-		Notify::PeerUpdate::Flag::InviteLinkChanged
+		Notify::PeerUpdate::Flag::InviteLinkChanged,
+		"Controller::createInviteLinkEdit"
 	) | rpl::start_with_next([this] {
 		refreshEditInviteLink();
 	}, _controls.editInviteLinkWrap->lifetime());
@@ -792,7 +793,8 @@ object_ptr<Ui::RpWidget> Controller::createInviteLinkCreate() {
 
 	Notify::PeerUpdateValue(
 		_peer,
-		Notify::PeerUpdate::Flag::InviteLinkChanged
+		Notify::PeerUpdate::Flag::InviteLinkChanged,
+		"Controller::createInviteLinkCreate"
 	) | rpl::start_with_next([this] {
 		refreshCreateInviteLink();
 	}, _controls.createInviteLinkWrap->lifetime());
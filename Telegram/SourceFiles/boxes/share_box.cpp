@@ -313,7 +313,7 @@ ShareBox::Inner::Inner(QWidget *parent, ShareBox::FilterCallback &&filterCallbac
 
 	using UpdateFlag = Notify::PeerUpdate::Flag;
 	auto observeEvents = UpdateFlag::NameChanged | UpdateFlag::PhotoChanged;
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(observeEvents, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(observeEvents), Notify::PeerUpdatedHandler("ShareBox::Inner::Inner", [this](const Notify::PeerUpdate &update) {
 		notifyPeerUpdated(update);
 	}));
 	subscribe(Auth().downloaderTaskFinished(), [this] { update(); });
@@ -348,7 +348,7 @@ void Panel::initControls() {
 	subscribe(_call->muteChanged(), [this](bool mute) {
 		_mute->setIconOverride(mute ? &st::callUnmuteIcon : nullptr);
 	});
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(Notify::PeerUpdate::Flag::NameChanged, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(Notify::PeerUpdate::Flag::NameChanged), Notify::PeerUpdatedHandler("Calls::Panel::initControls", [this](const Notify::PeerUpdate &update) {
 		if (!_call || update.peer != _call->user()) {
 			return;
 		}
@@ -424,7 +424,8 @@ void Panel::initLayout() {
 
 	Notify::PeerUpdateValue(
 		_user,
-		Notify::PeerUpdate::Flag::PhotoChanged
+		Notify::PeerUpdate::Flag::PhotoChanged,
+		"Calls::Panel::initLayout"
 	) | rpl::start_with_next(
 		[this] { processUserPhoto(); },
 		lifetime());
@@ -730,7 +731,7 @@ void Panel::paintEvent(QPaintEvent *e) {
 		auto left = _fingerprintArea.left() + st::callFingerprintPadding.left();
 		auto top = _fingerprintArea.top() + st::callFingerprintPadding.top();
 		for (auto emoji : _fingerprint) {
-			p.drawPixmap(QPoint(left, top), App::emojiLarge(), QRect(emoji->x() * realSize, emoji->y() * realSize, realSize, realSize));
+			Ui::Emoji::Draw(p, emoji, realSize, left, top);
 			left += st::callFingerprintSkip + size;
 		}
 	}
@@ -98,7 +98,7 @@ void TopBar::initControls() {
 		setMuted(mute);
 		update();
 	});
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(Notify::PeerUpdate::Flag::NameChanged, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(Notify::PeerUpdate::Flag::NameChanged), Notify::PeerUpdatedHandler("Calls::TopBar::initControls", [this](const Notify::PeerUpdate &update) {
 		if (auto call = _call.get()) {
 			if (update.peer == call->user()) {
 				updateInfoLabels();
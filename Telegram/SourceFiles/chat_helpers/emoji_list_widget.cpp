@@ -317,7 +317,10 @@ void EmojiColorPicker::drawVariant(Painter &p, int variant) {
 		App::roundRect(p, QRect(tl, _singleSize), st::emojiPanHover, StickerHoverCorners);
 	}
 	auto esize = Ui::Emoji::Size(Ui::Emoji::Index() + 1);
-	p.drawPixmapLeft(w.x() + (_singleSize.width() - (esize / cIntRetinaFactor())) / 2, w.y() + (_singleSize.height() - (esize / cIntRetinaFactor())) / 2, width(), App::emojiLarge(), QRect(_variants[variant]->x() * esize, _variants[variant]->y() * esize, esize, esize));
+	auto imageLeft = w.x() + (_singleSize.width() - (esize / cIntRetinaFactor())) / 2;
+	auto imageTop = w.y() + (_singleSize.height() - (esize / cIntRetinaFactor())) / 2;
+	if (rtl()) imageLeft = width() - imageLeft - (esize / cIntRetinaFactor());
+	Ui::Emoji::Draw(p, _variants[variant], esize, imageLeft, imageTop);
 }
 
 EmojiListWidget::EmojiListWidget(QWidget *parent, not_null<Window::Controller*> controller) : Inner(parent, controller)
@@ -422,17 +425,19 @@ void EmojiListWidget::ensureLoaded(int section) {
 	}
 	_emoji[section] = Ui::Emoji::GetSection(static_cast<Section>(section));
 	_counts[section] = _emoji[section].size();
-	if (static_cast<Section>(section) == Section::Recent) {
-		return;
-	}
-	for (auto &emoji : _emoji[section]) {
-		if (emoji->hasVariants()) {
-			auto j = cEmojiVariants().constFind(emoji->nonColoredId());
-			if (j != cEmojiVariants().cend()) {
-				emoji = emoji->variant(j.value());
+	if (static_cast<Section>(section) != Section::Recent) {
+		for (auto &emoji : _emoji[section]) {
+			if (emoji->hasVariants()) {
+				auto j = cEmojiVariants().constFind(emoji->nonColoredId());
+				if (j != cEmojiVariants().cend()) {
+					emoji = emoji->variant(j.value());
+				}
 			}
 		}
 	}
+
+	// Sections are loaded when they become visible, prepare their sprites.
+	Ui::Emoji::Preload(_emoji[section], _esize);
 }
 
 void EmojiListWidget::paintEvent(QPaintEvent *e) {
@@ -479,10 +484,10 @@ void EmojiListWidget::paintEvent(QPaintEvent *e) {
 						if (rtl()) tl.setX(width() - tl.x() - _singleSize.width());
 						App::roundRect(p, QRect(tl, _singleSize), st::emojiPanHover, StickerHoverCorners);
 					}
-					auto sourceRect = QRect(_emoji[info.section][index]->x() * _esize, _emoji[info.section][index]->y() * _esize, _esize, _esize);
 					auto imageLeft = w.x() + (_singleSize.width() - (_esize / cIntRetinaFactor())) / 2;
 					auto imageTop = w.y() + (_singleSize.height() - (_esize / cIntRetinaFactor())) / 2;
-					p.drawPixmapLeft(imageLeft, imageTop, width(), App::emojiLarge(), sourceRect);
+					if (rtl()) imageLeft = width() - imageLeft - (_esize / cIntRetinaFactor());
+					Ui::Emoji::Draw(p, _emoji[info.section][index], _esize, imageLeft, imageTop);
 				}
 			}
 		}
@@ -193,7 +193,9 @@ void SuggestionsWidget::paintEvent(QPaintEvent *e) {
 		}
 		auto emoji = row.emoji();
 		auto esize = Ui::Emoji::Size(Ui::Emoji::Index() + 1);
-		p.drawPixmapLeft((_st->itemPadding.left() - (esize / cIntRetinaFactor())) / 2, (_rowHeight - (esize / cIntRetinaFactor())) / 2, width(), App::emojiLarge(), QRect(emoji->x() * esize, emoji->y() * esize, esize, esize));
+		auto imageLeft = (_st->itemPadding.left() - (esize / cIntRetinaFactor())) / 2;
+		if (rtl()) imageLeft = width() - imageLeft - (esize / cIntRetinaFactor());
+		Ui::Emoji::Draw(p, emoji, esize, imageLeft, (_rowHeight - (esize / cIntRetinaFactor())) / 2);
 		p.setPen(selected ? _st->itemFgOver : _st->itemFg);
 		p.drawTextLeft(_st->itemPadding.left(), _st->itemPadding.top(), width(), row.label());
 		p.translate(0, _rowHeight);
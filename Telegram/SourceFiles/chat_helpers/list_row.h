@@ -47,7 +47,7 @@ public:
 
 	void setHeight(int height)
 	{
-		if (_height < 0) {
+		if (height < 0) {
 			LOG(("Unable to set negative height (%1) to list row").arg(height));
 			_height = 0;
 		} else {
@@ -6,14 +6,18 @@ namespace ChatHelpers {
 
 /**
  * @brief ListRowArray represents simple array of ListRow instances.
- * In normal project we would use QListView, but here we do not use such classes
+ * In normal project we would use QListView, but here we do not use such classes.
+ *
+ * Rows are laid out one after another, so their tops are sorted and hit-testing
+ * is done by binary search. Changes of top and spacing are applied lazily
+ * on the next geometry request, and appending rows does not walk the whole list.
  */
 template<typename TUserData>
 class ListRowArray
 {
 public:
 	typedef ListRow<TUserData> Row;
-	typedef typename QList<Row>::const_iterator const_iterator;
+	typedef typename std::vector<Row>::const_iterator const_iterator;
 
 	explicit ListRowArray()
 	{
@@ -21,14 +25,14 @@ public:
 
 	int top() const
 	{
-		return _list.empty() ? _top : _list.first().top();
+		return _top;
 	}
 
 	void setTop(int top)
 	{
 		if (_top != top) {
 			_top = top;
-			updateGeometry();
+			invalidateGeometry(0);
 		}
 	}
 
@@ -41,13 +45,14 @@ public:
 	{
 		if (_spacing != spacing) {
 			_spacing = spacing;
-			updateGeometry();
+			invalidateGeometry(1);
 		}
 	}
 
 	int bottom() const
 	{
-		return _list.empty() ? _top : _list.last().bottom();
+		updateGeometry();
+		return _list.empty() ? _top : _list.back().bottom();
 	}
 
 	int height() const
@@ -57,34 +62,41 @@ public:
 
 	bool contains(int y) const
 	{
-		if (y >= top() && y <= bottom()) {
-			//TODO: bettergram: we can optimize this by using dichotomy for example
-			for (const Row &row : _list) {
-				if (row.contains(y)) {
-					return true;
-				}
-			}
-		}
-
-		return false;
+		return findRowIndex(y) >= 0;
 	}
 
+	/**
+	 * @brief Returns index of the first row that contains y or -1 if there is no such row
+	 */
 	int findRowIndex(int y) const
 	{
-		if (y >= top() && y <= bottom()) {
-			//TODO: bettergram: we can optimize this by using dichotomy for example
-			for (int i = 0; i < _list.count(); i++) {
-				if (_list.at(i).contains(y)) {
-					return i;
-				}
-			}
+		const int index = findFirstRowIndexBelow(y);
+
+		if (index < count() && _list[index].contains(y)) {
+			return index;
 		}
 
 		return -1;
 	}
 
+	/**
+	 * @brief Returns index of the first row which bottom is not above y
+	 * or count() if all rows are above y. Use it to start painting from the first visible row.
+	 */
+	int findFirstRowIndexBelow(int y) const
+	{
+		updateGeometry();
+
+		const auto i = std::lower_bound(_list.cbegin(), _list.cend(), y, [](const Row &row, int value) {
+			return row.bottom() < value;
+		});
+
+		return static_cast<int>(i - _list.cbegin());
+	}
+
 	const_iterator begin() const
 	{
+		updateGeometry();
 		return _list.cbegin();
 	}
 
@@ -95,42 +107,62 @@ public:
 
 	int count() const
 	{
-		return _list.count();
+		return static_cast<int>(_list.size());
 	}
 
 	const Row &at(int index) const
 	{
-		if (index < 0 || index >= _list.count()) {
+		if (index < 0 || index >= count()) {
 			throw std::out_of_range("Unable to get ListRow at wrong index");
 		}
 
-		return _list.at(index);
+		updateGeometry();
+		return _list[index];
 	}
 
 	void clear()
 	{
 		_list.clear();
+		_dirtyFrom = -1;
 	}
 
 	void add(const TUserData &userData, int height)
 	{
-		_list.push_back(Row(userData, bottom() + _spacing, height));
+		const int rowTop = _list.empty() ? _top : (bottom() + _spacing);
+		_list.push_back(Row(userData, rowTop, height));
 	}
 
 private:
 	int _top = 0;
 	int _spacing = 0;
-	
-	QList<Row> _list;
 
-	void updateGeometry()
+	/// Index of the first row which top must be recounted or -1 if geometry is valid
+	mutable int _dirtyFrom = -1;
+	mutable std::vector<Row> _list;
+
+	void invalidateGeometry(int from)
+	{
+		if (_dirtyFrom < 0 || from < _dirtyFrom) {
+			_dirtyFrom = from;
+		}
+	}
+
+	void updateGeometry() const
 	{
-		int rowTop = _top;
+		if (_dirtyFrom < 0) {
+			return;
+		}
 
-		for (Row &row : _list) {
+		const int from = std::min(_dirtyFrom, count());
+		int rowTop = (from == 0) ? _top : (_list[from - 1].bottom() + _spacing);
+
+		for (int i = from; i < count(); i++) {
+			Row &row = _list[i];
 			row.setTop(rowTop);
 			rowTop += row.height() + _spacing;
 		}
+
+		_dirtyFrom = -1;
 	}
 };
 
@@ -493,13 +493,9 @@ void RssWidget::paintEvent(QPaintEvent *event) {
 
 	// Draw rows
 
-	for (int i = 0; i < _rows.count(); i++) {
+	for (int i = _rows.findFirstRowIndexBelow(r.top()); i < _rows.count(); i++) {
 		const ListRow<Row> &row = _rows.at(i);
 
-		if (row.bottom() < r.top()) {
-			continue;
-		}
-
 		if (row.top() > r.bottom()) {
 			break;
 		}
@@ -0,0 +1,307 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "chat_helpers/stickers_atlas.h"
+
+#include "data/data_document.h"
+
+namespace ChatHelpers {
+namespace {
+
+constexpr auto kAtlasColumns = 8;
+
+enum class SourceState {
+	Ready,
+	Loading,
+	Unavailable,
+};
+
+struct Source {
+	QByteArray bytes;
+	QByteArray format;
+	QString path;
+};
+
+SourceState ResolveSource(not_null<DocumentData*> document, Source &source) {
+	const auto origin = document->stickerSetOrigin();
+	if (document->hasGoodStickerThumb()) {
+		const auto thumb = document->thumb;
+		if (!thumb->loaded()) {
+			thumb->load(origin);
+			return SourceState::Loading;
+		}
+		source.bytes = thumb->savedData();
+		source.format = thumb->savedFormat();
+		return source.bytes.isEmpty()
+			? SourceState::Unavailable
+			: SourceState::Ready;
+	}
+	if (!document->loaded()) {
+		document->automaticLoad(origin, nullptr);
+		return SourceState::Loading;
+	}
+	source.bytes = document->data();
+	if (source.bytes.isEmpty()) {
+		source.path = document->filepath();
+	}
+	return (source.bytes.isEmpty() && source.path.isEmpty())
+		? SourceState::Unavailable
+		: SourceState::Ready;
+}
+
+QImage Decode(Source source, QSize size) {
+	if (source.bytes.isEmpty()) {
+		QFile f(source.path);
+		if (!f.open(QIODevice::ReadOnly)) {
+			return QImage();
+		}
+		source.bytes = f.readAll();
+	}
+	auto result = App::readImage(source.bytes, &source.format, false);
+	if (result.isNull()) {
+		return result;
+	}
+	if (result.size() != size) {
+		result = result.scaled(
+			size,
+			Qt::IgnoreAspectRatio,
+			Qt::SmoothTransformation);
+	}
+	return result.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+int64 PixmapMemory(const QPixmap &pixmap) {
+	return int64(pixmap.width()) * pixmap.height() * 4;
+}
+
+} // namespace
+
+QSize StickerDisplaySize(not_null<DocumentData*> document, QSize box) {
+	const auto &dimensions = document->dimensions;
+	if (dimensions.isEmpty()) {
+		return QSize(1, 1);
+	}
+	auto coef = qMin(
+		box.width() / float64(dimensions.width()),
+		box.height() / float64(dimensions.height()));
+	if (coef > 1) coef = 1;
+	return QSize(
+		qMax(qRound(coef * dimensions.width()), 1),
+		qMax(qRound(coef * dimensions.height()), 1));
+}
+
+struct StickersAtlas::Set {
+	~Set();
+
+	std::vector<DocumentData*> documents;
+	base::flat_set<DocumentId> ids;
+
+	// Rectangles in the atlas pixmap, in device pixels.
+	base::flat_map<DocumentId, QRect> cells;
+	base::flat_set<DocumentId> decoding;
+	base::flat_set<DocumentId> unavailable;
+
+	// Counted in the image cache size while it is alive.
+	QPixmap atlas;
+	int generation = 0;
+};
+
+StickersAtlas::Set::~Set() {
+	releaseImageCacheMemory(PixmapMemory(atlas));
+}
+
+struct StickersAtlas::Decoded {
+	int index = 0;
+	QImage image;
+};
+
+StickersAtlas::StickersAtlas(Fn<void()> updated)
+: _updated(std::move(updated)) {
+}
+
+void StickersAtlas::setBox(QSize box) {
+	if (_box != box) {
+		_box = box;
+		clear();
+	}
+}
+
+void StickersAtlas::prepare(uint64 setId, const Stickers::Pack &pack) {
+	if (_box.isEmpty() || pack.isEmpty()) {
+		return;
+	}
+	auto i = _sets.find(setId);
+	if (i != _sets.end()) {
+		const auto &documents = i->second->documents;
+		if (!std::equal(
+				documents.begin(),
+				documents.end(),
+				pack.begin(),
+				pack.end())) {
+			_sets.erase(i);
+			i = _sets.end();
+		}
+	}
+	if (i == _sets.end()) {
+		auto set = std::make_unique<Set>();
+		set->documents = std::vector<DocumentData*>(pack.begin(), pack.end());
+		for (const auto document : set->documents) {
+			if (document) {
+				set->ids.emplace(document->id);
+			}
+		}
+		set->generation = ++_generation;
+		i = _sets.emplace(setId, std::move(set)).first;
+	}
+	auto &set = *i->second;
+
+	struct Job {
+		int index = 0;
+		Source source;
+		QSize size;
+	};
+	auto jobs = std::vector<Job>();
+	const auto factor = cIntRetinaFactor();
+	for (auto index = 0, count = int(set.documents.size()); index != count; ++index) {
+		const auto document = set.documents[index];
+		if (!document
+			|| !document->sticker()
+			|| set.cells.contains(document->id)
+			|| set.decoding.contains(document->id)
+			|| set.unavailable.contains(document->id)) {
+			continue;
+		}
+		auto source = Source();
+		switch (ResolveSource(document, source)) {
+		case SourceState::Loading: continue;
+		case SourceState::Unavailable:
+			set.unavailable.emplace(document->id);
+			continue;
+		case SourceState::Ready: break;
+		}
+		set.decoding.emplace(document->id);
+		jobs.push_back({
+			index,
+			std::move(source),
+			StickerDisplaySize(document, _box) * factor });
+	}
+	if (jobs.empty()) {
+		return;
+	}
+	const auto generation = set.generation;
+	const auto weak = base::make_weak(this);
+	crl::async([=, jobs = std::move(jobs)]() mutable {
+		auto list = std::vector<Decoded>();
+		list.reserve(jobs.size());
+		for (auto &job : jobs) {
+			list.push_back({ job.index, Decode(std::move(job.source), job.size) });
+		}
+		crl::on_main(weak, [=, list = std::move(list)]() mutable {
+			apply(setId, generation, std::move(list));
+		});
+	});
+}
+
+void StickersAtlas::apply(
+		uint64 setId,
+		int generation,
+		std::vector<Decoded> &&list) {
+	const auto i = _sets.find(setId);
+	if (i == _sets.end() || i->second->generation != generation) {
+		return;
+	}
+	auto &set = *i->second;
+	const auto cell = _box * cIntRetinaFactor();
+	if (set.atlas.isNull()) {
+		const auto count = int(set.documents.size());
+		const auto columns = std::min(count, kAtlasColumns);
+		const auto rows = (count + kAtlasColumns - 1) / kAtlasColumns;
+		set.atlas = QPixmap(columns * cell.width(), rows * cell.height());
+		set.atlas.fill(Qt::transparent);
+		acquireImageCacheMemory(PixmapMemory(set.atlas));
+	}
+	{
+		QPainter p(&set.atlas);
+		p.setCompositionMode(QPainter::CompositionMode_Source);
+		for (auto &decoded : list) {
+			const auto id = set.documents[decoded.index]->id;
+			set.decoding.remove(id);
+			if (decoded.image.isNull()) {
+				set.unavailable.emplace(id);
+				continue;
+			}
+			const auto position = QPoint(
+				(decoded.index % kAtlasColumns) * cell.width(),
+				(decoded.index / kAtlasColumns) * cell.height());
+			p.drawImage(position, decoded.image);
+			set.cells.emplace(id, QRect(position, decoded.image.size()));
+		}
+	}
+	if (_updated) {
+		_updated();
+	}
+}
+
+void StickersAtlas::keep(const base::flat_set<uint64> &setIds) {
+	for (auto i = _sets.begin(); i != _sets.end();) {
+		if (setIds.contains(i->first)) {
+			++i;
+		} else {
+			i = _sets.erase(i);
+		}
+	}
+}
+
+void StickersAtlas::clear() {
+	_sets.clear();
+}
+
+bool StickersAtlas::paint(
+		Painter &p,
+		uint64 setId,
+		not_null<DocumentData*> document,
+		QPoint position,
+		int outerWidth) const {
+	const auto i = _sets.find(setId);
+	if (i == _sets.end() || i->second->unavailable.contains(document->id)) {
+		return false;
+	}
+	const auto &set = *i->second;
+	const auto j = set.cells.find(document->id);
+	if (j != set.cells.end()) {
+		p.drawPixmapLeft(
+			QRect(position, StickerDisplaySize(document, _box)),
+			outerWidth,
+			set.atlas,
+			j->second);
+		return true;
+	}
+	return set.ids.contains(document->id);
+}
+
+bool StickersAtlas::ready(uint64 setId) const {
+	const auto i = _sets.find(setId);
+	if (i == _sets.end()) {
+		return false;
+	}
+	const auto &set = *i->second;
+	return std::all_of(
+		set.documents.begin(),
+		set.documents.end(),
+		[&](DocumentData *document) {
+			return !document
+				|| !document->sticker()
+				|| set.cells.contains(document->id)
+				|| set.unavailable.contains(document->id);
+		});
+}
+
+int StickersAtlas::preparedCount() const {
+	return int(_sets.size());
+}
+
+} // namespace ChatHelpers
@@ -0,0 +1,62 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "chat_helpers/stickers.h"
+#include "base/weak_ptr.h"
+
+class Painter;
+
+namespace ChatHelpers {
+
+QSize StickerDisplaySize(not_null<DocumentData*> document, QSize box);
+
+// Decodes stickers of the whole set on background threads at the
+// display size and keeps them in a single pixmap per set, so painting
+// of the stickers panel never decodes or scales anything itself.
+class StickersAtlas : public base::has_weak_ptr {
+public:
+	explicit StickersAtlas(Fn<void()> updated);
+
+	// Changing the box drops all the prepared sets.
+	void setBox(QSize box);
+
+	// Requests loading of the missing stickers and decodes the loaded
+	// ones, call again after the downloads finish to decode the rest.
+	void prepare(uint64 setId, const Stickers::Pack &pack);
+
+	// Drops all the sets that are not in the list.
+	void keep(const base::flat_set<uint64> &setIds);
+	void clear();
+
+	// Returns false if the sticker can't be painted from the atlas.
+	// If it is not decoded yet nothing is painted, but true is returned.
+	bool paint(
+		Painter &p,
+		uint64 setId,
+		not_null<DocumentData*> document,
+		QPoint position,
+		int outerWidth) const;
+
+	bool ready(uint64 setId) const;
+	int preparedCount() const;
+
+private:
+	struct Set;
+	struct Decoded;
+
+	void apply(uint64 setId, int generation, std::vector<Decoded> &&list);
+
+	Fn<void()> _updated;
+	QSize _box;
+	base::flat_map<uint64, std::unique_ptr<Set>> _sets;
+	int _generation = 0;
+
+};
+
+} // namespace ChatHelpers
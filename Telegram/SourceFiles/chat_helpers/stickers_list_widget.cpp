@@ -33,6 +33,8 @@ namespace {
 constexpr auto kInlineItemsMaxPerRow = 5;
 constexpr auto kSearchRequestDelay = 400;
 constexpr auto kRecentDisplayLimit = 20;
+constexpr auto kPrepareSetsAhead = 2;
+constexpr auto kKeepSetsAround = 6;
 
 bool SetInMyList(MTPDstickerSet::Flags flags) {
 	return (flags & MTPDstickerSet::Flag::f_installed_date)
@@ -630,7 +632,7 @@ void StickersListWidget::Footer::paintSetIcon(
 	if (icon.sticker) {
 		const auto origin = icon.sticker->stickerSetOrigin();
 		icon.sticker->thumb->load(origin);
-		auto pix = icon.sticker->thumb->pix(origin, icon.pixw, icon.pixh);
+		auto pix = icon.sticker->thumb->pixAsync(origin, icon.pixw, icon.pixh);
 
 		p.drawPixmapLeft(x + (st::stickerIconWidth - icon.pixw) / 2, _iconsTop + (st::emojiFooterHeight - icon.pixh) / 2, width(), pix);
 	} else if (icon.megagroup) {
@@ -678,6 +680,7 @@ StickersListWidget::StickersListWidget(QWidget *parent, not_null<Window::Control
 , _addText(lang(lng_stickers_featured_add).toUpper())
 , _addWidth(st::stickersTrendingAdd.font->width(_addText))
 , _settings(this, lang(lng_stickers_you_have))
+, _atlas([=] { atlasUpdated(); })
 , _searchRequestTimer([=] { sendSearchRequest(); }) {
 	setMouseTracking(true);
 	setAttribute(Qt::WA_OpaquePaintEvent);
@@ -690,8 +693,9 @@ StickersListWidget::StickersListWidget(QWidget *parent, not_null<Window::Control
 	subscribe(Auth().downloaderTaskFinished(), [this] {
 		update();
 		readVisibleSets();
+		prepareVisibleSets();
 	});
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(Notify::PeerUpdate::Flag::ChannelStickersChanged, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(Notify::PeerUpdate::Flag::ChannelStickersChanged), Notify::PeerUpdatedHandler("StickersListWidget::StickersListWidget", [this](const Notify::PeerUpdate &update) {
 		if (update.peer == _megagroupSet) {
 			refreshStickers();
 		}
@@ -713,9 +717,55 @@ void StickersListWidget::visibleTopBottomUpdated(
 	if (_section == Section::Featured) {
 		readVisibleSets();
 	}
+	prepareVisibleSets();
 	validateSelectedIcon(ValidateIconAnimations::Full);
 }
 
+void StickersListWidget::prepareVisibleSets() {
+	const auto &sets = shownSets();
+	const auto count = int(sets.size());
+	if (!count || getVisibleBottom() <= getVisibleTop()) {
+		return;
+	}
+	const auto from = sectionInfoByOffset(getVisibleTop()).section;
+	const auto till = sectionInfoByOffset(getVisibleBottom() - 1).section + 1;
+
+	auto keep = base::flat_set<uint64>();
+	const auto keepFrom = std::max(from - kKeepSetsAround, 0);
+	const auto keepTill = std::min(till + kKeepSetsAround, count);
+	for (auto i = keepFrom; i != keepTill; ++i) {
+		keep.emplace(sets[i].id);
+	}
+	_atlas.keep(keep);
+
+	const auto prepareTill = std::min(till + kPrepareSetsAhead, count);
+	for (auto i = from; i != prepareTill; ++i) {
+		const auto &set = sets[i];
+		_atlas.prepare(set.id, set.externalLayout
+			? set.pack.mid(0, _columnCount)
+			: set.pack);
+	}
+}
+
+void StickersListWidget::atlasUpdated() {
+	update();
+	if (!_fullPanelStart) {
+		return;
+	}
+	const auto &sets = shownSets();
+	const auto from = sectionInfoByOffset(getVisibleTop()).section;
+	const auto till = sectionInfoByOffset(getVisibleBottom() - 1).section + 1;
+	for (auto i = from; i < till && i < int(sets.size()); ++i) {
+		if (!_atlas.ready(sets[i].id)) {
+			return;
+		}
+	}
+	DEBUG_LOG(("Stickers Panel: full panel decoded in %1 ms, %2 sets prepared."
+		).arg(getms() - _fullPanelStart
+		).arg(_atlas.preparedCount()));
+	_fullPanelStart = 0;
+}
+
 void StickersListWidget::readVisibleSets() {
 	auto itemsVisibleTop = getVisibleTop();
 	auto itemsVisibleBottom = getVisibleBottom();
@@ -821,6 +871,9 @@ int StickersListWidget::countDesiredHeight(int newWidth) {
 		- rowsRight
 		- st::buttonRadius;
 	_singleSize = QSize(singleWidth, singleWidth);
+	_atlas.setBox(QSize(
+		singleWidth - st::buttonRadius * 2,
+		singleWidth - st::buttonRadius * 2));
 	setColumnCount(columnCount);
 
 	auto visibleHeight = minimalHeight();
@@ -1319,25 +1372,27 @@ void StickersListWidget::paintSticker(Painter &p, Set &set, int y, int index, bo
 		App::roundRect(p, QRect(tl, _singleSize), st::emojiPanHover, StickerHoverCorners);
 	}
 
-	document->checkStickerThumb();
-
-	auto coef = qMin((_singleSize.width() - st::buttonRadius * 2) / float64(document->dimensions.width()), (_singleSize.height() - st::buttonRadius * 2) / float64(document->dimensions.height()));
-	if (coef > 1) coef = 1;
-	auto w = qMax(qRound(coef * document->dimensions.width()), 1);
-	auto h = qMax(qRound(coef * document->dimensions.height()), 1);
+	const auto size = StickerDisplaySize(document, QSize(
+		_singleSize.width() - st::buttonRadius * 2,
+		_singleSize.height() - st::buttonRadius * 2));
+	auto w = size.width();
+	auto h = size.height();
 	auto ppos = pos + QPoint((_singleSize.width() - w) / 2, (_singleSize.height() - h) / 2);
-	if (const auto image = document->getStickerThumb()) {
-		if (image->loaded()) {
-			p.drawPixmapLeft(
-				ppos,
-				width(),
-				image->pixSingle(
-					document->stickerSetOrigin(),
-					w,
-					h,
-					w,
-					h,
-					ImageRoundRadius::None));
+	if (!_atlas.paint(p, set.id, document, ppos, width())) {
+		document->checkStickerThumb();
+		if (const auto image = document->getStickerThumb()) {
+			if (image->loaded()) {
+				p.drawPixmapLeft(
+					ppos,
+					width(),
+					image->pixSingle(
+						document->stickerSetOrigin(),
+						w,
+						h,
+						w,
+						h,
+						ImageRoundRadius::None));
+			}
 		}
 	}
 
@@ -1754,21 +1809,19 @@ void StickersListWidget::refreshFooterIcons() {
 }
 
 void StickersListWidget::preloadImages() {
+	_fullPanelStart = getms();
+
+	// Decode the first sets, the rest is prepared on scroll.
 	auto &sets = shownSets();
 	for (int i = 0, l = sets.size(), k = 0; i < l; ++i) {
-		int count = sets[i].pack.size();
+		auto pack = sets[i].pack;
 		if (sets[i].externalLayout) {
-			accumulate_min(count, _columnCount);
+			pack = pack.mid(0, _columnCount);
 		}
-		for (int j = 0; j != count; ++j) {
-			if (++k > _columnCount * (_columnCount + 1)) break;
+		_atlas.prepare(sets[i].id, pack);
 
-			const auto document = sets[i].pack[j];
-			if (!document || !document->sticker()) continue;
-
-			document->checkStickerThumb();
-		}
-		if (k > _columnCount * (_columnCount + 1)) break;
+		k += pack.size();
+		if (k >= _columnCount * (_columnCount + 1)) break;
 	}
 	if (_footer) {
 		_footer->preloadImages();
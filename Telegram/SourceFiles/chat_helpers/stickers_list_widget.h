@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "chat_helpers/tabbed_selector.h"
 #include "chat_helpers/stickers.h"
+#include "chat_helpers/stickers_atlas.h"
 #include "base/variant.h"
 #include "base/timer.h"
 
@@ -203,6 +204,8 @@ private:
 	const std::vector<Set> &shownSets() const;
 	int featuredRowHeight() const;
 	void readVisibleSets();
+	void prepareVisibleSets();
+	void atlasUpdated();
 
 	void paintFeaturedStickers(Painter &p, QRect clip);
 	void paintStickers(Painter &p, QRect clip);
@@ -266,6 +269,9 @@ private:
 	int _columnCount = 1;
 	QSize _singleSize;
 
+	StickersAtlas _atlas;
+	TimeMs _fullPanelStart = 0;
+
 	OverState _selected;
 	OverState _pressed;
 	QPoint _lastMousePosition;
@@ -286,7 +286,7 @@ TabbedSelector::TabbedSelector(QWidget *parent, not_null<Window::Controller*> co
 	_bottomShadow->raise();
 	_tabsSlider->raise();
 
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(Notify::PeerUpdate::Flag::ChannelRightsChanged, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(Notify::PeerUpdate::Flag::ChannelRightsChanged), Notify::PeerUpdatedHandler("TabbedSelector::TabbedSelector", [this](const Notify::PeerUpdate &update) {
 		if (update.peer == _currentPeer) {
 			checkRestrictedPeer();
 		}
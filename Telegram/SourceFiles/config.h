@@ -25,6 +25,7 @@ enum {
 	MTPCheckResendTimeout = 10000, // how much time passed from send till we resend request or check it's state, in ms
 	MTPCheckResendWaiting = 1000, // how much time to wait for some more requests, when resending request or checking it's state, in ms
 	MTPAckSendWaiting = 10000, // how much time to wait for some more requests, when sending msg acks
+	MTPBatchSendWaiting = 5, // how much time to collect a burst of requests in one container after a recent send, in ms
 	MTPResendThreshold = 1, // how much ints should message contain for us not to resend, but to check it's state
 	MTPContainerLives = 600, // container lives 10 minutes in haveSent map
 
@@ -20,6 +20,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 extern "C" {
 #include <openssl/rsa.h>
+#include <openssl/sha.h>
 #include <openssl/pem.h>
 #include <openssl/bio.h>
 #include <openssl/err.h>
@@ -48,6 +49,10 @@ constexpr auto kUpdaterTimeout = 10 * TimeMs(1000);
 constexpr auto kMaxResponseSize = 1024 * 1024;
 constexpr auto kMaxUpdateSize = 256 * 1024 * 1024;
 constexpr auto kChunkSize = 128 * 1024;
+constexpr auto kUnpackChunkSize = 64 * 1024;
+constexpr auto kDeltaPackageMarker = quint32(0x7FFFFFFE);
+constexpr auto kPatchCopy = quint8(0);
+constexpr auto kPatchAdd = quint8(1);
 
 #ifdef TDESKTOP_DISABLE_AUTOUPDATE
 bool UpdaterIsDisabled = true;
@@ -57,12 +62,21 @@ bool UpdaterIsDisabled = false;
 
 std::weak_ptr<Updater> UpdaterInstance;
 
+// Set if a delta package failed to apply, full packages are used after.
+bool DeltaUpdatesFailed = false;
+
 using ErrorSignal = void(QNetworkReply::*)(QNetworkReply::NetworkError);
 const auto QNetworkReply_error = ErrorSignal(&QNetworkReply::error);
 
 using Progress = UpdateChecker::Progress;
 using State = UpdateChecker::State;
 
+enum class UnpackResult {
+	Ready,
+	Failed,
+	DeltaFailed,
+};
+
 #ifdef Q_OS_WIN
 using VersionInt = DWORD;
 using VersionChar = WCHAR;
@@ -343,7 +357,7 @@ QString FindUpdateFile() {
 			"tmac32upd|"
 			"tlinuxupd|"
 			"tlinux32upd"
-			")\\d+(_[a-z\\d]+)?$",
+			")\\d+(_[a-z\\d]+){0,2}$",
 			QRegularExpression::CaseInsensitiveOption
 		).match(info.fileName()).hasMatch()) {
 			return info.absoluteFilePath();
@@ -362,87 +376,47 @@ QString ExtractFilename(const QString &url) {
 	return QString();
 }
 
-bool UnpackUpdate(const QString &filepath) {
-	QFile input(filepath);
-	QByteArray packed;
-	if (!input.open(QIODevice::ReadOnly)) {
-		LOG(("Update Error: cant read updates file!"));
-		return false;
-	}
-
-#ifdef Q_OS_WIN // use Lzma SDK for win
-	const int32 hSigLen = 128, hShaLen = 20, hPropsLen = LZMA_PROPS_SIZE, hOriginalSizeLen = sizeof(int32), hSize = hSigLen + hShaLen + hPropsLen + hOriginalSizeLen; // header
-#else // Q_OS_WIN
-	const int32 hSigLen = 128, hShaLen = 20, hPropsLen = 0, hOriginalSizeLen = sizeof(int32), hSize = hSigLen + hShaLen + hOriginalSizeLen; // header
-#endif // Q_OS_WIN
+#ifndef Q_OS_WIN
+// Decompresses the .xz stream from the update file while it is being read,
+// so that neither the packed nor the unpacked update is kept in memory.
+class LzmaReader final : public QIODevice {
+public:
+	LzmaReader(not_null<QIODevice*> input, qint64 size);
 
-	QByteArray compressed = input.readAll();
-	int32 compressedLen = compressed.size() - hSize;
-	if (compressedLen <= 0) {
-		LOG(("Update Error: bad compressed size: %1").arg(compressed.size()));
-		return false;
-	}
-	input.close();
+	bool start();
+	bool isSequential() const override;
 
-	QString tempDirPath = cWorkingDir() + qsl("tupdates/temp"), readyFilePath = cWorkingDir() + qsl("tupdates/temp/ready");
-	psDeleteDir(tempDirPath);
+	// Checks that all the input was decompressed to the expected size.
+	bool finish(qint64 unpackedSize);
 
-	QDir tempDir(tempDirPath);
-	if (tempDir.exists() || QFile(readyFilePath).exists()) {
-		LOG(("Update Error: cant clear tupdates/temp dir!"));
-		return false;
-	}
+	~LzmaReader();
 
-	uchar sha1Buffer[20];
-	bool goodSha1 = !memcmp(compressed.constData() + hSigLen, hashSha1(compressed.constData() + hSigLen + hShaLen, compressedLen + hPropsLen + hOriginalSizeLen, sha1Buffer), hShaLen);
-	if (!goodSha1) {
-		LOG(("Update Error: bad SHA1 hash of update file!"));
-		return false;
-	}
-
-	RSA *pbKey = PEM_read_bio_RSAPublicKey(BIO_new_mem_buf(const_cast<char*>(AppAlphaVersion ? UpdatesPublicAlphaKey : UpdatesPublicKey), -1), 0, 0, 0);
-	if (!pbKey) {
-		LOG(("Update Error: cant read public rsa key!"));
-		return false;
-	}
-	if (RSA_verify(NID_sha1, (const uchar*)(compressed.constData() + hSigLen), hShaLen, (const uchar*)(compressed.constData()), hSigLen, pbKey) != 1) { // verify signature
-		RSA_free(pbKey);
-		if (cAlphaVersion() || cBetaVersion()) { // try other public key, if we are in alpha or beta version
-			pbKey = PEM_read_bio_RSAPublicKey(BIO_new_mem_buf(const_cast<char*>(AppAlphaVersion ? UpdatesPublicKey : UpdatesPublicAlphaKey), -1), 0, 0, 0);
-			if (!pbKey) {
-				LOG(("Update Error: cant read public rsa key!"));
-				return false;
-			}
-			if (RSA_verify(NID_sha1, (const uchar*)(compressed.constData() + hSigLen), hShaLen, (const uchar*)(compressed.constData()), hSigLen, pbKey) != 1) { // verify signature
-				RSA_free(pbKey);
-				LOG(("Update Error: bad RSA signature of update file!"));
-				return false;
-			}
-		} else {
-			LOG(("Update Error: bad RSA signature of update file!"));
-			return false;
-		}
-	}
-	RSA_free(pbKey);
+protected:
+	qint64 readData(char *data, qint64 maxSize) override;
+	qint64 writeData(const char *data, qint64 maxSize) override;
 
-	QByteArray uncompressed;
+private:
+	not_null<QIODevice*> _input;
+	qint64 _inputLeft = 0;
+	QByteArray _buffer;
+	lzma_stream _stream = LZMA_STREAM_INIT;
+	bool _initialized = false;
+	bool _finished = false;
+	bool _failed = false;
 
-	int32 uncompressedLen;
-	memcpy(&uncompressedLen, compressed.constData() + hSigLen + hShaLen + hPropsLen, hOriginalSizeLen);
-	uncompressed.resize(uncompressedLen);
+};
 
-	size_t resultLen = uncompressed.size();
-#ifdef Q_OS_WIN // use Lzma SDK for win
-	SizeT srcLen = compressedLen;
-	int uncompressRes = LzmaUncompress((uchar*)uncompressed.data(), &resultLen, (const uchar*)(compressed.constData() + hSize), &srcLen, (const uchar*)(compressed.constData() + hSigLen + hShaLen), LZMA_PROPS_SIZE);
-	if (uncompressRes != SZ_OK) {
-		LOG(("Update Error: could not uncompress lzma, code: %1").arg(uncompressRes));
-		return false;
-	}
-#else // Q_OS_WIN
-	lzma_stream stream = LZMA_STREAM_INIT;
+LzmaReader::LzmaReader(not_null<QIODevice*> input, qint64 size)
+: _input(input)
+, _inputLeft(size)
+, _buffer(kUnpackChunkSize, Qt::Uninitialized) {
+}
 
-	lzma_ret ret = lzma_stream_decoder(&stream, UINT64_MAX, LZMA_CONCATENATED);
+bool LzmaReader::start() {
+	const auto ret = lzma_stream_decoder(
+		&_stream,
+		UINT64_MAX,
+		LZMA_CONCATENATED);
 	if (ret != LZMA_OK) {
 		const char *msg;
 		switch (ret) {
@@ -454,47 +428,185 @@ bool UnpackUpdate(const QString &filepath) {
 		LOG(("Error initializing the decoder: %1 (error code %2)").arg(msg).arg(ret));
 		return false;
 	}
+	_initialized = true;
+	return open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+bool LzmaReader::isSequential() const {
+	return true;
+}
+
+qint64 LzmaReader::readData(char *data, qint64 maxSize) {
+	if (_failed) {
+		return -1;
+	}
+	_stream.next_out = reinterpret_cast<uint8_t*>(data);
+	_stream.avail_out = maxSize;
+	while (_stream.avail_out > 0 && !_finished) {
+		if (!_stream.avail_in && _inputLeft > 0) {
+			const auto read = _input->read(
+				_buffer.data(),
+				std::min(qint64(_buffer.size()), _inputLeft));
+			if (read <= 0) {
+				LOG(("Update Error: cant read updates file!"));
+				_failed = true;
+				return -1;
+			}
+			_inputLeft -= read;
+			_stream.next_in = reinterpret_cast<const uint8_t*>(
+				_buffer.constData());
+			_stream.avail_in = read;
+		}
+		const auto res = lzma_code(
+			&_stream,
+			(_inputLeft > 0) ? LZMA_RUN : LZMA_FINISH);
+		if (res == LZMA_STREAM_END) {
+			_finished = true;
+		} else if (res != LZMA_OK) {
+			const char *msg;
+			switch (res) {
+			case LZMA_MEM_ERROR: msg = "Memory allocation failed"; break;
+			case LZMA_FORMAT_ERROR: msg = "The input data is not in the .xz format"; break;
+			case LZMA_OPTIONS_ERROR: msg = "Unsupported compression options"; break;
+			case LZMA_DATA_ERROR: msg = "Compressed file is corrupt"; break;
+			case LZMA_BUF_ERROR: msg = "Compressed data is truncated or otherwise corrupt"; break;
+			default: msg = "Unknown error, possibly a bug"; break;
+			}
+			LOG(("Error in decompression: %1 (error code %2)").arg(msg).arg(res));
+			_failed = true;
+			return -1;
+		}
+	}
+	return maxSize - qint64(_stream.avail_out);
+}
 
-	stream.avail_in = compressedLen;
-	stream.next_in = (uint8_t*)(compressed.constData() + hSize);
-	stream.avail_out = resultLen;
-	stream.next_out = (uint8_t*)uncompressed.data();
+qint64 LzmaReader::writeData(const char *data, qint64 maxSize) {
+	return -1;
+}
 
-	lzma_ret res = lzma_code(&stream, LZMA_FINISH);
-	if (stream.avail_in) {
-		LOG(("Error in decompression, %1 bytes left in _in of %2 whole.").arg(stream.avail_in).arg(compressedLen));
+bool LzmaReader::finish(qint64 unpackedSize) {
+	auto extra = char(0);
+	if (readData(&extra, 1) != 0) {
+		if (!_failed) {
+			LOG(("Error in decompression, more than %1 bytes unpacked."
+				).arg(unpackedSize));
+		}
 		return false;
-	} else if (stream.avail_out) {
-		LOG(("Error in decompression, %1 bytes free left in _out of %2 whole.").arg(stream.avail_out).arg(resultLen));
+	} else if (_stream.avail_in || _inputLeft) {
+		LOG(("Error in decompression, %1 bytes left in _in."
+			).arg(_stream.avail_in + _inputLeft));
+		return false;
+	} else if (_stream.total_out != unpackedSize) {
+		LOG(("Error in decompression, %1 bytes unpacked of %2 whole."
+			).arg(_stream.total_out
+			).arg(unpackedSize));
 		return false;
 	}
-	lzma_end(&stream);
-	if (res != LZMA_OK && res != LZMA_STREAM_END) {
-		const char *msg;
-		switch (res) {
-		case LZMA_MEM_ERROR: msg = "Memory allocation failed"; break;
-		case LZMA_FORMAT_ERROR: msg = "The input data is not in the .xz format"; break;
-		case LZMA_OPTIONS_ERROR: msg = "Unsupported compression options"; break;
-		case LZMA_DATA_ERROR: msg = "Compressed file is corrupt"; break;
-		case LZMA_BUF_ERROR: msg = "Compressed data is truncated or otherwise corrupt"; break;
-		default: msg = "Unknown error, possibly a bug"; break;
+	return true;
+}
+
+LzmaReader::~LzmaReader() {
+	if (_initialized) {
+		lzma_end(&_stream);
+	}
+}
+#endif // !Q_OS_WIN
+
+// Delta packages contain patches for the installed files instead of
+// the files themselves. A patch is a list of commands, each either copies
+// a part of the installed file or adds new bytes, see packer.cpp.
+base::optional<QByteArray> ApplyUpdatePatch(
+		const QString &relativeName,
+		const QByteArray &patch,
+		quint32 size) {
+	auto original = QByteArray();
+	auto installed = QFile(cExeDir() + relativeName);
+	if (installed.exists()) {
+		if (!installed.open(QIODevice::ReadOnly)) {
+			LOG(("Update Error: cant read installed file '%1'"
+				).arg(installed.fileName()));
+			return base::none;
+		}
+		original = installed.readAll();
+	}
+
+	auto result = QByteArray();
+	result.reserve(size);
+
+	QDataStream stream(patch);
+	stream.setVersion(QDataStream::Qt_5_1);
+	while (!stream.atEnd()) {
+		quint8 command = 0;
+		stream >> command;
+		if (command == kPatchCopy) {
+			quint32 offset = 0, length = 0;
+			stream >> offset >> length;
+			if (stream.status() != QDataStream::Ok
+				|| offset > quint32(original.size())
+				|| length > quint32(original.size()) - offset) {
+				LOG(("Update Error: bad copy command in patch for '%1'"
+					).arg(relativeName));
+				return base::none;
+			}
+			result.append(original.constData() + offset, length);
+		} else if (command == kPatchAdd) {
+			auto bytes = QByteArray();
+			stream >> bytes;
+			if (stream.status() != QDataStream::Ok) {
+				LOG(("Update Error: bad add command in patch for '%1'"
+					).arg(relativeName));
+				return base::none;
+			}
+			result.append(bytes);
+		} else {
+			LOG(("Update Error: bad command %1 in patch for '%2'"
+				).arg(command
+				).arg(relativeName));
+			return base::none;
+		}
+		if (quint32(result.size()) > size) {
+			LOG(("Update Error: patch for '%1' is larger than %2"
+				).arg(relativeName
+				).arg(size));
+			return base::none;
 		}
-		LOG(("Error in decompression: %1 (error code %2)").arg(msg).arg(res));
-		return false;
 	}
-#endif // Q_OS_WIN
+	return result;
+}
 
-	tempDir.mkdir(tempDir.absolutePath());
+UnpackResult UnpackFiles(QIODevice &device, const QString &tempDirPath) {
+	QDir tempDir(tempDirPath);
+	QDataStream stream(&device);
+	stream.setVersion(QDataStream::Qt_5_1);
 
+	auto failed = UnpackResult::Failed;
 	quint32 version;
 	{
-		QDataStream stream(uncompressed);
-		stream.setVersion(QDataStream::Qt_5_1);
-
 		stream >> version;
 		if (stream.status() != QDataStream::Ok) {
 			LOG(("Update Error: cant read version from downloaded stream, status: %1").arg(stream.status()));
-			return false;
+			return failed;
+		}
+
+		auto delta = false;
+		if (version == kDeltaPackageMarker) {
+			// Any error in a delta package should fall back to the full one.
+			failed = UnpackResult::DeltaFailed;
+			delta = true;
+
+			quint64 baseVersion = 0;
+			stream >> baseVersion >> version;
+			if (stream.status() != QDataStream::Ok) {
+				LOG(("Update Error: cant read delta base version from downloaded stream, status: %1").arg(stream.status()));
+				return failed;
+			}
+			const auto installedVersion = cBetaVersion()
+				? cBetaVersion()
+				: uint64(AppVersion);
+			if (baseVersion != installedVersion) {
+				LOG(("Update Error: delta update for version %1 can't be applied to mine %2").arg(baseVersion).arg(installedVersion));
+				return failed;
+			}
 		}
 
 		quint64 betaVersion = 0;
@@ -502,60 +614,82 @@ bool UnpackUpdate(const QString &filepath) {
 			stream >> betaVersion;
 			if (stream.status() != QDataStream::Ok) {
 				LOG(("Update Error: cant read beta version from downloaded stream, status: %1").arg(stream.status()));
-				return false;
+				return failed;
 			}
 			if (!cBetaVersion() || betaVersion <= cBetaVersion()) {
 				LOG(("Update Error: downloaded beta version %1 is not greater, than mine %2").arg(betaVersion).arg(cBetaVersion()));
-				return false;
+				return failed;
 			}
 		} else if (int32(version) <= AppVersion) {
 			LOG(("Update Error: downloaded version %1 is not greater, than mine %2").arg(version).arg(AppVersion));
-			return false;
+			return failed;
 		}
 
 		quint32 filesCount;
 		stream >> filesCount;
 		if (stream.status() != QDataStream::Ok) {
 			LOG(("Update Error: cant read files count from downloaded stream, status: %1").arg(stream.status()));
-			return false;
+			return failed;
 		}
 		if (!filesCount) {
 			LOG(("Update Error: update is empty!"));
-			return false;
+			return failed;
 		}
 		for (uint32 i = 0; i < filesCount; ++i) {
 			QString relativeName;
 			quint32 fileSize;
 			QByteArray fileInnerData;
+			QByteArray fileSha1;
 			bool executable = false;
 
 			stream >> relativeName >> fileSize >> fileInnerData;
+			if (delta) {
+				stream >> fileSha1;
+			}
 #if defined Q_OS_MAC || defined Q_OS_LINUX
 			stream >> executable;
 #endif // Q_OS_MAC || Q_OS_LINUX
 			if (stream.status() != QDataStream::Ok) {
 				LOG(("Update Error: cant read file from downloaded stream, status: %1").arg(stream.status()));
-				return false;
+				return failed;
+			}
+			if (delta) {
+				auto patched = ApplyUpdatePatch(
+					relativeName,
+					fileInnerData,
+					fileSize);
+				if (!patched) {
+					return failed;
+				}
+				fileInnerData = std::move(*patched);
+				const auto sha1 = hashSha1(
+					fileInnerData.constData(),
+					fileInnerData.size());
+				if (fileSha1.size() != sha1.size()
+					|| memcmp(fileSha1.constData(), sha1.data(), sha1.size())) {
+					LOG(("Update Error: bad SHA1 hash of patched file '%1'").arg(relativeName));
+					return failed;
+				}
 			}
 			if (fileSize != quint32(fileInnerData.size())) {
 				LOG(("Update Error: bad file size %1 not matching data size %2").arg(fileSize).arg(fileInnerData.size()));
-				return false;
+				return failed;
 			}
 
 			QFile f(tempDirPath + '/' + relativeName);
 			if (!QDir().mkpath(QFileInfo(f).absolutePath())) {
 				LOG(("Update Error: cant mkpath for file '%1'").arg(tempDirPath + '/' + relativeName));
-				return false;
+				return failed;
 			}
 			if (!f.open(QIODevice::WriteOnly)) {
 				LOG(("Update Error: cant open file '%1' for writing").arg(tempDirPath + '/' + relativeName));
-				return false;
+				return failed;
 			}
 			auto writtenBytes = f.write(fileInnerData);
 			if (writtenBytes != fileSize) {
 				f.close();
 				LOG(("Update Error: cant write file '%1', desiredSize: %2, write result: %3").arg(tempDirPath + '/' + relativeName).arg(fileSize).arg(writtenBytes));
-				return false;
+				return failed;
 			}
 			f.close();
 			if (executable) {
@@ -577,7 +711,7 @@ bool UnpackUpdate(const QString &filepath) {
 		QFile fVersion(tempDirPath + qsl("/tdata/version"));
 		if (!fVersion.open(QIODevice::WriteOnly)) {
 			LOG(("Update Error: cant write version file '%1'").arg(tempDirPath + qsl("/version")));
-			return false;
+			return failed;
 		}
 		fVersion.write((const char*)&versionNum, sizeof(VersionInt));
 		if (versionNum == 0x7FFFFFFF) { // beta version
@@ -589,21 +723,149 @@ bool UnpackUpdate(const QString &filepath) {
 		fVersion.close();
 	}
 
+	return UnpackResult::Ready;
+}
+
+UnpackResult UnpackUpdate(const QString &filepath) {
+	QFile input(filepath);
+	if (!input.open(QIODevice::ReadOnly)) {
+		LOG(("Update Error: cant read updates file!"));
+		return UnpackResult::Failed;
+	}
+
+#ifdef Q_OS_WIN // use Lzma SDK for win
+	const int32 hSigLen = 128, hShaLen = 20, hPropsLen = LZMA_PROPS_SIZE, hOriginalSizeLen = sizeof(int32), hSize = hSigLen + hShaLen + hPropsLen + hOriginalSizeLen; // header
+#else // Q_OS_WIN
+	const int32 hSigLen = 128, hShaLen = 20, hPropsLen = 0, hOriginalSizeLen = sizeof(int32), hSize = hSigLen + hShaLen + hOriginalSizeLen; // header
+#endif // Q_OS_WIN
+
+	const auto header = input.read(hSize);
+	const auto compressedLen = input.size() - hSize;
+	if (header.size() != hSize || compressedLen <= 0) {
+		LOG(("Update Error: bad compressed size: %1").arg(input.size()));
+		return UnpackResult::Failed;
+	}
+
+	QString tempDirPath = cWorkingDir() + qsl("tupdates/temp"), readyFilePath = cWorkingDir() + qsl("tupdates/temp/ready");
+	psDeleteDir(tempDirPath);
+
+	QDir tempDir(tempDirPath);
+	if (tempDir.exists() || QFile(readyFilePath).exists()) {
+		LOG(("Update Error: cant clear tupdates/temp dir!"));
+		return UnpackResult::Failed;
+	}
+
+	// Count SHA1 of the signed part without reading the file to memory.
+	auto sha1Context = SHA_CTX();
+	SHA1_Init(&sha1Context);
+	if (!input.seek(hSigLen + hShaLen)) {
+		LOG(("Update Error: cant read updates file!"));
+		return UnpackResult::Failed;
+	}
+	auto buffer = QByteArray(kUnpackChunkSize, Qt::Uninitialized);
+	while (true) {
+		const auto read = input.read(buffer.data(), buffer.size());
+		if (read < 0) {
+			LOG(("Update Error: cant read updates file!"));
+			return UnpackResult::Failed;
+		} else if (!read) {
+			break;
+		}
+		SHA1_Update(&sha1Context, buffer.constData(), read);
+	}
+	uchar sha1Buffer[20];
+	SHA1_Final(sha1Buffer, &sha1Context);
+	bool goodSha1 = !memcmp(header.constData() + hSigLen, sha1Buffer, hShaLen);
+	if (!goodSha1) {
+		LOG(("Update Error: bad SHA1 hash of update file!"));
+		return UnpackResult::Failed;
+	}
+
+	RSA *pbKey = PEM_read_bio_RSAPublicKey(BIO_new_mem_buf(const_cast<char*>(AppAlphaVersion ? UpdatesPublicAlphaKey : UpdatesPublicKey), -1), 0, 0, 0);
+	if (!pbKey) {
+		LOG(("Update Error: cant read public rsa key!"));
+		return UnpackResult::Failed;
+	}
+	if (RSA_verify(NID_sha1, (const uchar*)(header.constData() + hSigLen), hShaLen, (const uchar*)(header.constData()), hSigLen, pbKey) != 1) { // verify signature
+		RSA_free(pbKey);
+		if (cAlphaVersion() || cBetaVersion()) { // try other public key, if we are in alpha or beta version
+			pbKey = PEM_read_bio_RSAPublicKey(BIO_new_mem_buf(const_cast<char*>(AppAlphaVersion ? UpdatesPublicKey : UpdatesPublicAlphaKey), -1), 0, 0, 0);
+			if (!pbKey) {
+				LOG(("Update Error: cant read public rsa key!"));
+				return UnpackResult::Failed;
+			}
+			if (RSA_verify(NID_sha1, (const uchar*)(header.constData() + hSigLen), hShaLen, (const uchar*)(header.constData()), hSigLen, pbKey) != 1) { // verify signature
+				RSA_free(pbKey);
+				LOG(("Update Error: bad RSA signature of update file!"));
+				return UnpackResult::Failed;
+			}
+		} else {
+			LOG(("Update Error: bad RSA signature of update file!"));
+			return UnpackResult::Failed;
+		}
+	}
+	RSA_free(pbKey);
+
+	int32 uncompressedLen;
+	memcpy(&uncompressedLen, header.constData() + hSigLen + hShaLen + hPropsLen, hOriginalSizeLen);
+	if (!input.seek(hSize)) {
+		LOG(("Update Error: cant read updates file!"));
+		return UnpackResult::Failed;
+	}
+
+#ifdef Q_OS_WIN // use Lzma SDK for win
+	// LzmaUncompress() needs the whole packed and unpacked data in memory.
+	const auto compressed = input.read(compressedLen);
+	if (compressed.size() != compressedLen) {
+		LOG(("Update Error: cant read updates file!"));
+		return UnpackResult::Failed;
+	}
+	QByteArray uncompressed;
+	uncompressed.resize(uncompressedLen);
+
+	size_t resultLen = uncompressed.size();
+	SizeT srcLen = compressedLen;
+	int uncompressRes = LzmaUncompress((uchar*)uncompressed.data(), &resultLen, (const uchar*)compressed.constData(), &srcLen, (const uchar*)(header.constData() + hSigLen + hShaLen), LZMA_PROPS_SIZE);
+	if (uncompressRes != SZ_OK) {
+		LOG(("Update Error: could not uncompress lzma, code: %1").arg(uncompressRes));
+		return UnpackResult::Failed;
+	}
+	QBuffer unpacked(&uncompressed);
+	unpacked.open(QIODevice::ReadOnly);
+#else // Q_OS_WIN
+	LzmaReader unpacked(&input, compressedLen);
+	if (!unpacked.start()) {
+		return UnpackResult::Failed;
+	}
+#endif // Q_OS_WIN
+
+	tempDir.mkdir(tempDir.absolutePath());
+
+	const auto result = UnpackFiles(unpacked, tempDirPath);
+	if (result != UnpackResult::Ready) {
+		return result;
+	}
+#ifndef Q_OS_WIN
+	if (!unpacked.finish(uncompressedLen)) {
+		return UnpackResult::Failed;
+	}
+#endif // !Q_OS_WIN
+
 	QFile readyFile(readyFilePath);
 	if (readyFile.open(QIODevice::WriteOnly)) {
 		if (readyFile.write("1", 1)) {
 			readyFile.close();
 		} else {
 			LOG(("Update Error: cant write ready file '%1'").arg(readyFilePath));
-			return false;
+			return UnpackResult::Failed;
 		}
 	} else {
 		LOG(("Update Error: cant create ready file '%1'").arg(readyFilePath));
-		return false;
+		return UnpackResult::Failed;
 	}
 	input.remove();
 
-	return true;
+	return UnpackResult::Ready;
 }
 
 base::optional<MTPInputChannel> ExtractChannel(
@@ -624,6 +886,27 @@ base::optional<MTPInputChannel> ExtractChannel(
 	return base::none;
 }
 
+// Delta packages are listed by the installed version they apply to:
+// "delta": { "1004005": "tlinuxupd1004006_delta1004005", ... }
+QString FindDeltaLink(const QJsonObject &map) {
+	if (DeltaUpdatesFailed) {
+		return QString();
+	}
+	const auto deltas = map.constFind("delta");
+	if (deltas == map.constEnd() || !(*deltas).isObject()) {
+		return QString();
+	}
+	const auto installedVersion = cBetaVersion()
+		? cBetaVersion()
+		: uint64(AppVersion);
+	const auto list = (*deltas).toObject();
+	const auto link = list.constFind(QString::number(installedVersion));
+	if (link == list.constEnd() || !(*link).isString()) {
+		return QString();
+	}
+	return (*link).toString();
+}
+
 template <typename Callback>
 bool ParseCommonMap(
 		const QByteArray &json,
@@ -1010,6 +1293,11 @@ base::optional<QString> HttpChecker::parseResponse(
 			return false;
 		}
 		bestLink = (*link).toString();
+		if (const auto delta = FindDeltaLink(map); !delta.isEmpty()) {
+			LOG(("Update Info: Using delta update for version %1."
+				).arg(version));
+			bestLink = delta;
+		}
 		return true;
 	};
 	const auto result = ParseCommonMap(response, testing(), accumulate);
@@ -1631,7 +1919,7 @@ private:
 	void checkerFail(not_null<Implementation*> which);
 
 	void finalize(QString filepath);
-	void unpackDone(bool ready);
+	void unpackDone(UnpackResult result);
 	void handleChecking();
 	void handleProgress();
 	void handleLatest();
@@ -1967,18 +2255,26 @@ void Updater::finalize(QString filepath) {
 	_activeLoader = nullptr;
 	_action = Action::Unpacking;
 	crl::async([=] {
-		const auto ready = UnpackUpdate(filepath);
+		const auto result = UnpackUpdate(filepath);
 		crl::on_main([=] {
-			GetUpdaterInstance()->unpackDone(ready);
+			GetUpdaterInstance()->unpackDone(result);
 		});
 	});
 }
 
-void Updater::unpackDone(bool ready) {
-	if (ready) {
+void Updater::unpackDone(UnpackResult result) {
+	if (result == UnpackResult::Ready) {
 		_ready.fire({});
+		return;
+	}
+	ClearAll();
+	if (result == UnpackResult::DeltaFailed && !DeltaUpdatesFailed) {
+		LOG(("Update Info: Delta update failed, loading the full one."));
+		DeltaUpdatesFailed = true;
+		stop();
+		cSetLastUpdateCheck(0);
+		start(false);
 	} else {
-		ClearAll();
 		_failed.fire({});
 	}
 }
@@ -566,6 +566,38 @@ void DocumentData::automaticLoadSettingsChanged() {
 	_loader = nullptr;
 }
 
+bool DocumentData::loadInBackground(Data::FileOrigin origin) {
+	if (loaded() || loading() || status != FileReady) {
+		return false;
+	}
+	auto filename = QString();
+	if (!saveToCache()) {
+		if (Global::AskDownloadPath()) {
+			// Don't ask for a path of a file the user didn't request.
+			return false;
+		}
+		filename = documentSaveFilename(this);
+		if (filename.isEmpty()) {
+			return false;
+		}
+	}
+	save(
+		origin,
+		filename,
+		ActionOnLoadNone,
+		FullMsgId(),
+		LoadFromCloudOrLocal,
+		true);
+	return loading();
+}
+
+bool DocumentData::loadingInBackground() const {
+	// A user request either creates a new loader or sets an action.
+	return loading()
+		&& _loader->autoLoading()
+		&& (_actionOnLoad == ActionOnLoadNone);
+}
+
 void DocumentData::performActionOnLoad() {
 	if (_actionOnLoad == ActionOnLoadNone) return;
 
@@ -1055,6 +1087,17 @@ MTPInputDocument DocumentData::mtpInput() const {
 	return MTP_inputDocumentEmpty();
 }
 
+MTP::DcId DocumentData::dcId() const {
+	return _dc;
+}
+
+MTPInputFileLocation DocumentData::mtpFileLocation() const {
+	return MTP_inputDocumentFileLocation(
+		MTP_long(id),
+		MTP_long(_access),
+		MTP_bytes(_fileReference));
+}
+
 QByteArray DocumentData::fileReference() const {
 	return _fileReference;
 }
@@ -77,6 +77,13 @@ public:
 		const HistoryItem *item); // auto load sticker or video
 	void automaticLoadSettingsChanged();
 
+	// Loads without any action when finished, for example to preload
+	// the next tracks in the player. Returns false if nothing started.
+	bool loadInBackground(Data::FileOrigin origin);
+
+	// The load started by loadInBackground() that nobody else asked for.
+	bool loadingInBackground() const;
+
 	enum FilePathResolveType {
 		FilePathResolveCached,
 		FilePathResolveChecked,
@@ -158,6 +165,8 @@ public:
 	bool hasWebLocation() const;
 	bool isValid() const;
 	MTPInputDocument mtpInput() const;
+	MTP::DcId dcId() const;
+	MTPInputFileLocation mtpFileLocation() const;
 	QByteArray fileReference() const;
 	void refreshFileReference(const QByteArray &value);
 
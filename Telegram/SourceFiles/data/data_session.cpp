@@ -188,7 +188,8 @@ void Session::forgetPassportCredentials() {
 
 void Session::setupContactViewsViewer() {
 	Notify::PeerUpdateViewer(
-		Notify::PeerUpdate::Flag::UserIsContact
+		Notify::PeerUpdate::Flag::UserIsContact,
+		"Data::Session::setupContactViewsViewer"
 	) | rpl::map([](const Notify::PeerUpdate &update) {
 		return update.peer->asUser();
 	}) | rpl::filter([](UserData *user) {
@@ -200,7 +201,8 @@ void Session::setupContactViewsViewer() {
 
 void Session::setupChannelLeavingViewer() {
 	Notify::PeerUpdateViewer(
-		Notify::PeerUpdate::Flag::ChannelAmIn
+		Notify::PeerUpdate::Flag::ChannelAmIn,
+		"Data::Session::setupChannelLeavingViewer"
 	) | rpl::map([](const Notify::PeerUpdate &update) {
 		return update.peer->asChannel();
 	}) | rpl::filter([](ChannelData *channel) {
@@ -125,7 +125,7 @@ DialogsInner::DialogsInner(QWidget *parent, not_null<Window::Controller*> contro
 		| UpdateFlag::NameChanged
 		| UpdateFlag::PhotoChanged
 		| UpdateFlag::UserIsContact;
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(changes, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(changes), Notify::PeerUpdatedHandler("DialogsInner::DialogsInner", [this](const Notify::PeerUpdate &update) {
 		if (update.flags & UpdateFlag::PinnedChanged) {
 			stopReorderPinned();
 		}
@@ -467,7 +467,9 @@ void DialogsInner::paintRegion(Painter &p, const QRegion &region, bool paintingO
 				? lang(lng_search_no_results)
 				: lng_search_found_results(
 					lt_count,
-					_searchedMigratedCount + _searchedCount);
+					(_searchedMigratedCount
+						+ _searchedCount
+						+ _searchedLocalCount));
 			p.fillRect(0, 0, fullWidth, st::searchedBarHeight, st::searchedBarBg);
 			if (!paintingOther) {
 				p.setFont(st::searchedBarFont);
@@ -1736,7 +1738,7 @@ DialogsInner::~DialogsInner() {
 void DialogsInner::clearSearchResults(bool clearPeerSearchResults) {
 	if (clearPeerSearchResults) _peerSearchResults.clear();
 	_searchResults.clear();
-	_searchedCount = _searchedMigratedCount = 0;
+	_searchedCount = _searchedMigratedCount = _searchedLocalCount = 0;
 	_lastSearchDate = 0;
 	_lastSearchPeer = 0;
 	_lastSearchId = _lastSearchMigratedId = 0;
@@ -1792,6 +1794,11 @@ void DialogsInner::itemRemoved(not_null<const HistoryItem*> item) {
 			++i;
 		}
 	}
+	_localSearchResults.erase(
+		ranges::remove_if(_localSearchResults, [&](auto entry) {
+			return (entry.get() == item.get());
+		}),
+		end(_localSearchResults));
 	if (wasCount != _searchResults.size()) {
 		refresh();
 	}
@@ -1880,10 +1887,15 @@ bool DialogsInner::searchReceived(
 		if (auto peer = App::peerLoaded(peerId)) {
 			if (lastDate) {
 				auto item = App::histories().addNewMessage(message, NewMessageExisting);
-				_searchResults.push_back(
-					std::make_unique<Dialogs::FakeRow>(
-						_searchInChat,
-						item));
+				if (!hasSearchResult(item)) {
+					_searchResults.push_back(
+						std::make_unique<Dialogs::FakeRow>(
+							_searchInChat,
+							item));
+				} else if (_searchedLocalCount > 0) {
+					// Was added from the local results already.
+					--_searchedLocalCount;
+				}
 				lastDateFound = lastDate;
 				if (isGlobalSearch) {
 					_lastSearchDate = lastDateFound;
@@ -1905,6 +1917,10 @@ bool DialogsInner::searchReceived(
 		_searchedMigratedCount = fullCount;
 	} else {
 		_searchedCount = fullCount;
+
+		// Server results of the next pages are older than lastDateFound.
+		_localSearchMinDate = lastDateFound;
+		mergeLocalSearchResults();
 	}
 	if (_waitingForSearch
 		&& (!_searchResults.empty()
@@ -1917,6 +1933,54 @@ bool DialogsInner::searchReceived(
 	return lastDateFound != 0;
 }
 
+void DialogsInner::localSearchReceived(
+		std::vector<not_null<HistoryItem*>> &&items) {
+	if (_state != State::Filtered) {
+		return;
+	}
+	_localSearchResults = std::move(items);
+	if (!_waitingForSearch) {
+		mergeLocalSearchResults();
+	} else if (!_localSearchResults.empty() || _searchedLocalCount > 0) {
+		clearSearchResults(false);
+		for (const auto item : _localSearchResults) {
+			_searchResults.push_back(
+				std::make_unique<Dialogs::FakeRow>(_searchInChat, item));
+		}
+		_searchedLocalCount = _searchResults.size();
+	}
+	refresh();
+}
+
+bool DialogsInner::hasSearchResult(not_null<HistoryItem*> item) const {
+	return ranges::find_if(_searchResults, [&](const auto &row) {
+		return (row->item() == item);
+	}) != end(_searchResults);
+}
+
+void DialogsInner::mergeLocalSearchResults() {
+	auto added = false;
+	for (auto i = begin(_localSearchResults); i != end(_localSearchResults);) {
+		const auto item = *i;
+		if (item->date() < _localSearchMinDate) {
+			++i;
+			continue;
+		} else if (!hasSearchResult(item)) {
+			_searchResults.push_back(
+				std::make_unique<Dialogs::FakeRow>(_searchInChat, item));
+			++_searchedLocalCount;
+			added = true;
+		}
+		i = _localSearchResults.erase(i);
+	}
+	if (added) {
+		ranges::stable_sort(_searchResults, std::greater<>(), [](
+				const std::unique_ptr<Dialogs::FakeRow> &row) {
+			return row->item()->date();
+		});
+	}
+}
+
 void DialogsInner::peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
@@ -2188,6 +2252,8 @@ void DialogsInner::clearFilter() {
 		_filterResultsGlobal.clear();
 		_peerSearchResults.clear();
 		_searchResults.clear();
+		_localSearchResults.clear();
+		_searchedLocalCount = 0;
 		_lastSearchDate = 0;
 		_lastSearchPeer = 0;
 		_lastSearchId = _lastSearchMigratedId = 0;
@@ -41,6 +41,10 @@ public:
 		const QVector<MTPMessage> &result,
 		DialogsSearchRequestType type,
 		int fullCount);
+
+	// Local results are shown until the server ones are received,
+	// then they are merged with the server results by date.
+	void localSearchReceived(std::vector<not_null<HistoryItem*>> &&items);
 	void peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
@@ -267,6 +271,8 @@ private:
 
 	void clearSelection();
 	void clearSearchResults(bool clearPeerSearchResults = true);
+	bool hasSearchResult(not_null<HistoryItem*> item) const;
+	void mergeLocalSearchResults();
 	void updateSelectedRow(Dialogs::Key key = Dialogs::Key());
 
 	Dialogs::IndexedList *shownDialogs() const;
@@ -344,6 +350,9 @@ private:
 	SearchResults _searchResults;
 	int _searchedCount = 0;
 	int _searchedMigratedCount = 0;
+	int _searchedLocalCount = 0;
+	std::vector<not_null<HistoryItem*>> _localSearchResults;
+	TimeId _localSearchMinDate = 0;
 	int _searchedSelected = -1;
 	int _searchedPressed = -1;
 
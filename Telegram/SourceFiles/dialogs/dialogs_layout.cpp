@@ -59,6 +59,7 @@ enum class Flag {
 	SearchResult     = 0x08,
 	SavedMessages    = 0x10,
 	FeedSearchResult = 0x20,
+	SnapshotPreview  = 0x40,
 };
 inline constexpr bool is_flag_type(Flag) { return true; }
 
@@ -187,6 +188,10 @@ void paintRow(
 			history->cloudDraftTextCache.drawElided(p, nameleft, texttop, availableWidth, 1);
 			p.restoreTextPalette();
 		}
+	} else if (!item && (flags & Flag::SnapshotPreview)) {
+		paintRowDate(p, date, rectForName, active, selected);
+
+		paintItemCallback(nameleft, namewidth);
 	} else if (!item) {
 		auto availableWidth = namewidth;
 		auto right = fullWidth;
@@ -457,7 +462,11 @@ void RowPainter::paint(
 			}
 			return ItemDateTime(item);
 		}
-		return cloudDraft ? ParseDateTime(cloudDraft->date) : QDateTime();
+		return cloudDraft
+			? ParseDateTime(cloudDraft->date)
+			: (history && !history->snapshotPreview().isEmpty())
+			? ParseDateTime(history->chatsListTimeId())
+			: QDateTime();
 	}();
 	const auto displayMentionBadge = history
 		? history->hasUnreadMentions()
@@ -489,7 +498,13 @@ void RowPainter::paint(
 	const auto flags = (active ? Flag::Active : Flag(0))
 		| (selected ? Flag::Selected : Flag(0))
 		| (onlyBackground ? Flag::OnlyBackground : Flag(0))
-		| (peer && peer->isSelf() ? Flag::SavedMessages : Flag(0));
+		| (peer && peer->isSelf() ? Flag::SavedMessages : Flag(0))
+		| ((history
+			&& !item
+			&& !cloudDraft
+			&& !history->snapshotPreview().isEmpty())
+			? Flag::SnapshotPreview
+			: Flag(0));
 	const auto paintItemCallback = [&](int nameleft, int namewidth) {
 		auto availableWidth = namewidth;
 		auto texttop = st::dialogsPadding.y() + st::msgNameFont->height + st::dialogsSkip;
@@ -583,7 +598,20 @@ void RowPainter::paint(
 			fullWidth,
 			color,
 			ms) : false;
-		if (!actionWasPainted) {
+		if (!actionWasPainted && !item) {
+			auto &cache = history->snapshotPreviewTextCache;
+			if (cache.isEmpty()) {
+				cache.setText(
+					st::dialogsTextStyle,
+					history->snapshotPreview(),
+					Ui::DialogTextOptions());
+			}
+			p.setFont(st::dialogsTextFont);
+			p.setPen(active ? st::dialogsTextFgActive : (selected ? st::dialogsTextFgOver : st::dialogsTextFg));
+			p.setTextPalette(active ? st::dialogsTextPaletteActive : (selected ? st::dialogsTextPaletteOver : st::dialogsTextPalette));
+			cache.drawElided(p, nameleft, texttop, availableWidth, 1);
+			p.restoreTextPalette();
+		} else if (!actionWasPainted) {
 			auto itemRect = QRect(
 				nameleft,
 				texttop,
@@ -67,7 +67,7 @@ void ChatSearchFromController::prepare() {
 
 	rebuildRows();
 
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(Notify::PeerUpdate::Flag::MembersChanged, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(Notify::PeerUpdate::Flag::MembersChanged), Notify::PeerUpdatedHandler("ChatSearchFromController::prepare", [this](const Notify::PeerUpdate &update) {
 		if (update.peer == _chat) {
 			rebuildRows();
 		}
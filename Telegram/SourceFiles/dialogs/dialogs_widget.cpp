@@ -33,12 +33,17 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "profile/profile_channel_controllers.h"
 #include "storage/storage_media_prepare.h"
 #include "storage/localstorage.h"
+#include "storage/storage_search_index.h"
 #include "data/data_session.h"
 #include "styles/style_dialogs.h"
 #include "styles/style_window.h"
 
 namespace {
 
+constexpr auto kDialogsSnapshotInterval = TimeMs(5 * 60 * 1000);
+constexpr auto kLocalSearchLimit = 100;
+constexpr auto kLocalSearchRequestsLimit = 20;
+
 QString SwitchToChooseFromQuery() {
 	return qsl("from:");
 }
@@ -155,6 +160,10 @@ DialogsWidget::DialogsWidget(QWidget *parent, not_null<Window::Controller*> cont
 	_chooseByDragTimer.setSingleShot(true);
 	connect(&_chooseByDragTimer, SIGNAL(timeout()), this, SLOT(onChooseByDrag()));
 
+	_snapshotTimer.setCallback([] { Local::writeDialogsSnapshot(); });
+	_snapshotTimer.callEach(kDialogsSnapshotInterval);
+	_localSearchRefreshTimer.setCallback([=] { searchLocally(); });
+
 	setAcceptDrops(true);
 
 	_searchTimer.setSingleShot(true);
@@ -402,6 +411,7 @@ void DialogsWidget::dialogsReceived(
 
 	Auth().data().moreChatsLoaded().notify();
 	if (_dialogsFull && _pinnedDialogsReceived) {
+		removeUnconfirmedSnapshot();
 		Auth().data().allChatsLoaded().set(true);
 	}
 	Auth().api().requestContacts();
@@ -475,10 +485,28 @@ void DialogsWidget::pinnedDialogsReceived(
 
 	Auth().data().moreChatsLoaded().notify();
 	if (_dialogsFull && _pinnedDialogsReceived) {
+		removeUnconfirmedSnapshot();
 		Auth().data().allChatsLoaded().set(true);
 	}
 }
 
+void DialogsWidget::restoreDialogsSnapshot() {
+	_snapshotHistories = Local::readDialogsSnapshot();
+	if (!_snapshotHistories.empty()) {
+		_inner->refresh();
+		onListScroll();
+	}
+}
+
+void DialogsWidget::removeUnconfirmedSnapshot() {
+	for (const auto history : base::take(_snapshotHistories)) {
+		if (!history->lastMessageKnown()) {
+			history->setSnapshotPreview(QString());
+			removeDialog(history);
+		}
+	}
+}
+
 void DialogsWidget::applyReceivedDialogs(
 		const QVector<MTPDialog> &dialogs,
 		const QVector<MTPMessage> &messages) {
@@ -640,7 +668,59 @@ bool DialogsWidget::searchForPeersRequired(const QString &query) const {
 	return (query[0] != '#');
 }
 
+void DialogsWidget::searchLocally() {
+	const auto query = _filter->getLastText().trimmed();
+	auto items = std::vector<not_null<HistoryItem*>>();
+	if (!query.isEmpty() && !_searchInChat.feed()) {
+		auto request = Storage::SearchIndexQuery();
+		request.query = query;
+		if (const auto peer = _searchInChat.peer()) {
+			request.peerId = peer->id;
+		}
+		if (_searchFromUser) {
+			request.fromId = _searchFromUser->id;
+		}
+		auto requested = 0;
+		for (const auto &result : Auth().searchIndex().query(request)) {
+			const auto channelId = peerToChannel(result.peerId);
+			const auto fullId = FullMsgId(channelId, result.msgId);
+			if (const auto item = App::histItemById(fullId)) {
+				items.push_back(item);
+				if (int(items.size()) == kLocalSearchLimit) {
+					break;
+				}
+				continue;
+			} else if (requested == kLocalSearchRequestsLimit
+				|| _localSearchRequested.contains(fullId)
+				|| !App::peerLoaded(result.peerId)) {
+				continue;
+			}
+
+			// The message was indexed in one of the previous launches.
+			++requested;
+			_localSearchRequested.emplace(fullId);
+			const auto channel = channelId
+				? App::channelLoaded(channelId)
+				: nullptr;
+			Auth().api().requestMessageData(
+				channel,
+				result.msgId,
+				crl::guard(this, [=](ChannelData*, MsgId) {
+					if (App::histItemById(fullId)) {
+						_localSearchRefreshTimer.callOnce(0);
+					} else {
+						Auth().searchIndex().remove(
+							result.peerId,
+							result.msgId);
+					}
+				}));
+		}
+	}
+	_inner->localSearchReceived(std::move(items));
+}
+
 void DialogsWidget::onNeedSearchMessages() {
+	searchLocally();
 	if (!onSearchMessages(true)) {
 		_searchTimer.start(AutoSearchTimeout);
 	}
@@ -676,6 +756,7 @@ void DialogsWidget::searchMessages(
 		_filter->updatePlaceholder();
 		onFilterUpdate(true);
 		_searchTimer.stop();
+		searchLocally();
 		onSearchMessages();
 
 		Local::saveRecentSearchHashtags(query);
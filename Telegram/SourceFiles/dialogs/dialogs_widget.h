@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "window/section_widget.h"
 #include "ui/widgets/scroll_area.h"
+#include "base/timer.h"
 #include "dialogs/dialogs_key.h"
 #include "dialogs_entry.h"
 
@@ -60,6 +61,7 @@ public:
 
 	void loadDialogs();
 	void loadPinnedDialogs();
+	void restoreDialogsSnapshot();
 	void createDialog(Dialogs::Key key);
 	void removeDialog(Dialogs::Key key);
 	void repaintDialogRow(Dialogs::Mode list, not_null<Dialogs::Row*> row);
@@ -158,9 +160,11 @@ private:
 	void applyReceivedDialogs(
 		const QVector<MTPDialog> &dialogs,
 		const QVector<MTPMessage> &messages);
+	void removeUnconfirmedSnapshot();
 
 	void setupConnectingWidget();
 	bool searchForPeersRequired(const QString &query) const;
+	void searchLocally();
 	void setSearchInChat(Dialogs::Key chat, UserData *from = nullptr);
 	void showJumpToDate();
 	void showSearchFrom();
@@ -191,6 +195,13 @@ private:
 	mtpRequestId _pinnedDialogsRequestId = 0;
 	bool _pinnedDialogsReceived = false;
 
+	// Histories restored from the snapshot are removed from the list
+	// if they were not received again after all dialogs are loaded.
+	std::vector<not_null<History*>> _snapshotHistories;
+	base::Timer _snapshotTimer;
+	base::Timer _localSearchRefreshTimer;
+	base::flat_set<FullMsgId> _localSearchRequested;
+
 	object_ptr<Ui::IconButton> _forwardCancel = { nullptr };
 	object_ptr<Ui::IconButton> _mainMenuToggle;
 	object_ptr<Ui::FlatInput> _filter;
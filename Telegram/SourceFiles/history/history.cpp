@@ -30,6 +30,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/storage_facade.h"
 #include "storage/storage_shared_media.h"
 #include "storage/storage_feed_messages.h"
+#include "storage/storage_search_index.h"
 #include "data/data_channel_admins.h"
 #include "data/data_feed.h"
 #include "ui/text_options.h"
@@ -228,6 +229,7 @@ History::History(const PeerId &peerId)
 : Entry(this, peerId)
 , peer(App::peer(peerId))
 , cloudDraftTextCache(st::dialogsTextWidthMin)
+, snapshotPreviewTextCache(st::dialogsTextWidthMin)
 , _mute(Auth().data().notifyIsMuted(peer))
 , _sendActionText(st::dialogsTextWidthMin) {
 	if (const auto user = peer->asUser()) {
@@ -662,9 +664,12 @@ HistoryItem *History::createItem(
 				: nullptr;
 			result->updateSentMedia(media);
 		}
+		Auth().searchIndex().add(result);
 		return result;
 	}
-	return HistoryItem::Create(this, message);
+	const auto result = HistoryItem::Create(this, message);
+	Auth().searchIndex().add(result);
+	return result;
 }
 
 std::vector<not_null<HistoryItem*>> History::createItems(
@@ -2171,6 +2176,7 @@ void History::markFullyLoaded() {
 	_loadedAtTop = _loadedAtBottom = true;
 	if (isEmpty()) {
 		Auth().storage().remove(Storage::SharedMediaRemoveAll(peer->id));
+		Auth().searchIndex().remove(peer->id);
 		if (const auto channel = peer->asChannel()) {
 			if (const auto feed = channel->feed()) {
 				Auth().storage().remove(Storage::FeedMessagesRemoveAll(
@@ -2182,6 +2188,9 @@ void History::markFullyLoaded() {
 }
 
 void History::setLastMessage(HistoryItem *item) {
+	if (!_snapshotPreview.isEmpty()) {
+		setSnapshotPreview(QString());
+	}
 	if (item) {
 		if (_lastMessage && !*_lastMessage) {
 			Local::removeSavedPeer(peer);
@@ -2205,6 +2214,12 @@ bool History::lastMessageKnown() const {
 	return !!_lastMessage;
 }
 
+void History::setSnapshotPreview(const QString &text) {
+	_snapshotPreview = text;
+	snapshotPreviewTextCache.clear();
+	updateChatListEntry();
+}
+
 void History::updateChatListExistence() {
 	Entry::updateChatListExistence();
 	if (!lastMessageKnown() || !unreadCountKnown()) {
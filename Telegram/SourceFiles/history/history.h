@@ -236,6 +236,12 @@ public:
 
 	HistoryItem *lastMessage() const;
 	bool lastMessageKnown() const;
+
+	// Last message text from the dialogs snapshot until it is received.
+	const QString &snapshotPreview() const {
+		return _snapshotPreview;
+	}
+	void setSnapshotPreview(const QString &text);
 	void unknownMessageDeleted(MsgId messageId);
 	void applyDialogTopMessage(MsgId topMessageId);
 	void applyDialog(const MTPDdialog &data);
@@ -257,6 +263,9 @@ public:
 
 	HistoryItem *currentNotification();
 	bool hasNotification() const;
+	int notificationsCount() const {
+		return notifies.size();
+	}
 	void skipNotification();
 	void popNotification(HistoryItem *item);
 
@@ -388,6 +397,7 @@ public:
 	mtpRequestId sendRequestId = 0;
 
 	Text cloudDraftTextCache;
+	Text snapshotPreviewTextCache;
 
 private:
 	friend class HistoryBlock;
@@ -500,6 +510,7 @@ private:
 	base::optional<int> _unreadMentionsCount;
 	base::flat_set<MsgId> _unreadMentions;
 	base::optional<HistoryItem*> _lastMessage;
+	QString _snapshotPreview;
 	bool _unreadMark = false;
 
 	// A pointer to the block that is currently being built.
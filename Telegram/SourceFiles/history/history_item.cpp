@@ -27,6 +27,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/storage_facade.h"
 #include "storage/storage_shared_media.h"
 #include "storage/storage_feed_messages.h"
+#include "storage/storage_search_index.h"
 #include "auth_session.h"
 #include "apiwrap.h"
 #include "media/media_audio.h"
@@ -250,6 +251,7 @@ void HistoryItem::destroy() {
 					types,
 					id));
 			}
+			Auth().searchIndex().remove(history->peer->id, id);
 		} else {
 			Auth().api().cancelLocalItem(this);
 		}
@@ -28,6 +28,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "window/window_controller.h"
 #include "observer_peer.h"
 #include "storage/storage_shared_media.h"
+#include "storage/storage_search_index.h"
 #include "data/data_session.h"
 #include "data/data_media_types.h"
 #include "styles/style_dialogs.h"
@@ -894,6 +895,7 @@ void HistoryMessage::applyEdition(const MTPDmessage &message) {
 	refreshMedia(message.has_media() ? (&message.vmedia) : nullptr);
 	setViewsCount(message.has_views() ? message.vviews.v : -1);
 	setText(textWithEntities);
+	Auth().searchIndex().add(this);
 
 	finishEdition(keyboardTop);
 }
@@ -909,6 +911,7 @@ void HistoryMessage::applyEditionToEmpty() {
 	refreshMedia(nullptr);
 	setEmptyText();
 	setViewsCount(-1);
+	Auth().searchIndex().add(this);
 
 	finishEditionToEmpty();
 }
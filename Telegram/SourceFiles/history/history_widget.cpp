@@ -450,6 +450,7 @@ HistoryWidget::HistoryWidget(
 , _attachDragState(DragState::None)
 , _attachDragDocument(this)
 , _attachDragPhoto(this)
+, _highlightAnimation(animation(this, &HistoryWidget::step_highlight))
 , _sendActionStopTimer([this] { cancelTypingAction(); })
 , _topShadow(this) {
 	setAcceptDrops(true);
@@ -493,8 +494,6 @@ HistoryWidget::HistoryWidget(
 
 	_scrollTimer.setSingleShot(false);
 
-	_highlightTimer.setCallback([this] { updateHighlightedMessage(); });
-
 	_membersDropdownShowTimer.setSingleShot(true);
 	connect(&_membersDropdownShowTimer, SIGNAL(timeout()), this, SLOT(onMembersDropdownShow()));
 
@@ -673,7 +672,7 @@ HistoryWidget::HistoryWidget(
 		| UpdateFlag::NotificationsEnabled
 		| UpdateFlag::ChannelAmIn
 		| UpdateFlag::ChannelPromotedChanged;
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(changes, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(changes), Notify::PeerUpdatedHandler("HistoryWidget::HistoryWidget", [this](const Notify::PeerUpdate &update) {
 		if (update.peer == _peer) {
 			if (update.flags & UpdateFlag::ChannelRightsChanged) {
 				checkPreview();
@@ -887,7 +886,7 @@ void HistoryWidget::enqueueMessageHighlight(
 		}
 	}
 	auto enqueueMessageId = [this](MsgId universalId) {
-		if (_highlightQueue.empty() && !_highlightTimer.isActive()) {
+		if (_highlightQueue.empty() && !_highlightAnimation.animating()) {
 			highlightMessage(universalId);
 		} else if (_highlightedMessageId != universalId
 			&& !base::contains(_highlightQueue, universalId)) {
@@ -906,14 +905,14 @@ void HistoryWidget::enqueueMessageHighlight(
 void HistoryWidget::highlightMessage(MsgId universalMessageId) {
 	_highlightStart = getms();
 	_highlightedMessageId = universalMessageId;
-	_highlightTimer.callEach(AnimationTimerDelta);
+	_highlightAnimation.start();
 
 	adjustHighlightedMessageToMigrated();
 }
 
 void HistoryWidget::adjustHighlightedMessageToMigrated() {
 	if (_history
-		&& _highlightTimer.isActive()
+		&& _highlightAnimation.animating()
 		&& _highlightedMessageId > 0
 		&& _migrated
 		&& !_migrated->isEmpty()
@@ -930,7 +929,7 @@ void HistoryWidget::adjustHighlightedMessageToMigrated() {
 }
 
 void HistoryWidget::checkNextHighlight() {
-	if (_highlightTimer.isActive()) {
+	if (_highlightAnimation.animating()) {
 		return;
 	}
 	auto nextHighlight = [this] {
@@ -950,6 +949,10 @@ void HistoryWidget::checkNextHighlight() {
 	highlightMessage(nextHighlight);
 }
 
+void HistoryWidget::step_highlight(float64 ms, bool timer) {
+	updateHighlightedMessage();
+}
+
 void HistoryWidget::updateHighlightedMessage() {
 	const auto item = getItemFromHistoryOrMigrated(_highlightedMessageId);
 	const auto view = item ? item->mainView() : nullptr;
@@ -973,13 +976,13 @@ TimeMs HistoryWidget::highlightStartTime(not_null<const HistoryItem*> item) cons
 		}
 		return false;
 	};
-	return (isHighlighted(item) && _highlightTimer.isActive())
+	return (isHighlighted(item) && _highlightAnimation.animating())
 		? _highlightStart
 		: 0;
 }
 
 void HistoryWidget::stopMessageHighlight() {
-	_highlightTimer.cancel();
+	_highlightAnimation.stop();
 	_highlightedMessageId = 0;
 	checkNextHighlight();
 }
@@ -461,6 +461,7 @@ private:
 	void highlightMessage(MsgId universalMessageId);
 	void adjustHighlightedMessageToMigrated();
 	void checkNextHighlight();
+	void step_highlight(float64 ms, bool timer);
 	void updateHighlightedMessage();
 	void clearHighlightMessages();
 	void stopMessageHighlight();
@@ -879,7 +880,7 @@ private:
 
 	MsgId _highlightedMessageId = 0;
 	std::deque<MsgId> _highlightQueue;
-	base::Timer _highlightTimer;
+	BasicAnimation _highlightAnimation;
 	TimeMs _highlightStart = 0;
 
 	QMap<QPair<not_null<History*>, SendAction::Type>, mtpRequestId> _sendActionRequests;
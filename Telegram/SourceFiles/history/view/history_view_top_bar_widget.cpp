@@ -105,7 +105,7 @@ TopBarWidget::TopBarWidget(
 	auto flags = UpdateFlag::UserHasCalls
 		| UpdateFlag::UserOnlineChanged
 		| UpdateFlag::MembersChanged;
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(flags, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(flags), Notify::PeerUpdatedHandler("TopBarWidget::TopBarWidget", [this](const Notify::PeerUpdate &update) {
 		if (update.flags & UpdateFlag::UserHasCalls) {
 			if (update.peer->isUser()) {
 				updateControlsVisibility();
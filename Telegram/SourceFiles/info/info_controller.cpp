@@ -106,7 +106,8 @@ void Controller::setupMigrationViewer() {
 	}
 	Notify::PeerUpdateValue(
 		peer,
-		Notify::PeerUpdate::Flag::MigrationChanged
+		Notify::PeerUpdate::Flag::MigrationChanged,
+		"Info::Controller::setupMigrationViewer"
 	) | rpl::start_with_next([=] {
 		if (peer->migrateTo() || (peer->migrateFrom() != _migrated)) {
 			const auto window = parentController();
@@ -414,7 +414,8 @@ void WrapWidget::addProfileCallsButton() {
 
 	Notify::PeerUpdateValue(
 		user,
-		Notify::PeerUpdate::Flag::UserHasCalls
+		Notify::PeerUpdate::Flag::UserHasCalls,
+		"Info::WrapWidget::addProfileCallsButton"
 	) | rpl::filter([=] {
 		return user->hasCalls();
 	}) | rpl::take(
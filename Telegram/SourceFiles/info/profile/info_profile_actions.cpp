@@ -516,7 +516,8 @@ void ActionsFiller::addBotCommandActions(not_null<UserData*> user) {
 	auto hasBotCommandValue = [=](const QString &command) {
 		return Notify::PeerUpdateValue(
 			user,
-			Notify::PeerUpdate::Flag::BotCommandsChanged
+			Notify::PeerUpdate::Flag::BotCommandsChanged,
+			"Info::Profile::ActionsFiller::addBotCommandActions"
 		) | rpl::map([=] {
 			return !findBotCommand(command).isEmpty();
 		});
@@ -553,7 +554,8 @@ void ActionsFiller::addReportAction() {
 void ActionsFiller::addBlockAction(not_null<UserData*> user) {
 	auto text = Notify::PeerUpdateValue(
 		user,
-		Notify::PeerUpdate::Flag::UserIsBlocked
+		Notify::PeerUpdate::Flag::UserIsBlocked,
+		"Info::Profile::ActionsFiller::addBlockAction"
 	) | rpl::map([user] {
 		switch (user->blockStatus()) {
 		case UserData::BlockStatus::Blocked:
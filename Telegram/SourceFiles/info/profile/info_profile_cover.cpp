@@ -276,20 +276,23 @@ void Cover::initViewers() {
 	using Flag = Notify::PeerUpdate::Flag;
 	Notify::PeerUpdateValue(
 		_peer,
-		Flag::NameChanged
+		Flag::NameChanged,
+		"Info::Profile::Cover::initViewers"
 	) | rpl::start_with_next(
 		[this] { refreshNameText(); },
 		lifetime());
 	Notify::PeerUpdateValue(
 		_peer,
-		Flag::UserOnlineChanged | Flag::MembersChanged
+		Flag::UserOnlineChanged | Flag::MembersChanged,
+		"Info::Profile::Cover::initViewers"
 	) | rpl::start_with_next(
 		[this] { refreshStatusText(); },
 		lifetime());
 	if (!_peer->isUser()) {
 		Notify::PeerUpdateValue(
 			_peer,
-			Flag::ChannelRightsChanged | Flag::ChatCanEdit
+			Flag::ChannelRightsChanged | Flag::ChatCanEdit,
+			"Info::Profile::Cover::initViewers"
 		) | rpl::start_with_next(
 			[this] { refreshUploadPhotoOverlay(); },
 			lifetime());
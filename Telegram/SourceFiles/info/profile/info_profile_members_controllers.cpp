@@ -96,10 +96,12 @@ void ChatMembersController::prepare() {
 		Auth().api().requestFullPeer(_chat);
 	}
 	using UpdateFlag = Notify::PeerUpdate::Flag;
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(
+	subscribe(Notify::PeerUpdated(
 		UpdateFlag::MembersChanged
 		| UpdateFlag::UserOnlineChanged
-		| UpdateFlag::AdminsChanged,
+		| UpdateFlag::AdminsChanged
+	), Notify::PeerUpdatedHandler(
+		"ChatMembersController::prepare",
 		[this](const Notify::PeerUpdate &update) {
 			if (update.flags & UpdateFlag::MembersChanged) {
 				if (update.peer == _chat) {
@@ -142,7 +144,8 @@ std::unique_ptr<PeerListState> ChatMembersController::saveState() const {
 	using Flag = Notify::PeerUpdate::Flag;
 	Notify::PeerUpdateViewer(
 		_chat,
-		Flag::MembersChanged
+		Flag::MembersChanged,
+		"Info::Profile::ChatMembersController::saveState"
 	) | rpl::start_with_next([state = result.get()](auto update) {
 		state->controllerState = nullptr;
 	}, my->lifetime);
@@ -27,7 +27,8 @@ rpl::producer<TextWithEntities> PhoneValue(
 		not_null<UserData*> user) {
 	return Notify::PeerUpdateValue(
 			user,
-			Notify::PeerUpdate::Flag::UserPhoneChanged
+			Notify::PeerUpdate::Flag::UserPhoneChanged,
+			"Info::Profile::PhoneValue"
 	) | rpl::map([user] {
 		return App::formatPhone(user->phone());
 	}) | WithEmptyEntities();
@@ -37,7 +38,8 @@ auto PlainBioValue(
 		not_null<UserData*> user) {
 	return Notify::PeerUpdateValue(
 			user,
-			Notify::PeerUpdate::Flag::AboutChanged
+			Notify::PeerUpdate::Flag::AboutChanged,
+			"Info::Profile::PlainBioValue"
 	) | rpl::map([user] { return user->about(); });
 }
 
@@ -52,7 +54,8 @@ auto PlainUsernameValue(
 		not_null<PeerData*> peer) {
 	return Notify::PeerUpdateValue(
 			peer,
-			Notify::PeerUpdate::Flag::UsernameChanged
+			Notify::PeerUpdate::Flag::UsernameChanged,
+			"Info::Profile::PlainUsernameValue"
 	) | rpl::map([peer] {
 		return peer->userName();
 	});
@@ -74,7 +77,8 @@ rpl::producer<QString> PlainAboutValue(
 	if (auto channel = peer->asChannel()) {
 		return Notify::PeerUpdateValue(
 				channel,
-				Notify::PeerUpdate::Flag::AboutChanged
+				Notify::PeerUpdate::Flag::AboutChanged,
+				"Info::Profile::PlainAboutValue"
 		) | rpl::map([channel] { return channel->about(); });
 	} else if (auto user = peer->asUser()) {
 		if (user->botInfo) {
@@ -118,7 +122,8 @@ rpl::producer<bool> NotificationsEnabledValue(
 	return rpl::merge(
 		Notify::PeerUpdateValue(
 			peer,
-			Notify::PeerUpdate::Flag::NotificationsEnabled
+			Notify::PeerUpdate::Flag::NotificationsEnabled,
+			"Info::Profile::NotificationsEnabledValue"
 		) | rpl::map([] { return rpl::empty_value(); }),
 		Auth().data().defaultNotifyUpdates(peer)
 	) | rpl::map([peer] {
@@ -130,7 +135,8 @@ rpl::producer<bool> IsContactValue(
 		not_null<UserData*> user) {
 	return Notify::PeerUpdateValue(
 			user,
-			Notify::PeerUpdate::Flag::UserIsContact
+			Notify::PeerUpdate::Flag::UserIsContact,
+			"Info::Profile::IsContactValue"
 	) | rpl::map([user] { return user->isContact(); });
 }
 
@@ -141,7 +147,8 @@ rpl::producer<bool> CanInviteBotToGroupValue(
 	}
 	return Notify::PeerUpdateValue(
 			user,
-			Notify::PeerUpdate::Flag::BotCanAddToGroups
+			Notify::PeerUpdate::Flag::BotCanAddToGroups,
+			"Info::Profile::CanInviteBotToGroupValue"
 	) | rpl::map([user] {
 		return !user->botInfo->cantJoinGroups;
 	});
@@ -151,7 +158,8 @@ rpl::producer<bool> CanShareContactValue(
 		not_null<UserData*> user) {
 	return Notify::PeerUpdateValue(
 			user,
-			Notify::PeerUpdate::Flag::UserCanShareContact
+			Notify::PeerUpdate::Flag::UserCanShareContact,
+			"Info::Profile::CanShareContactValue"
 	) | rpl::map([user] {
 		return user->canShareThisContact();
 	});
@@ -170,7 +178,8 @@ rpl::producer<bool> AmInChannelValue(
 		not_null<ChannelData*> channel) {
 	return Notify::PeerUpdateValue(
 		channel,
-		Notify::PeerUpdate::Flag::ChannelAmIn
+		Notify::PeerUpdate::Flag::ChannelAmIn,
+		"Info::Profile::AmInChannelValue"
 	) | rpl::map([channel] { return channel->amIn(); });
 }
 
@@ -179,7 +188,8 @@ rpl::producer<int> MembersCountValue(
 	if (auto chat = peer->asChat()) {
 		return Notify::PeerUpdateValue(
 			peer,
-			Notify::PeerUpdate::Flag::MembersChanged
+			Notify::PeerUpdate::Flag::MembersChanged,
+			"Info::Profile::MembersCountValue"
 		) | rpl::map([chat] {
 			return chat->amIn()
 				? std::max(chat->count, int(chat->participants.size()))
@@ -188,7 +198,8 @@ rpl::producer<int> MembersCountValue(
 	} else if (auto channel = peer->asChannel()) {
 		return Notify::PeerUpdateValue(
 				channel,
-				Notify::PeerUpdate::Flag::MembersChanged
+				Notify::PeerUpdate::Flag::MembersChanged,
+				"Info::Profile::MembersCountValue"
 		) | rpl::map([channel] {
 			return channel->membersCount();
 		});
@@ -201,7 +212,8 @@ rpl::producer<int> AdminsCountValue(
 	using Flag = Notify::PeerUpdate::Flag;
 	return Notify::PeerUpdateValue(
 		channel,
-		Flag::AdminsChanged | Flag::ChannelRightsChanged
+		Flag::AdminsChanged | Flag::ChannelRightsChanged,
+		"Info::Profile::AdminsCountValue"
 	) | rpl::map([channel] {
 		return channel->canViewAdmins()
 			? channel->adminsCount()
@@ -214,7 +226,8 @@ rpl::producer<int> RestrictedCountValue(
 	using Flag = Notify::PeerUpdate::Flag;
 	return Notify::PeerUpdateValue(
 		channel,
-		Flag::BannedUsersChanged | Flag::ChannelRightsChanged
+		Flag::BannedUsersChanged | Flag::ChannelRightsChanged,
+		"Info::Profile::RestrictedCountValue"
 	) | rpl::map([channel] {
 		return channel->canViewBanned()
 			? channel->restrictedCount()
@@ -227,7 +240,8 @@ rpl::producer<int> KickedCountValue(
 	using Flag = Notify::PeerUpdate::Flag;
 	return Notify::PeerUpdateValue(
 		channel,
-		Flag::BannedUsersChanged | Flag::ChannelRightsChanged
+		Flag::BannedUsersChanged | Flag::ChannelRightsChanged,
+		"Info::Profile::KickedCountValue"
 	) | rpl::map([channel] {
 		return channel->canViewBanned()
 			? channel->kickedCount()
@@ -260,7 +274,8 @@ rpl::producer<int> CommonGroupsCountValue(
 		not_null<UserData*> user) {
 	return Notify::PeerUpdateValue(
 		user,
-		Notify::PeerUpdate::Flag::UserCommonChatsChanged
+		Notify::PeerUpdate::Flag::UserCommonChatsChanged,
+		"Info::Profile::CommonGroupsCountValue"
 	) | rpl::map([user] {
 		return user->commonChatsCount();
 	});
@@ -271,14 +286,16 @@ rpl::producer<bool> CanAddMemberValue(
 	if (auto chat = peer->asChat()) {
 		return Notify::PeerUpdateValue(
 			chat,
-			Notify::PeerUpdate::Flag::ChatCanEdit
+			Notify::PeerUpdate::Flag::ChatCanEdit,
+			"Info::Profile::CanAddMemberValue"
 		) | rpl::map([chat] {
 			return chat->canEdit();
 		});
 	} else if (auto channel = peer->asChannel()) {
 		return Notify::PeerUpdateValue(
 			channel,
-			Notify::PeerUpdate::Flag::ChannelRightsChanged
+			Notify::PeerUpdate::Flag::ChannelRightsChanged,
+			"Info::Profile::CanAddMemberValue"
 		) | rpl::map([channel] {
 			return channel->canAddMembers();
 		});
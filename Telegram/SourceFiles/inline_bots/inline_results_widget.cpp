@@ -59,7 +59,7 @@ Inner::Inner(QWidget *parent, not_null<Window::Controller*> controller) : TWidge
 			update();
 		}
 	});
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(Notify::PeerUpdate::Flag::ChannelRightsChanged, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(Notify::PeerUpdate::Flag::ChannelRightsChanged), Notify::PeerUpdatedHandler("InlineBots::Layout::Inner::Inner", [this](const Notify::PeerUpdate &update) {
 		if (update.peer == _inlineQueryPeer) {
 			auto isRestricted = (_restrictedLabel != nullptr);
 			if (isRestricted != isRestrictedView()) {
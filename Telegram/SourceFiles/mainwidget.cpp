@@ -3716,6 +3716,7 @@ void MainWidget::start(const MTPUser *self) {
 	}
 
 	Local::readSavedPeers();
+	_dialogs->restoreDialogsSnapshot();
 	cSetOtherOnline(0);
 	if (const auto user = App::feedUsers(MTP_vector<MTPUser>(1, *self))) {
 		user->loadUserpic();
@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "media/media_audio.h"
 #include "media/media_child_ffmpeg_loader.h"
+#include "media/media_streaming_loader.h"
 #include "storage/file_download.h"
 
 namespace Media {
@@ -44,7 +45,12 @@ bool isAlignedImage(const QImage &image) {
 
 } // namespace
 
-FFMpegReaderImplementation::FFMpegReaderImplementation(FileLocation *location, QByteArray *data, const AudioMsgId &audio) : ReaderImplementation(location, data)
+FFMpegReaderImplementation::FFMpegReaderImplementation(
+	FileLocation *location,
+	QByteArray *data,
+	const AudioMsgId &audio,
+	std::shared_ptr<Streaming::Source> source)
+: ReaderImplementation(location, data, std::move(source))
 , _audioMsgId(audio) {
 	_frame = av_frame_alloc();
 	av_init_packet(&_packetNull);
@@ -455,6 +461,9 @@ bool FFMpegReaderImplementation::isGifv() const {
 }
 
 QString FFMpegReaderImplementation::logData() const {
+	if (_source) {
+		return qsl("for streamed file, size '%1'").arg(_source->size());
+	}
 	return qsl("for file '%1', data size '%2'").arg(_location ? _location->name() : QString()).arg(_data->size());
 }
 
@@ -22,7 +22,11 @@ namespace internal {
 
 class FFMpegReaderImplementation : public ReaderImplementation {
 public:
-	FFMpegReaderImplementation(FileLocation *location, QByteArray *data, const AudioMsgId &audio);
+	FFMpegReaderImplementation(
+		FileLocation *location,
+		QByteArray *data,
+		const AudioMsgId &audio,
+		std::shared_ptr<Streaming::Source> source = nullptr);
 
 	ReadResult readFramesTill(TimeMs frameMs, TimeMs systemMs) override;
 
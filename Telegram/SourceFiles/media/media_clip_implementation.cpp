@@ -7,12 +7,20 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "media/media_clip_implementation.h"
 
+#include "media/media_streaming_loader.h"
+
 namespace Media {
 namespace Clip {
 namespace internal {
 
 void ReaderImplementation::initDevice() {
-	if (_data->isEmpty()) {
+	if (_source) {
+		if (_streamed && _streamed->isOpen()) _streamed->close();
+		_streamed = std::make_unique<Streaming::Device>(_source);
+		_dataSize = _source->size();
+		_device = _streamed.get();
+		return;
+	} else if (_data->isEmpty()) {
 		if (_file.isOpen()) _file.close();
 		_file.setFileName(_location->name());
 		_dataSize = _file.size();
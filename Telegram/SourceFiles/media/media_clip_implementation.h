@@ -10,14 +10,22 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 class FileLocation;
 
 namespace Media {
+namespace Streaming {
+class Source;
+} // namespace Streaming
+
 namespace Clip {
 namespace internal {
 
 class ReaderImplementation {
 public:
-	ReaderImplementation(FileLocation *location, QByteArray *data)
+	ReaderImplementation(
+		FileLocation *location,
+		QByteArray *data,
+		std::shared_ptr<Streaming::Source> source = nullptr)
 		: _location(location)
-		, _data(data) {
+		, _data(data)
+		, _source(std::move(source)) {
 	}
 	enum class Mode {
 		Silent,
@@ -54,8 +62,10 @@ public:
 protected:
 	FileLocation *_location;
 	QByteArray *_data;
+	std::shared_ptr<Streaming::Source> _source;
 	QFile _file;
 	QBuffer _buffer;
+	std::unique_ptr<QIODevice> _streamed;
 	QIODevice *_device = nullptr;
 	int64 _dataSize = 0;
 
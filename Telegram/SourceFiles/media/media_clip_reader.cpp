@@ -28,6 +28,17 @@ namespace {
 QVector<QThread*> threads;
 QVector<Manager*> managers;
 
+// Streamed readers block while waiting for the network, so they get
+// a thread of their own and don't stall the animations on shared threads.
+int streamingThreadIndex = -1;
+
+int StartThread() {
+	threads.push_back(new QThread());
+	managers.push_back(new Manager(threads.back()));
+	threads.back()->start();
+	return threads.size() - 1;
+}
+
 QImage PrepareFrameImage(const FrameRequest &request, const QImage &original, bool hasAlpha, QImage &cache) {
 	auto needResize = (original.width() != request.framew) || (original.height() != request.frameh);
 	auto needOuterFill = (request.outerw != request.framew) || (request.outerh != request.frameh);
@@ -95,24 +106,46 @@ Reader::Reader(not_null<DocumentData*> document, FullMsgId msgId, Callback &&cal
 	init(document->location(), document->data());
 }
 
-void Reader::init(const FileLocation &location, const QByteArray &data) {
-	if (threads.size() < ClipThreadsCount) {
-		_threadIndex = threads.size();
-		threads.push_back(new QThread());
-		managers.push_back(new Manager(threads.back()));
-		threads.back()->start();
+Reader::Reader(not_null<DocumentData*> document, FullMsgId msgId, std::shared_ptr<Streaming::Source> source, Callback &&callback, Mode mode, int64 seekMs)
+: _callback(std::move(callback))
+, _mode(mode)
+, _audioMsgId(document, msgId, (mode == Mode::Video) ? rand_value<uint32>() : 0)
+, _seekPositionMs(seekMs) {
+	init(FileLocation(), QByteArray(), std::move(source));
+}
+
+void Reader::init(
+		const FileLocation &location,
+		const QByteArray &data,
+		std::shared_ptr<Streaming::Source> source) {
+	const auto sharedThreadsCount = threads.size()
+		- ((streamingThreadIndex >= 0) ? 1 : 0);
+	if (source) {
+		if (streamingThreadIndex < 0) {
+			streamingThreadIndex = StartThread();
+		}
+		_threadIndex = streamingThreadIndex;
+	} else if (sharedThreadsCount < ClipThreadsCount) {
+		_threadIndex = StartThread();
 	} else {
-		_threadIndex = int32(rand_value<uint32>() % threads.size());
+		_threadIndex = -1;
 		int32 loadLevel = 0x7FFFFFFF;
 		for (int32 i = 0, l = threads.size(); i < l; ++i) {
+			if (i == streamingThreadIndex) {
+				continue;
+			}
 			int32 level = managers.at(i)->loadLevel();
-			if (level < loadLevel) {
+			if (_threadIndex < 0 || level < loadLevel) {
 				_threadIndex = i;
 				loadLevel = level;
 			}
 		}
 	}
-	managers.at(_threadIndex)->append(this, location, data);
+	managers.at(_threadIndex)->append(
+		this,
+		location,
+		data,
+		std::move(source));
 }
 
 Reader::Frame *Reader::frameToShow(int32 *index) const { // 0 means not ready
@@ -350,12 +383,13 @@ Reader::~Reader() {
 
 class ReaderPrivate {
 public:
-	ReaderPrivate(Reader *reader, const FileLocation &location, const QByteArray &data) : _interface(reader)
+	ReaderPrivate(Reader *reader, const FileLocation &location, const QByteArray &data, std::shared_ptr<Streaming::Source> source) : _interface(reader)
 	, _mode(reader->mode())
 	, _audioMsgId(reader->audioMsgId())
 	, _seekPositionMs(reader->seekPositionMs())
-	, _data(data) {
-		if (_data.isEmpty()) {
+	, _data(data)
+	, _source(std::move(source)) {
+		if (_data.isEmpty() && !_source) {
 			_location = std::make_unique<FileLocation>(location);
 			if (!_location->accessEnable()) {
 				error();
@@ -376,7 +410,7 @@ public:
 				// get the frame size and return a black frame with that size.
 
 				auto firstFramePositionMs = TimeMs(0);
-				auto reader = std::make_unique<internal::FFMpegReaderImplementation>(_location.get(), &_data, AudioMsgId());
+				auto reader = std::make_unique<internal::FFMpegReaderImplementation>(_location.get(), &_data, AudioMsgId(), _source);
 				if (reader->start(internal::ReaderImplementation::Mode::Normal, firstFramePositionMs)) {
 					auto firstFrameReadResult = reader->readFramesTill(-1, ms);
 					if (firstFrameReadResult == internal::ReaderImplementation::ReadResult::Success) {
@@ -473,7 +507,7 @@ public:
 	}
 
 	bool init() {
-		if (_data.isEmpty() && QFileInfo(_location->name()).size() <= Storage::kMaxAnimationInMemory) {
+		if (!_source && _data.isEmpty() && QFileInfo(_location->name()).size() <= Storage::kMaxAnimationInMemory) {
 			QFile f(_location->name());
 			if (f.open(QIODevice::ReadOnly)) {
 				_data = f.readAll();
@@ -483,7 +517,7 @@ public:
 			}
 		}
 
-		_implementation = std::make_unique<internal::FFMpegReaderImplementation>(_location.get(), &_data, _audioMsgId);
+		_implementation = std::make_unique<internal::FFMpegReaderImplementation>(_location.get(), &_data, _audioMsgId, _source);
 //		_implementation = new QtGifReaderImplementation(_location, &_data);
 
 		auto implementationMode = [this]() {
@@ -556,6 +590,7 @@ private:
 	TimeMs _seekPositionMs = 0;
 
 	QByteArray _data;
+	std::shared_ptr<Streaming::Source> _source;
 	std::unique_ptr<FileLocation> _location;
 	bool _accessed = false;
 
@@ -608,8 +643,16 @@ Manager::Manager(QThread *thread) : _processingInThread(0), _needReProcess(false
 	anim::registerClipManager(this);
 }
 
-void Manager::append(Reader *reader, const FileLocation &location, const QByteArray &data) {
-	reader->_private = new ReaderPrivate(reader, location, data);
+void Manager::append(
+		Reader *reader,
+		const FileLocation &location,
+		const QByteArray &data,
+		std::shared_ptr<Streaming::Source> source) {
+	reader->_private = new ReaderPrivate(
+		reader,
+		location,
+		data,
+		std::move(source));
 	_loadLevel.fetchAndAddRelaxed(AverageGifSize);
 	update(reader);
 }
@@ -906,6 +949,7 @@ void Finish() {
 		}
 		threads.clear();
 		managers.clear();
+		streamingThreadIndex = -1;
 	}
 }
 
@@ -12,6 +12,10 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 class FileLocation;
 
 namespace Media {
+namespace Streaming {
+class Source;
+} // namespace Streaming
+
 namespace Clip {
 
 enum class State {
@@ -51,6 +55,9 @@ public:
 	Reader(const QString &filepath, Callback &&callback, Mode mode = Mode::Gif, TimeMs seekMs = 0);
 	Reader(not_null<DocumentData*> document, FullMsgId msgId, Callback &&callback, Mode mode = Mode::Gif, TimeMs seekMs = 0);
 
+	// Reads the document parts from the source while it is being loaded.
+	Reader(not_null<DocumentData*> document, FullMsgId msgId, std::shared_ptr<Streaming::Source> source, Callback &&callback, Mode mode = Mode::Video, TimeMs seekMs = 0);
+
 	static void callback(Reader *reader, int threadIndex, Notification notification); // reader can be deleted
 
 	void setAutoplay() {
@@ -116,7 +123,10 @@ public:
 	~Reader();
 
 private:
-	void init(const FileLocation &location, const QByteArray &data);
+	void init(
+		const FileLocation &location,
+		const QByteArray &data,
+		std::shared_ptr<Streaming::Source> source = nullptr);
 
 	Callback _callback;
 	Mode _mode;
@@ -190,7 +200,11 @@ public:
 	int32 loadLevel() const {
 		return _loadLevel.load();
 	}
-	void append(Reader *reader, const FileLocation &location, const QByteArray &data);
+	void append(
+		Reader *reader,
+		const FileLocation &location,
+		const QByteArray &data,
+		std::shared_ptr<Streaming::Source> source);
 	void start(Reader *reader);
 	void update(Reader *reader);
 	void stop(Reader *reader);
@@ -0,0 +1,316 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "media/media_streaming_loader.h"
+
+#include "data/data_document.h"
+#include "storage/file_download.h"
+#include "auth_session.h"
+#include "apiwrap.h"
+
+namespace Media {
+namespace Streaming {
+namespace {
+
+// Parts are aligned by their size, as upload.getFile requires.
+constexpr auto kPartSize = 128 * 1024;
+
+// Download that many parts starting from the read position.
+constexpr auto kPartsAhead = 16;
+constexpr auto kRequestsLimit = 4;
+
+// 8 MB sliding window of downloaded parts.
+constexpr auto kPartsLimit = 64;
+
+// Don't block the decoding thread forever on a stalled connection.
+constexpr auto kReadTimeout = 30 * 1000;
+
+int PartIndex(int64 offset) {
+	return int(offset / kPartSize);
+}
+
+} // namespace
+
+bool Supported(not_null<DocumentData*> document) {
+	return document->isVideoFile()
+		&& document->hasRemoteLocation()
+		&& !document->hasWebLocation()
+		&& (document->size > kPartSize)
+		&& !document->loaded();
+}
+
+Source::Source(int64 size, base::weak_ptr<Loader> loader)
+: _size(size)
+, _loader(std::move(loader)) {
+}
+
+int Source::read(int64 offset, bytes::span buffer) {
+	if (offset < 0) {
+		return -1;
+	} else if (offset >= _size || buffer.empty()) {
+		return 0;
+	}
+	const auto index = PartIndex(offset);
+
+	QMutexLocker lock(&_mutex);
+	if (_position != index) {
+		_position = index;
+		wakeLoaderLocked();
+	}
+	auto i = _parts.find(index);
+	while (i == _parts.end()) {
+		if (_cancelled) {
+			return -1;
+		}
+		wakeLoaderLocked();
+		if (!_partsChanged.wait(&_mutex, kReadTimeout)) {
+			LOG(("Streaming Error: Timeout waiting for part %1.").arg(index));
+			return -1;
+		}
+		if (_position != index) {
+			// Another reader has seeked, this one is going to be destroyed.
+			return -1;
+		}
+		i = _parts.find(index);
+	}
+	if (_cancelled) {
+		return -1;
+	}
+	const auto &part = i->second;
+	const auto skip = int(offset - int64(index) * kPartSize);
+	if (skip >= part.size()) {
+		return 0;
+	}
+	const auto count = std::min(int(buffer.size()), part.size() - skip);
+	bytes::copy(
+		buffer,
+		bytes::make_span(part).subspan(skip, count));
+	return count;
+}
+
+void Source::cancel() {
+	QMutexLocker lock(&_mutex);
+	_cancelled = true;
+	_partsChanged.wakeAll();
+}
+
+void Source::wakeLoaderLocked() {
+	if (_wakeScheduled || _cancelled) {
+		return;
+	}
+	_wakeScheduled = true;
+	crl::on_main(_loader, [loader = _loader] {
+		loader->refreshRequests();
+	});
+}
+
+void Source::storePartLocked(int index, QByteArray &&bytes) {
+	_parts.emplace(index, std::move(bytes));
+	while (_parts.size() > kPartsLimit) {
+		const auto distance = [&](int part) {
+			return (part < _position)
+				? (_position - part) * 2 // Prefer keeping parts ahead.
+				: (part - _position);
+		};
+		auto farthest = _parts.begin();
+		for (auto i = _parts.begin(); i != _parts.end(); ++i) {
+			if (distance(i->first) > distance(farthest->first)) {
+				farthest = i;
+			}
+		}
+		_parts.erase(farthest);
+	}
+	_partsChanged.wakeAll();
+}
+
+Device::Device(std::shared_ptr<Source> source)
+: _source(std::move(source)) {
+}
+
+bool Device::isSequential() const {
+	return false;
+}
+
+qint64 Device::size() const {
+	return _source->size();
+}
+
+qint64 Device::readData(char *data, qint64 maxSize) {
+	const auto buffer = bytes::make_span(
+		data,
+		size_type(std::min(maxSize, qint64(kPartSize))));
+	return _source->read(pos(), buffer);
+}
+
+qint64 Device::writeData(const char *data, qint64 maxSize) {
+	return -1;
+}
+
+Loader::Loader(not_null<DocumentData*> document, Data::FileOrigin origin)
+: _document(document)
+, _origin(origin)
+, _partsCount((document->size + kPartSize - 1) / kPartSize)
+, _source(new Source(document->size, base::make_weak(this)))
+, _started(getms()) {
+	refreshRequests();
+}
+
+void Loader::refreshRequests() {
+	auto position = 0;
+	auto loaded = base::flat_set<int>();
+	{
+		QMutexLocker lock(&_source->_mutex);
+		if (_source->_cancelled) {
+			return;
+		}
+		_source->_wakeScheduled = false;
+		position = _source->_position;
+		for (const auto &[index, part] : _source->_parts) {
+			loaded.emplace(index);
+		}
+	}
+	if (_refreshingFileReference) {
+		return;
+	}
+	const auto from = position;
+	const auto till = std::min(from + kPartsAhead, _partsCount);
+
+	// After a seek the parts requested for the old position are useless.
+	for (auto i = _requests.begin(); i != _requests.end();) {
+		if (i->first < from || i->first >= till) {
+			Auth().downloader().requestedAmountIncrement(
+				_document->dcId(),
+				i->second.dcIndex,
+				-kPartSize);
+			request(i->second.id).cancel();
+			i = _requests.erase(i);
+		} else {
+			++i;
+		}
+	}
+	for (auto index = from; index != till; ++index) {
+		if (_requests.size() >= kRequestsLimit) {
+			break;
+		} else if (!loaded.contains(index) && !_requests.contains(index)) {
+			sendRequest(index);
+		}
+	}
+}
+
+void Loader::sendRequest(int index) {
+	const auto dcId = _document->dcId();
+	auto &downloader = Auth().downloader();
+	const auto dcIndex = downloader.chooseDcIndexForRequest(dcId);
+	downloader.requestedAmountIncrement(dcId, dcIndex, kPartSize);
+
+	const auto reference = _document->fileReference();
+	const auto id = request(MTPupload_GetFile(
+		_document->mtpFileLocation(),
+		MTP_int(index * kPartSize),
+		MTP_int(kPartSize)
+	)).done([=](const MTPupload_File &result) {
+		finishRequest(index);
+		partLoaded(index, result);
+	}).fail([=](const RPCError &error) {
+		finishRequest(index);
+		if (error.code() != 400
+			|| !error.type().startsWith(qstr("FILE_REFERENCE_"))) {
+			failed(error.type());
+		} else if (_document->fileReference() != reference) {
+			// Sent before the file reference was refreshed.
+			refreshRequests();
+		} else {
+			refreshFileReference();
+		}
+	}).toDC(MTP::downloadDcId(dcId, dcIndex)).send();
+	_requests.emplace(index, Request{ id, dcIndex });
+}
+
+void Loader::finishRequest(int index) {
+	const auto i = _requests.find(index);
+	if (i != _requests.end()) {
+		Auth().downloader().requestedAmountIncrement(
+			_document->dcId(),
+			i->second.dcIndex,
+			-kPartSize);
+		_requests.erase(i);
+	}
+}
+
+void Loader::partLoaded(int index, const MTPupload_File &result) {
+	if (result.type() != mtpc_upload_file) {
+		// Parts from CDN need hash checks, let the regular loader do that.
+		failed("CDN_REDIRECT");
+		return;
+	}
+	auto bytes = qba(result.c_upload_file().vbytes);
+	if (bytes.isEmpty() && index + 1 < _partsCount) {
+		failed("EMPTY_PART");
+		return;
+	}
+	if (!_firstPartLogged) {
+		_firstPartLogged = true;
+		DEBUG_LOG(("Streaming Info: first part of %1 received in %2ms."
+			).arg(_document->id
+			).arg(getms() - _started));
+	}
+	{
+		QMutexLocker lock(&_source->_mutex);
+		_source->storePartLocked(index, std::move(bytes));
+	}
+	refreshRequests();
+}
+
+void Loader::refreshFileReference() {
+	if (_refreshingFileReference) {
+		return;
+	}
+	_refreshingFileReference = true;
+	const auto current = _document->fileReference();
+	Auth().api().refreshFileReference(_origin, crl::guard(this, [=](
+			const Data::UpdatedFileReferences &data) {
+		_refreshingFileReference = false;
+		const auto i = data.find(_document->id);
+		const auto updated = (i == end(data)) ? QByteArray() : i->second;
+		if (updated.isEmpty() || updated == current) {
+			failed("FILE_REFERENCE_EXPIRED");
+			return;
+		}
+		_document->refreshFileReference(updated);
+		refreshRequests();
+	}));
+}
+
+void Loader::failed(const QString &reason) {
+	LOG(("Streaming Error: Could not load document %1, reason: %2."
+		).arg(_document->id
+		).arg(reason));
+	for (const auto &[index, sent] : base::take(_requests)) {
+		Auth().downloader().requestedAmountIncrement(
+			_document->dcId(),
+			sent.dcIndex,
+			-kPartSize);
+		request(sent.id).cancel();
+	}
+	_source->cancel();
+}
+
+Loader::~Loader() {
+	// After a logout the downloader and the document are already gone.
+	if (AuthSession::Exists()) {
+		for (const auto &[index, sent] : _requests) {
+			Auth().downloader().requestedAmountIncrement(
+				_document->dcId(),
+				sent.dcIndex,
+				-kPartSize);
+		}
+	}
+	_source->cancel();
+}
+
+} // namespace Streaming
+} // namespace Media
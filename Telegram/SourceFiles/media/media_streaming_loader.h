@@ -0,0 +1,112 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/bytes.h"
+#include "mtproto/sender.h"
+#include "data/data_file_origin.h"
+
+namespace Media {
+namespace Streaming {
+
+class Loader;
+
+bool Supported(not_null<DocumentData*> document);
+
+// Keeps the downloaded parts around the last read position.
+// Reads may be done from any thread except the main one: they block
+// until the required part is downloaded by the Loader on the main thread,
+// so clip readers of a Source run on a dedicated thread.
+class Source final {
+public:
+	int64 size() const {
+		return _size;
+	}
+
+	// Returns the count of bytes read, zero at the end of file
+	// and -1 if loading has failed or was cancelled.
+	int read(int64 offset, bytes::span buffer);
+
+	void cancel();
+
+private:
+	friend class Loader;
+
+	Source(int64 size, base::weak_ptr<Loader> loader);
+
+	void wakeLoaderLocked();
+	void storePartLocked(int index, QByteArray &&bytes);
+
+	const int64 _size = 0;
+	const base::weak_ptr<Loader> _loader;
+
+	QMutex _mutex;
+	QWaitCondition _partsChanged;
+	base::flat_map<int, QByteArray> _parts;
+	int _position = 0;
+	bool _wakeScheduled = false;
+	bool _cancelled = false;
+
+};
+
+// Allows ffmpeg readers to use the Source as a plain QIODevice.
+class Device final : public QIODevice {
+public:
+	explicit Device(std::shared_ptr<Source> source);
+
+	bool isSequential() const override;
+	qint64 size() const override;
+
+protected:
+	qint64 readData(char *data, qint64 maxSize) override;
+	qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+	const std::shared_ptr<Source> _source;
+
+};
+
+// Requests document parts that are near the Source read position.
+class Loader final : public base::has_weak_ptr, private MTP::Sender {
+public:
+	Loader(not_null<DocumentData*> document, Data::FileOrigin origin);
+
+	std::shared_ptr<Source> source() const {
+		return _source;
+	}
+
+	~Loader();
+
+private:
+	friend class Source;
+
+	struct Request {
+		mtpRequestId id = 0;
+		int dcIndex = 0;
+	};
+
+	void refreshRequests();
+	void sendRequest(int index);
+	void finishRequest(int index);
+	void partLoaded(int index, const MTPupload_File &result);
+	void refreshFileReference();
+	void failed(const QString &reason);
+
+	const not_null<DocumentData*> _document;
+	const Data::FileOrigin _origin;
+	const int _partsCount = 0;
+	std::shared_ptr<Source> _source;
+	base::flat_map<int, Request> _requests;
+	TimeMs _started = 0;
+	bool _refreshingFileReference = false;
+	bool _firstPartLogged = false;
+
+};
+
+} // namespace Streaming
+} // namespace Media
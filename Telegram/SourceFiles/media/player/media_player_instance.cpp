@@ -16,6 +16,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history_item.h"
 #include "data/data_media_types.h"
 #include "window/window_controller.h"
+#include "storage/localstorage.h"
 #include "messenger.h"
 #include "mainwindow.h"
 #include "auth_session.h"
@@ -32,6 +33,19 @@ constexpr auto kIdsLimit = 32;
 // Preload next messages if we went further from current than that.
 constexpr auto kIdsPreloadAfter = 28;
 
+// Download that many tracks after the current one in background.
+constexpr auto kPreloadTracks = 3;
+
+// Don't download more than that ahead, the first next track is always loaded.
+constexpr auto kPreloadSizeLimit = 64 * 1024 * 1024;
+
+DocumentData *ItemDocument(HistoryItem *item) {
+	if (const auto media = item ? item->media() : nullptr) {
+		return media->document();
+	}
+	return nullptr;
+}
+
 } // namespace
 
 void start() {
@@ -69,6 +83,9 @@ Instance::Instance()
 					pause(AudioMsgId::Type::Song);
 				}
 			});
+			subscribe(Auth().documentUpdated, [this](DocumentData *document) {
+				documentUpdated(document);
+			});
 		}
 	};
 	subscribe(Messenger::Instance().authSessionChanged(), [handleAuthSessionChange] {
@@ -133,6 +150,9 @@ void Instance::playlistUpdated(not_null<Data*> data) {
 		data->playlistIndex = base::none;
 	}
 	data->playlistChanges.fire({});
+	if (data->isPlaying) {
+		preloadTracks(data);
+	}
 }
 
 bool Instance::validPlaylist(not_null<Data*> data) {
@@ -424,32 +444,98 @@ void Instance::emitUpdate(AudioMsgId::Type type, CheckCallback check) {
 		if (data->isPlaying != isPlaying) {
 			data->isPlaying = isPlaying;
 			if (data->isPlaying) {
-				preloadNext(data);
+				preloadTracks(data);
 			}
 		}
 	}
 }
 
-void Instance::preloadNext(not_null<Data*> data) {
+void Instance::preloadTracks(not_null<Data*> data) {
 	if (!data->current || !data->playlistSlice || !data->playlistIndex) {
 		return;
 	}
-	const auto nextIndex = *data->playlistIndex + 1;
-	if (const auto item = itemByIndex(data, nextIndex)) {
-		if (const auto media = item->media()) {
-			if (const auto document = media->document()) {
-				const auto isLoaded = document->loaded(
-					DocumentData::FilePathResolveSaveFromDataSilent);
-				if (!isLoaded) {
-					DocumentOpenClickHandler::Open(
-						item->fullId(),
-						document,
-						item,
-						ActionOnLoadNone);
-				}
+	const auto current = data->current.audio();
+	const auto inWindow = [&](not_null<DocumentData*> document) {
+		for (auto i = 1; i <= kPreloadTracks; ++i) {
+			const auto item = itemByIndex(data, *data->playlistIndex + i);
+			if (ItemDocument(item) == document) {
+				return true;
 			}
 		}
+		return false;
+	};
+	if (const auto preloading = data->preloading) {
+		if (preloading->loadingInBackground()
+			&& (preloading == current || inWindow(preloading))) {
+			// Download one track at a time.
+			return;
+		}
+		data->preloading = nullptr;
+		if (preloading->loadingInBackground()) {
+			// Don't cancel the loads requested by the user meanwhile.
+			preloading->cancel();
+		}
+	}
+	if (current && current->loading()) {
+		// Leave the bandwidth to the track that is being played.
+		return;
+	}
+
+	auto size = int64(0);
+	for (auto i = 1; i <= kPreloadTracks; ++i) {
+		const auto item = itemByIndex(data, *data->playlistIndex + i);
+		const auto document = ItemDocument(item);
+		if (!document
+			|| (!document->isAudioFile()
+				&& !document->isVoiceMessage()
+				&& !document->isVideoMessage())) {
+			// Round videos are played in the voice playlist as well.
+			continue;
+		} else if (document->loaded(
+				DocumentData::FilePathResolveSaveFromDataSilent)) {
+			prepareTrackInfo(document);
+			continue;
+		}
+		size += document->size;
+		if (i > 1 && size > kPreloadSizeLimit) {
+			return;
+		} else if (document->loading()
+			|| !data->preloadRequested.emplace(document).second) {
+			// Already loading by request or failed to load before.
+			continue;
+		}
+		DEBUG_LOG(("Player Info: preloading track %1 of %2, %3 bytes."
+			).arg(i
+			).arg(kPreloadTracks
+			).arg(document->size));
+		if (document->loadInBackground(item->fullId())) {
+			data->preloading = document;
+			return;
+		}
+	}
+}
+
+void Instance::prepareTrackInfo(not_null<DocumentData*> document) {
+	// Count the waveform right away so the playlist is painted ready.
+	if (const auto voice = document->voice()) {
+		if (voice->waveform.isEmpty()) {
+			Local::countVoiceWaveform(document);
+		}
+	}
+}
+
+void Instance::documentUpdated(not_null<DocumentData*> document) {
+	if (document->loading()) {
+		return;
 	}
+	const auto check = [&](not_null<Data*> data) {
+		if (data->preloading == document
+			|| (data->current.audio() == document && data->isPlaying)) {
+			preloadTracks(data);
+		}
+	};
+	check(&_songData);
+	check(&_voiceData);
 }
 
 void Instance::handleLogout() {
@@ -147,6 +147,8 @@ private:
 		rpl::event_stream<> playlistChanges;
 		History *history = nullptr;
 		History *migrated = nullptr;
+		DocumentData *preloading = nullptr;
+		base::flat_set<not_null<DocumentData*>> preloadRequested;
 		bool repeatEnabled = false;
 		bool isPlaying = false;
 	};
@@ -161,7 +163,9 @@ private:
 	void validatePlaylist(not_null<Data*> data);
 	void playlistUpdated(not_null<Data*> data);
 	bool moveInPlaylist(not_null<Data*> data, int delta, bool autonext);
-	void preloadNext(not_null<Data*> data);
+	void preloadTracks(not_null<Data*> data);
+	void prepareTrackInfo(not_null<DocumentData*> document);
+	void documentUpdated(not_null<DocumentData*> document);
 	HistoryItem *itemByIndex(not_null<Data*> data, int index);
 	void handleLogout();
 
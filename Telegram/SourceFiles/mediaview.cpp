@@ -17,6 +17,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/widgets/buttons.h"
 #include "ui/text_options.h"
 #include "media/media_clip_reader.h"
+#include "media/media_streaming_loader.h"
 #include "media/view/media_clip_controller.h"
 #include "media/view/media_view_group_thumbs.h"
 #include "media/media_audio.h"
@@ -113,6 +114,10 @@ MediaView::MediaView()
 		} else {
 			_sharedMedia = nullptr;
 			_userPhotos = nullptr;
+
+			// The streamed document is owned by the destroyed session.
+			_gif = nullptr;
+			_streamed = nullptr;
 		}
 	};
 	subscribe(Messenger::Instance().authSessionChanged(), [handleAuthSessionChange] {
@@ -227,6 +232,7 @@ bool MediaView::gifShown() const {
 
 void MediaView::stopGif() {
 	_gif = nullptr;
+	_streamed = nullptr;
 	_videoPaused = _videoStopped = _videoIsSilent = false;
 	_fullScreenVideo = false;
 	_clipController.destroy();
@@ -907,7 +913,13 @@ void MediaView::clipCallback(Media::Clip::Notification notification) {
 	case NotificationReinit: {
 		if (auto item = App::histItemById(_msgid)) {
 			if (_gif->state() == State::Error) {
+				const auto streamed = (_streamed != nullptr);
 				stopGif();
+				if (streamed) {
+					// Fall back to the regular download of the document.
+					_streamingFailed = _doc;
+					displayDocument(_doc, item);
+				}
 				updateControls();
 				update();
 				break;
@@ -1691,6 +1703,8 @@ void MediaView::initAnimation() {
 	} else if (location.accessEnable()) {
 		createClipReader();
 		location.accessDisable();
+	} else if (canStreamDocument()) {
+		createClipReader();
 	} else if (_doc->dimensions.width() && _doc->dimensions.height()) {
 		auto w = _doc->dimensions.width();
 		auto h = _doc->dimensions.height();
@@ -1715,12 +1729,7 @@ void MediaView::createClipReader() {
 	} else {
 		_current = _doc->thumb->pixNoCache(fileOrigin(), _doc->thumb->width(), _doc->thumb->height(), videoThumbOptions(), st::mediaviewFileIconSize, st::mediaviewFileIconSize);
 	}
-	auto mode = (_doc->isVideoFile() || _doc->isVideoMessage())
-		? Media::Clip::Reader::Mode::Video
-		: Media::Clip::Reader::Mode::Gif;
-	_gif = Media::Clip::MakeReader(_doc, _msgid, [this](Media::Clip::Notification notification) {
-		clipCallback(notification);
-	}, mode);
+	_gif = makeClipReader(_doc->isVideoFile() || _doc->isVideoMessage());
 
 	// Correct values will be set when gif gets inited.
 	_videoPaused = _videoIsSilent = _videoStopped = false;
@@ -1730,6 +1739,43 @@ void MediaView::createClipReader() {
 	createClipController();
 }
 
+bool MediaView::canStreamDocument() const {
+	return _doc
+		&& (_doc != _streamingFailed)
+		&& Media::Streaming::Supported(_doc);
+}
+
+Media::Clip::ReaderPointer MediaView::makeClipReader(
+		bool video,
+		TimeMs positionMs) {
+	const auto mode = video
+		? Media::Clip::Reader::Mode::Video
+		: Media::Clip::Reader::Mode::Gif;
+	auto callback = [this](Media::Clip::Notification notification) {
+		clipCallback(notification);
+	};
+	if (!canStreamDocument()) {
+		_streamed = nullptr;
+		return Media::Clip::MakeReader(
+			_doc,
+			_msgid,
+			std::move(callback),
+			mode,
+			positionMs);
+	} else if (!_streamed) {
+		_streamed = std::make_unique<Media::Streaming::Loader>(
+			_doc,
+			fileOrigin());
+	}
+	return Media::Clip::MakeReader(
+		_doc,
+		_msgid,
+		_streamed->source(),
+		std::move(callback),
+		mode,
+		positionMs);
+}
+
 void MediaView::initThemePreview() {
 	Assert(_doc && _doc->isTheme());
 
@@ -1853,9 +1899,7 @@ void MediaView::restartVideoAtSeekPosition(TimeMs positionMs) {
 		auto rounding = (_doc && _doc->isVideoMessage()) ? ImageRoundRadius::Ellipse : ImageRoundRadius::None;
 		_current = _gif->current(_gif->width() / cIntRetinaFactor(), _gif->height() / cIntRetinaFactor(), _gif->width() / cIntRetinaFactor(), _gif->height() / cIntRetinaFactor(), rounding, RectPart::AllCorners, getms());
 	}
-	_gif = Media::Clip::MakeReader(_doc, _msgid, [this](Media::Clip::Notification notification) {
-		clipCallback(notification);
-	}, Media::Clip::Reader::Mode::Video, positionMs);
+	_gif = makeClipReader(true, positionMs);
 
 	// Correct values will be set when gif gets inited.
 	_videoPaused = _videoIsSilent = _videoStopped = false;
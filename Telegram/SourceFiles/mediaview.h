@@ -19,6 +19,9 @@ struct TrackState;
 namespace Clip {
 class Controller;
 } // namespace Clip
+namespace Streaming {
+class Loader;
+} // namespace Streaming
 namespace View {
 class GroupThumbs;
 } // namespace View
@@ -207,6 +210,10 @@ private:
 
 	void initAnimation();
 	void createClipReader();
+	bool canStreamDocument() const;
+	Media::Clip::ReaderPointer makeClipReader(
+		bool video,
+		TimeMs positionMs = 0);
 	Images::Options videoThumbOptions() const;
 
 	void initThemePreview();
@@ -290,6 +297,8 @@ private:
 	int32 _dragging = 0;
 	QPixmap _current;
 	Media::Clip::ReaderPointer _gif;
+	std::unique_ptr<Media::Streaming::Loader> _streamed;
+	DocumentData *_streamingFailed = nullptr;
 	int32 _full = -1; // -1 - thumb, 0 - medium, 1 - full
 
 	// Video without audio stream playback information.
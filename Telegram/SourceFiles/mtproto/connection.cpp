@@ -52,6 +52,37 @@ constexpr auto kRequestConfigTimeout = TimeMs(8000);
 // Don't try to handle messages larger than this size.
 constexpr auto kMaxMessageLength = 16 * 1024 * 1024;
 
+// Requests that don't fit in a container of this size (in ints)
+// are left for the next one, so that one big request, like a file part,
+// doesn't delay the small ones queued after it.
+constexpr auto kContainerSizeTarget = 8 * 1024;
+constexpr auto kContainerMessagesLimit = 1000;
+
+constexpr auto kSendStatsPeriod = TimeMs(60000);
+
+// Returns true if some requests were left in the queue.
+bool TakeContainerRequests(PreRequestMap &queue, PreRequestMap &result) {
+	auto size = 0;
+	auto left = false;
+	for (auto i = queue.begin(); i != queue.end();) {
+		const auto requestSize = int(i.value().messageSize());
+		const auto fits = result.isEmpty()
+			|| (result.size() < kContainerMessagesLimit
+				&& size + requestSize <= kContainerSizeTarget);
+
+		// Invoke-after chains must keep their order.
+		if (!fits || (left && i.value()->after)) {
+			left = true;
+			++i;
+			continue;
+		}
+		size += requestSize;
+		result.insert(i.key(), i.value());
+		i = queue.erase(i);
+	}
+	return left;
+}
+
 QString LogIdsVector(const QVector<MTPlong> &ids) {
 	if (!ids.size()) return "[]";
 	auto idsStr = QString("[%1").arg(ids.cbegin()->v);
@@ -528,7 +559,7 @@ void ConnectionPrivate::resetSession() { // recreate all msg_id and msg_seqno
 			mtpMsgId id = i.key();
 			if (id > newId) {
 				while (true) {
-					if (toResend.constFind(newId) == toResend.cend() && wereAcked.constFind(newId) == wereAcked.cend() && haveSent.constFind(newId) == haveSent.cend()) {
+					if (!toResend.contains(newId) && !wereAcked.contains(newId) && haveSent.constFind(newId) == haveSent.cend()) {
 						break;
 					}
 					mtpMsgId m = msgid();
@@ -545,17 +576,17 @@ void ConnectionPrivate::resetSession() { // recreate all msg_id and msg_seqno
 			setSeqNumbers.insert(id, i.value());
 		}
 	}
-	for (auto i = toResend.cbegin(), e = toResend.cend(); i != e; ++i) { // collect all non-container requests
-		const auto j = toSend.constFind(i.value());
+	for (const auto &[msgId, requestId] : toResend) { // collect all non-container requests
+		const auto j = toSend.constFind(requestId);
 		if (j == toSend.cend()) continue;
 
 		if (!j.value().isSentContainer()) {
 			if (!*(mtpMsgId*)(j.value()->constData() + 4)) continue;
 
-			mtpMsgId id = i.key();
+			mtpMsgId id = msgId;
 			if (id > newId) {
 				while (true) {
-					if (toResend.constFind(newId) == toResend.cend() && wereAcked.constFind(newId) == wereAcked.cend() && haveSent.constFind(newId) == haveSent.cend()) {
+					if (!toResend.contains(newId) && !wereAcked.contains(newId) && haveSent.constFind(newId) == haveSent.cend()) {
 						break;
 					}
 					mtpMsgId m = msgid();
@@ -590,16 +621,16 @@ void ConnectionPrivate::resetSession() { // recreate all msg_id and msg_seqno
 				haveSent.insert(i.value(), req);
 			}
 			const auto k = toResend.find(i.key());
-			if (k != toResend.cend()) {
-				const auto req = k.value();
+			if (k != toResend.end()) {
+				const auto req = k->second;
 				toResend.erase(k);
-				toResend.insert(i.value(), req);
+				toResend[i.value()] = req;
 			}
 			const auto l = wereAcked.find(i.key());
-			if (l != wereAcked.cend()) {
-				const auto req = l.value();
+			if (l != wereAcked.end()) {
+				const auto req = l->second;
 				wereAcked.erase(l);
-				wereAcked.insert(i.value(), req);
+				wereAcked[i.value()] = req;
 			}
 		}
 		for (auto i = haveSent.cbegin(), e = haveSent.cend(); i != e; ++i) { // replace msgIds in saved containers
@@ -630,11 +661,7 @@ mtpMsgId ConnectionPrivate::prepareToSend(SecureRequest &request, mtpMsgId curre
 	mtpMsgId msgId = *(mtpMsgId*)(request->constData() + 4);
 	if (msgId) { // resending this request
 		QWriteLocker locker(sessionData->toResendMutex());
-		auto &toResend = sessionData->toResendMap();
-		const auto i = toResend.find(msgId);
-		if (i != toResend.cend()) {
-			toResend.erase(i);
-		}
+		sessionData->toResendMap().remove(msgId);
 	} else {
 		msgId = *(mtpMsgId*)(request->data() + 4) = currentLastId;
 		*(request->data() + 6) = sessionData->nextRequestSeqNumber(request.needAck());
@@ -656,7 +683,7 @@ mtpMsgId ConnectionPrivate::replaceMsgId(SecureRequest &request, mtpMsgId newId)
 			auto &haveSent = sessionData->haveSentMap();
 
 			while (true) {
-				if (toResend.constFind(newId) == toResend.cend() && wereAcked.constFind(newId) == wereAcked.cend() && haveSent.constFind(newId) == haveSent.cend()) {
+				if (!toResend.contains(newId) && !wereAcked.contains(newId) && haveSent.constFind(newId) == haveSent.cend()) {
 					break;
 				}
 				const auto m = msgid();
@@ -666,17 +693,17 @@ mtpMsgId ConnectionPrivate::replaceMsgId(SecureRequest &request, mtpMsgId newId)
 			}
 
 			const auto i = toResend.find(oldMsgId);
-			if (i != toResend.cend()) {
-				const auto req = i.value();
+			if (i != toResend.end()) {
+				const auto req = i->second;
 				toResend.erase(i);
-				toResend.insert(newId, req);
+				toResend[newId] = req;
 			}
 
 			const auto j = wereAcked.find(oldMsgId);
-			if (j != wereAcked.cend()) {
-				const auto req = j.value();
+			if (j != wereAcked.end()) {
+				const auto req = j->second;
 				wereAcked.erase(j);
-				wereAcked.insert(newId, req);
+				wereAcked[newId] = req;
 			}
 
 			const auto k = haveSent.find(oldMsgId);
@@ -854,13 +881,22 @@ void ConnectionPrivate::tryToSend() {
 	}
 
 	bool needAnyResponse = false;
+	auto needToSendMore = false;
+	auto containerCount = 0;
 	SecureRequest toSendRequest;
 	{
+		// The queue is locked until the taken requests are put to haveSent,
+		// so Session::cancel() finds each of them in one of the maps.
 		QWriteLocker locker1(sessionData->toSendMutex());
 
-		auto toSendDummy = PreRequestMap();
-		auto &toSend = prependOnly ? toSendDummy : sessionData->toSendMap();
-		if (prependOnly) locker1.unlock();
+		auto toSend = PreRequestMap();
+		if (prependOnly) {
+			locker1.unlock();
+		} else {
+			needToSendMore = TakeContainerRequests(
+				sessionData->toSendMap(),
+				toSend);
+		}
 
 		uint32 toSendCount = toSend.size();
 		if (pingRequest) ++toSendCount;
@@ -874,10 +910,6 @@ void ConnectionPrivate::tryToSend() {
 		auto first = pingRequest ? pingRequest : (ackRequest ? ackRequest : (resendRequest ? resendRequest : (stateRequest ? stateRequest : (httpWaitRequest ? httpWaitRequest : toSend.cbegin().value()))));
 		if (toSendCount == 1 && first->msDate > 0) { // if can send without container
 			toSendRequest = first;
-			if (!prependOnly) {
-				toSend.clear();
-				locker1.unlock();
-			}
 
 			mtpMsgId msgId = prepareToSend(toSendRequest, msgid());
 			if (pingRequest) {
@@ -922,7 +954,7 @@ void ConnectionPrivate::tryToSend() {
 					needAnyResponse = true;
 				} else {
 					QWriteLocker locker3(sessionData->wereAckedMutex());
-					sessionData->wereAckedMap().insert(msgId, toSendRequest->requestId);
+					sessionData->wereAckedMap()[msgId] = toSendRequest->requestId;
 				}
 			}
 		} else { // send in container
@@ -1006,7 +1038,7 @@ void ConnectionPrivate::tryToSend() {
 
 						needAnyResponse = true;
 					} else {
-						wereAcked.insert(msgId, req->requestId);
+						wereAcked[msgId] = req->requestId;
 					}
 				}
 				if (!added) {
@@ -1029,12 +1061,44 @@ void ConnectionPrivate::tryToSend() {
 			(*haveSentIdsWrap)[6] = 0; // for container, msDate = 0, seqNo = 0
 			haveSent.insert(contMsgId, haveSentIdsWrap);
 			toSend.clear();
+			containerCount = toSendCount;
 		}
 	}
+	countSentPacket(containerCount, toSendRequest->size());
 	sendSecureRequest(
 		std::move(toSendRequest),
 		needAnyResponse,
 		lockFinished);
+	if (needToSendMore) {
+		emit needToSendAsync();
+	}
+}
+
+void ConnectionPrivate::countSentPacket(int containerCount, int size) {
+	const auto now = getms(true);
+	if (!_sendStats.started) {
+		_sendStats.started = now;
+	}
+	++_sendStats.packets;
+	if (containerCount) {
+		++_sendStats.containers;
+		_sendStats.containerMessages += containerCount;
+		_sendStats.containerSize += size;
+	}
+	if (now - _sendStats.started < kSendStatsPeriod) {
+		return;
+	}
+	const auto seconds = (now - _sendStats.started) / 1000.;
+	const auto containers = std::max(_sendStats.containers, 1);
+	DEBUG_LOG(("MTP Info: dc %1 sent %2 packets per second, "
+		"%3% in containers, %4 messages per container, %5% full."
+		).arg(_shiftedDcId
+		).arg(_sendStats.packets / seconds, 0, 'f', 2
+		).arg(_sendStats.containers * 100 / _sendStats.packets
+		).arg(_sendStats.containerMessages / double(containers), 0, 'f', 1
+		).arg(_sendStats.containerSize * 100
+			/ (int64(containers) * kContainerSizeTarget)));
+	_sendStats = SendStats();
 }
 
 void ConnectionPrivate::retryByTimer() {
@@ -1566,16 +1630,8 @@ void ConnectionPrivate::handleReceived() {
 			emit sendAnythingAsync(MTPAckSendWaiting);
 		}
 
-		bool emitSignal = false;
-		{
-			QReadLocker locker(sessionData->haveReceivedMutex());
-			emitSignal = !sessionData->haveReceivedResponses().isEmpty() || !sessionData->haveReceivedUpdates().isEmpty();
-			if (emitSignal) {
-				DEBUG_LOG(("MTP Info: emitting needToReceive() - need to parse in another thread, %1 responses, %2 updates.").arg(sessionData->haveReceivedResponses().size()).arg(sessionData->haveReceivedUpdates().size()));
-			}
-		}
-
-		if (emitSignal) {
+		if (sessionData->hasReceived()) {
+			DEBUG_LOG(("MTP Info: emitting needToReceive() - need to parse in another thread, %1 responses, %2 updates.").arg(sessionData->receivedResponsesCount()).arg(sessionData->receivedUpdatesCount()));
 			emit needToReceive();
 		}
 
@@ -1839,7 +1895,6 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 
 			QReadLocker locker(sessionData->wereAckedMutex());
 			const auto &wereAcked = sessionData->wereAckedMap();
-			const auto wereAckedEnd = wereAcked.cend();
 
 			for (uint32 i = 0, l = idsCount; i < l; ++i) {
 				char state = 0;
@@ -1854,7 +1909,7 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 						state |= 0x02;
 					} else {
 						state |= 0x04;
-						if (wereAcked.constFind(reqMsgId) != wereAckedEnd) {
+						if (wereAcked.contains(reqMsgId)) {
 							state |= 0x80; // we know, that server knows, that we received request
 						}
 						if (msgIdState == ReceivedMsgIds::State::NeedsAck) { // need ack, so we sent ack
@@ -2062,8 +2117,7 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 		auto requestId = wasSent(reqMsgId.v);
 		if (requestId && requestId != mtpRequestId(0xFFFFFFFF)) {
 			// Save rpc_result for processing in the main thread.
-			QWriteLocker locker(sessionData->haveReceivedMutex());
-			sessionData->haveReceivedResponses().insert(requestId, response);
+			sessionData->pushReceivedResponse(requestId, response);
 		} else {
 			DEBUG_LOG(("RPC Info: requestId not found for msgId %1").arg(reqMsgId.v));
 		}
@@ -2104,8 +2158,7 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 		if (from > start) memcpy(update.data(), start, (from - start) * sizeof(mtpPrime));
 
 		// Notify main process about new session - need to get difference.
-		QWriteLocker locker(sessionData->haveReceivedMutex());
-		sessionData->haveReceivedUpdates().push_back(SerializedMessage(update));
+		sessionData->pushReceivedUpdate(std::move(update));
 	} return HandleResult::Success;
 
 	case mtpc_ping: {
@@ -2161,8 +2214,7 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 		if (end > from) memcpy(update.data(), from, (end - from) * sizeof(mtpPrime));
 
 		// Notify main process about the new updates.
-		QWriteLocker locker(sessionData->haveReceivedMutex());
-		sessionData->haveReceivedUpdates().push_back(SerializedMessage(update));
+		sessionData->pushReceivedUpdate(std::move(update));
 
 		if (cons != mtpc_updatesTooLong
 			&& cons != mtpc_updateShortMessage
@@ -2277,7 +2329,7 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 							moveToAcked = !_instance->hasCallbacks(reqId);
 						}
 						if (moveToAcked) {
-							wereAcked.insert(msgId, reqId);
+							wereAcked[msgId] = reqId;
 							haveSent.erase(req);
 						} else {
 							DEBUG_LOG(("Message Info: ignoring ACK for msgId %1 because request %2 requires a response").arg(msgId).arg(reqId));
@@ -2288,8 +2340,8 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 					QWriteLocker locker3(sessionData->toResendMutex());
 					auto &toResend = sessionData->toResendMap();
 					const auto reqIt = toResend.find(msgId);
-					if (reqIt != toResend.cend()) {
-						const auto reqId = reqIt.value();
+					if (reqIt != toResend.end()) {
+						const auto reqId = reqIt->second;
 						bool moveToAcked = byResponse;
 						if (!moveToAcked) { // ignore ACK, if we need a response (if we have a handler)
 							moveToAcked = !_instance->hasCallbacks(reqId);
@@ -2299,7 +2351,7 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 							auto &toSend = sessionData->toSendMap();
 							const auto req = toSend.find(reqId);
 							if (req != toSend.cend()) {
-								wereAcked.insert(msgId, req.value()->requestId);
+								wereAcked[msgId] = req.value()->requestId;
 								if (req.value()->requestId != reqId) {
 									DEBUG_LOG(("Message Error: for msgId %1 found resent request, requestId %2, contains requestId %3").arg(msgId).arg(reqId).arg(req.value()->requestId));
 								} else {
@@ -2324,13 +2376,13 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 		if (ackedCount > MTPIdsBufferSize) {
 			DEBUG_LOG(("Message Info: removing some old acked sent msgIds %1").arg(ackedCount - MTPIdsBufferSize));
 			clearedBecauseTooOld.reserve(ackedCount - MTPIdsBufferSize);
-			while (ackedCount-- > MTPIdsBufferSize) {
-				auto i = wereAcked.begin();
+			const auto tooOld = wereAcked.begin() + (ackedCount - MTPIdsBufferSize);
+			for (auto i = wereAcked.begin(); i != tooOld; ++i) {
 				clearedBecauseTooOld.push_back(RPCCallbackClear(
-					i.value(),
+					i->second,
 					RPCError::TimeoutError));
-				wereAcked.erase(i);
 			}
+			wereAcked.erase(wereAcked.begin(), tooOld);
 		}
 	}
 
@@ -2366,8 +2418,7 @@ void ConnectionPrivate::handleMsgsStates(const QVector<MTPlong> &ids, const QByt
 				DEBUG_LOG(("Message Info: state was received for msgId %1, but request is not found, looking in resent requests...").arg(requestMsgId));
 				QWriteLocker locker2(sessionData->toResendMutex());
 				auto &toResend = sessionData->toResendMap();
-				const auto reqIt = toResend.find(requestMsgId);
-				if (reqIt != toResend.cend()) {
+				if (toResend.contains(requestMsgId)) {
 					if ((state & 0x07) != 0x04) { // was received
 						DEBUG_LOG(("Message Info: state was received for msgId %1, state %2, already resending in container").arg(requestMsgId).arg((int32)state));
 					} else {
@@ -2888,7 +2939,7 @@ void ConnectionPrivate::dhClientParamsAnswered() {
 		DEBUG_LOG(("AuthKey Info: auth key gen succeed, id: %1, server salt: %2").arg(authKey->keyId()).arg(serverSalt));
 
 		sessionData->owner()->notifyKeyCreated(std::move(authKey)); // slot will call authKeyCreated()
-		sessionData->clear(_instance);
+		sessionData->clear();
 		unlockKey();
 	} return;
 
@@ -3200,14 +3251,14 @@ mtpRequestId ConnectionPrivate::wasSent(mtpMsgId msgId) const {
 	{
 		QReadLocker locker(sessionData->toResendMutex());
 		const auto &toResend = sessionData->toResendMap();
-		const auto i = toResend.constFind(msgId);
-		if (i != toResend.cend()) return i.value();
+		const auto i = toResend.find(msgId);
+		if (i != toResend.end()) return i->second;
 	}
 	{
 		QReadLocker locker(sessionData->wereAckedMutex());
 		const auto &wereAcked = sessionData->wereAckedMap();
-		const auto i = wereAcked.constFind(msgId);
-		if (i != wereAcked.cend()) return i.value();
+		const auto i = wereAcked.find(msgId);
+		if (i != wereAcked.end()) return i->second;
 	}
 	return 0;
 }
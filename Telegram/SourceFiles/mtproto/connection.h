@@ -147,6 +147,13 @@ private:
 		ConnectionPointer data;
 		int priority = 0;
 	};
+	struct SendStats {
+		TimeMs started = 0;
+		int packets = 0;
+		int containers = 0;
+		int containerMessages = 0;
+		int64 containerSize = 0;
+	};
 	void connectToServer(bool afterConfig = false);
 	void doDisconnect();
 	void restart();
@@ -183,6 +190,7 @@ private:
 		SecureRequest &&request,
 		bool needAnyResponse,
 		QReadLocker &lockFinished);
+	void countSentPacket(int containerCount, int size);
 	mtpRequestId wasSent(mtpMsgId msgId) const;
 
 	enum class HandleResult {
@@ -259,6 +267,8 @@ private:
 	mtpMsgId _pingMsgId = 0;
 	base::Timer _pingSender;
 
+	SendStats _sendStats;
+
 	bool restarted = false;
 	bool _finished = false;
 
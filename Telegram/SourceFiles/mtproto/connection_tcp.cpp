@@ -23,6 +23,7 @@ constexpr auto kPacketSizeMax = int(0x01000000 * sizeof(mtpPrime));
 constexpr auto kFullConnectionTimeout = 8 * TimeMs(1000);
 constexpr auto kSmallBufferSize = 256 * 1024;
 constexpr auto kMinPacketBuffer = 256;
+constexpr auto kCopyStatsPeriod = int64(16 * 1024 * 1024);
 
 using ErrorSignal = void(QTcpSocket::*)(QAbstractSocket::SocketError);
 const auto QTcpSocket_error = ErrorSignal(&QAbstractSocket::error);
@@ -43,6 +44,7 @@ public:
 	static constexpr auto kUnknownSize = -1;
 	static constexpr auto kInvalidSize = -2;
 	virtual int readPacketLength(bytes::const_span bytes) const = 0;
+	virtual int readPacketHeaderLength(bytes::const_span bytes) const = 0;
 	virtual bytes::const_span readPacket(bytes::const_span bytes) const = 0;
 
 	virtual ~Protocol() = default;
@@ -64,6 +66,7 @@ public:
 	bytes::span finalizePacket(mtpBuffer &buffer) override;
 
 	int readPacketLength(bytes::const_span bytes) const override;
+	int readPacketHeaderLength(bytes::const_span bytes) const override;
 	bytes::const_span readPacket(bytes::const_span bytes) const override;
 
 };
@@ -128,13 +131,20 @@ int TcpConnection::Protocol::Version0::readPacketLength(
 	return kInvalidSize;
 }
 
+int TcpConnection::Protocol::Version0::readPacketHeaderLength(
+		bytes::const_span bytes) const {
+	Expects(!bytes.empty());
+
+	return (static_cast<char>(bytes[0]) == 0x7F) ? 4 : 1;
+}
+
 bytes::const_span TcpConnection::Protocol::Version0::readPacket(
 		bytes::const_span bytes) const {
 	const auto size = readPacketLength(bytes);
 	Assert(size != kUnknownSize
 		&& size != kInvalidSize
 		&& size <= bytes.size());
-	const auto sizeLength = (static_cast<char>(bytes[0]) == 0x7F) ? 4 : 1;
+	const auto sizeLength = readPacketHeaderLength(bytes);
 	return bytes.subspan(sizeLength, size - sizeLength);
 }
 
@@ -175,6 +185,7 @@ public:
 	bytes::span finalizePacket(mtpBuffer &buffer) override;
 
 	int readPacketLength(bytes::const_span bytes) const override;
+	int readPacketHeaderLength(bytes::const_span bytes) const override;
 	bytes::const_span readPacket(bytes::const_span bytes) const override;
 
 };
@@ -213,13 +224,18 @@ int TcpConnection::Protocol::VersionD::readPacketLength(
 		: kInvalidSize;
 }
 
+int TcpConnection::Protocol::VersionD::readPacketHeaderLength(
+		bytes::const_span bytes) const {
+	return 4;
+}
+
 bytes::const_span TcpConnection::Protocol::VersionD::readPacket(
 		bytes::const_span bytes) const {
 	const auto size = readPacketLength(bytes);
 	Assert(size != kUnknownSize
 		&& size != kInvalidSize
 		&& size <= bytes.size());
-	const auto sizeLength = 4;
+	const auto sizeLength = readPacketHeaderLength(bytes);
 	return bytes.subspan(sizeLength, size - sizeLength);
 }
 
@@ -268,36 +284,88 @@ ConnectionPointer TcpConnection::clone(const ProxyData &proxy) {
 }
 
 void TcpConnection::ensureAvailableInBuffer(int amount) {
-	auto &buffer = _usingLargeBuffer ? _largeBuffer : _smallBuffer;
-	const auto full = bytes::make_span(buffer).subspan(
+	Expects(amount <= kSmallBufferSize);
+
+	const auto full = bytes::make_span(_smallBuffer).subspan(
 		_offsetBytes);
 	if (full.size() >= amount) {
 		return;
 	}
 	const auto read = full.subspan(0, _readBytes);
-	if (amount <= _smallBuffer.size()) {
-		if (_usingLargeBuffer) {
-			bytes::copy(_smallBuffer, read);
-			_usingLargeBuffer = false;
-			_largeBuffer.clear();
-		} else {
-			bytes::move(_smallBuffer, read);
-		}
-	} else if (amount <= _largeBuffer.size()) {
-		Assert(_usingLargeBuffer);
-		bytes::move(_largeBuffer, read);
-	} else {
-		auto enough = bytes::vector(amount);
-		bytes::copy(enough, read);
-		_largeBuffer = std::move(enough);
-		_usingLargeBuffer = true;
-	}
+	bytes::move(_smallBuffer, read);
+	countCopied(read.size());
 	_offsetBytes = 0;
 }
 
-void TcpConnection::socketRead() {
-	Expects(_leftBytes > 0 || !_usingLargeBuffer);
+bytes::span TcpConnection::largePacketBytes() {
+	return bytes::make_span(_largePacket).subspan(0, _largePacketSize);
+}
+
+void TcpConnection::startLargePacket(
+		bytes::const_span available,
+		int packetSize) {
+	const auto header = _protocol->readPacketHeaderLength(available);
+	const auto read = available.subspan(header);
+	_largePacketSize = packetSize - header;
+	_largePacket.resize(
+		(_largePacketSize + sizeof(mtpPrime) - 1) / sizeof(mtpPrime));
+	bytes::copy(largePacketBytes(), read);
+	countCopied(read.size());
+	_largePacketRead = read.size();
+}
 
+bool TcpConnection::readLargePacket() {
+	const auto free = largePacketBytes().subspan(_largePacketRead);
+	const auto readCount = _socket.read(
+		reinterpret_cast<char*>(free.data()),
+		free.size());
+	if (readCount < 0) {
+		LOG(("TCP Error: socket read return %1").arg(readCount));
+		emit error(kErrorCodeOther);
+		return false;
+	} else if (!readCount) {
+		TCP_LOG(("TCP Info: no bytes read, but bytes available was true..."));
+		return false;
+	}
+	aesCtrEncrypt(free.subspan(0, readCount), _receiveKey, &_receiveState);
+	TCP_LOG(("TCP Info: read %1 bytes").arg(readCount));
+	countTransferred(readCount);
+
+	_largePacketRead += readCount;
+	if (_largePacketRead < _largePacketSize) {
+		TCP_LOG(("TCP Info: not enough %1 for packet! read %2"
+			).arg(_largePacketSize - _largePacketRead
+			).arg(_largePacketRead));
+		emit receivedSome();
+		return true;
+	}
+	TCP_LOG(("TCP Info: packet received, size = %1"
+		).arg(_largePacketSize));
+
+	// The packet was read right into its place, only the tail
+	// that doesn't fill a whole mtpPrime is dropped, as in parsePacket().
+	auto packet = base::take(_largePacket);
+	packet.resize(_largePacketSize / sizeof(mtpPrime));
+	_largePacketSize = _largePacketRead = 0;
+	socketPacket(std::move(packet));
+	return true;
+}
+
+void TcpConnection::countCopied(int64 bytes) {
+	_copiedBytes += bytes;
+}
+
+void TcpConnection::countTransferred(int64 bytes) {
+	_transferredBytes += bytes;
+	if (_transferredBytes < kCopyStatsPeriod) {
+		return;
+	}
+	DEBUG_LOG(("TCP Info: copied %1 bytes per MB transferred."
+		).arg(_copiedBytes * 1024 * 1024 / _transferredBytes));
+	_copiedBytes = _transferredBytes = 0;
+}
+
+void TcpConnection::socketRead() {
 	if (_socket.state() != QAbstractSocket::ConnectedState) {
 		LOG(("MTP error: "
 			"socket not connected in socketRead(), state: %1"
@@ -310,13 +378,19 @@ void TcpConnection::socketRead() {
 		_smallBuffer.resize(kSmallBufferSize);
 	}
 	do {
+		if (_largePacketSize > 0) {
+			if (!readLargePacket()) {
+				return;
+			}
+			continue;
+		}
 		const auto readLimit = (_leftBytes > 0)
 			? _leftBytes
 			: (kSmallBufferSize - _offsetBytes - _readBytes);
 		Assert(readLimit > 0);
 
-		auto &buffer = _usingLargeBuffer ? _largeBuffer : _smallBuffer;
-		const auto full = bytes::make_span(buffer).subspan(_offsetBytes);
+		const auto full = bytes::make_span(_smallBuffer).subspan(
+			_offsetBytes);
 		const auto free = full.subspan(_readBytes);
 		Assert(free.size() >= readLimit);
 
@@ -327,6 +401,7 @@ void TcpConnection::socketRead() {
 			const auto read = free.subspan(0, readCount);
 			aesCtrEncrypt(read, _receiveKey, &_receiveState);
 			TCP_LOG(("TCP Info: read %1 bytes").arg(readCount));
+			countTransferred(readCount);
 
 			_readBytes += readCount;
 			if (_leftBytes > 0) {
@@ -334,8 +409,6 @@ void TcpConnection::socketRead() {
 				_leftBytes -= readCount;
 				if (!_leftBytes) {
 					socketPacket(full.subspan(0, _readBytes));
-					_usingLargeBuffer = false;
-					_largeBuffer.clear();
 					_offsetBytes = _readBytes = 0;
 				} else {
 					TCP_LOG(("TCP Info: not enough %1 for packet! read %2"
@@ -364,6 +437,18 @@ void TcpConnection::socketRead() {
 
 						// If we have too little space left in the buffer.
 						ensureAvailableInBuffer(kMinPacketBuffer);
+					} else if (packetSize > kSmallBufferSize) {
+						// Read the rest of a large packet right into
+						// the mtpBuffer that will hold it.
+						startLargePacket(available, packetSize);
+						_offsetBytes = _readBytes = 0;
+
+						TCP_LOG(("TCP Info: reading large packet, "
+							"full size %1 read %2"
+							).arg(packetSize
+							).arg(available.size()));
+						emit receivedSome();
+						break;
 					} else {
 						_leftBytes = packetSize - available.size();
 
@@ -414,6 +499,7 @@ mtpBuffer TcpConnection::parsePacket(bytes::const_span bytes) {
 	}
 	auto result = mtpBuffer(ints.size());
 	memcpy(result.data(), ints.data(), ints.size() * sizeof(mtpPrime));
+	countCopied(ints.size() * sizeof(mtpPrime));
 	return result;
 }
 
@@ -555,12 +641,20 @@ void TcpConnection::sendBuffer(mtpBuffer &&buffer) {
 	}
 
 	// buffer: 2 available int-s + data + available int.
+	// The header is written to the reserved ints and the whole packet
+	// is encrypted in place, so it is written to the socket at once.
+	const auto data = buffer.constData();
 	const auto bytes = _protocol->finalizePacket(buffer);
+	if (buffer.constData() != data) {
+		// Shared or without capacity for the padding.
+		countCopied(bytes.size());
+	}
 	TCP_LOG(("TCP Info: write packet %1 bytes").arg(bytes.size()));
 	aesCtrEncrypt(bytes, _sendKey, &_sendState);
 	_socket.write(
 		reinterpret_cast<const char*>(bytes.data()),
 		bytes.size());
+	countTransferred(bytes.size());
 }
 
 
@@ -620,8 +714,13 @@ TimeMs TcpConnection::fullConnectTimeout() const {
 void TcpConnection::socketPacket(bytes::const_span bytes) {
 	if (_status == Status::Finished) return;
 
+	socketPacket(parsePacket(bytes));
+}
+
+void TcpConnection::socketPacket(mtpBuffer &&data) {
+	if (_status == Status::Finished) return;
+
 	// old quickack?..
-	const auto data = parsePacket(bytes);
 	if (data.size() == 1) {
 		if (data[0] != 0) {
 			emit error(data[0]);
@@ -631,7 +730,7 @@ void TcpConnection::socketPacket(bytes::const_span bytes) {
 	//} else if (data.size() == 2) {
 		// new quickack?..
 	} else if (_status == Status::Ready) {
-		_receivedQueue.push_back(data);
+		_receivedQueue.push_back(std::move(data));
 		emit receivedData();
 	} else if (_status == Status::Waiting) {
 		try {
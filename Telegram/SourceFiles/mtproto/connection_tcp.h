@@ -52,6 +52,7 @@ private:
 	void writeConnectionStart();
 
 	void socketPacket(bytes::const_span bytes);
+	void socketPacket(mtpBuffer &&data);
 
 	void socketConnected();
 	void socketDisconnected();
@@ -59,6 +60,11 @@ private:
 
 	mtpBuffer parsePacket(bytes::const_span bytes);
 	void ensureAvailableInBuffer(int amount);
+	bytes::span largePacketBytes();
+	void startLargePacket(bytes::const_span available, int packetSize);
+	bool readLargePacket();
+	void countCopied(int64 bytes);
+	void countTransferred(int64 bytes);
 	static void handleError(QAbstractSocket::SocketError e, QTcpSocket &sock);
 	static uint32 fourCharsToUInt(char ch1, char ch2, char ch3, char ch4) {
 		char ch[4] = { ch1, ch2, ch3, ch4 };
@@ -74,8 +80,14 @@ private:
 	int _readBytes = 0;
 	int _leftBytes = 0;
 	bytes::vector _smallBuffer;
-	bytes::vector _largeBuffer;
-	bool _usingLargeBuffer = false;
+
+	// Packets larger than _smallBuffer are read here directly.
+	mtpBuffer _largePacket;
+	int _largePacketSize = 0;
+	int _largePacketRead = 0;
+
+	int64 _copiedBytes = 0;
+	int64 _transferredBytes = 0;
 
 	uchar _sendKey[CTRState::KeySize];
 	CTRState _sendState;
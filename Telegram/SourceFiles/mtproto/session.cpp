@@ -25,6 +25,16 @@ QString LogIds(const QVector<uint64> &ids) {
 	return idsStr + "]";
 }
 
+void AccumulateMax(std::atomic<int> &value, int candidate) {
+	auto current = value.load(std::memory_order_relaxed);
+	while (current < candidate
+		&& !value.compare_exchange_weak(
+			current,
+			candidate,
+			std::memory_order_relaxed)) {
+	}
+}
+
 } // namespace
 
 ConnectionOptions::ConnectionOptions(
@@ -75,29 +85,47 @@ void SessionData::notifyConnectionInited(const ConnectionOptions &options) {
 	}
 }
 
-void SessionData::clear(Instance *instance) {
+void SessionData::pushReceivedResponse(
+		mtpRequestId requestId,
+		const SerializedMessage &response) {
+	AccumulateMax(
+		_responsesQueueMax,
+		_receivedResponses.push({ requestId, response }));
+}
+
+void SessionData::pushReceivedUpdate(SerializedMessage &&update) {
+	AccumulateMax(
+		_updatesQueueMax,
+		_receivedUpdates.push(std::move(update)));
+}
+
+void SessionData::countLockWait(int64 nanoseconds) {
+	_lockWaits.fetch_add(1, std::memory_order_relaxed);
+	_lockWaitNs.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+SessionStats SessionData::takeStats() {
+	auto result = SessionStats();
+	result.responsesQueueMax = _responsesQueueMax.exchange(0);
+	result.updatesQueueMax = _updatesQueueMax.exchange(0);
+	result.lockWaits = _lockWaits.exchange(0);
+	result.lockWaitNs = _lockWaitNs.exchange(0);
+	return result;
+}
+
+void SessionData::clear() {
 	auto clearCallbacks = std::vector<RPCCallbackClear>();
 	{
-		QReadLocker locker1(haveSentMutex()), locker2(toResendMutex()), locker3(haveReceivedMutex()), locker4(wereAckedMutex());
-		auto receivedResponsesEnd = _receivedResponses.cend();
-		clearCallbacks.reserve(_haveSent.size() + _wereAcked.size());
+		QReadLocker locker1(haveSentMutex()), locker2(toResendMutex()), locker3(wereAckedMutex());
+		clearCallbacks.reserve(_haveSent.size() + _toResend.size() + _wereAcked.size());
 		for (auto i = _haveSent.cbegin(), e = _haveSent.cend(); i != e; ++i) {
-			auto requestId = i.value()->requestId;
-			if (!_receivedResponses.contains(requestId)) {
-				clearCallbacks.push_back(requestId);
-			}
+			clearCallbacks.push_back(i.value()->requestId);
 		}
-		for (auto i = _toResend.cbegin(), e = _toResend.cend(); i != e; ++i) {
-			auto requestId = i.value();
-			if (!_receivedResponses.contains(requestId)) {
-				clearCallbacks.push_back(requestId);
-			}
+		for (const auto &[msgId, requestId] : _toResend) {
+			clearCallbacks.push_back(requestId);
 		}
-		for (auto i = _wereAcked.cbegin(), e = _wereAcked.cend(); i != e; ++i) {
-			auto requestId = i.value();
-			if (!_receivedResponses.contains(requestId)) {
-				clearCallbacks.push_back(requestId);
-			}
+		for (const auto &[msgId, requestId] : _wereAcked) {
+			clearCallbacks.push_back(requestId);
 		}
 	}
 	{
@@ -116,7 +144,23 @@ void SessionData::clear(Instance *instance) {
 		QWriteLocker locker(receivedIdsMutex());
 		_receivedIds.clear();
 	}
-	instance->clearCallbacksDelayed(std::move(clearCallbacks));
+	_owner->clearCallbacksDelayed(std::move(clearCallbacks));
+}
+
+CountingWriteLocker::CountingWriteLocker(
+	not_null<QReadWriteLock*> lock,
+	not_null<SessionData*> data)
+: _lock(lock) {
+	if (!_lock->tryLockForWrite()) {
+		auto timer = QElapsedTimer();
+		timer.start();
+		_lock->lockForWrite();
+		data->countLockWait(timer.nsecsElapsed());
+	}
+}
+
+CountingWriteLocker::~CountingWriteLocker() {
+	_lock->unlock();
 }
 
 Session::Session(not_null<Instance*> instance, ShiftedDcId shiftedDcId) : QObject()
@@ -226,6 +270,11 @@ void Session::sendAnything(qint64 msCanWait) {
 		return;
 	}
 	auto ms = getms(true);
+	if (!msCanWait && !_ping && ms < msLastSent + MTPBatchSendWaiting) {
+		// Something was just sent, the next container can collect
+		// the rest of this burst, while a single request goes at once.
+		msCanWait = msLastSent + MTPBatchSendWaiting - ms;
+	}
 	if (msSendCall) {
 		if (ms > msSendCall + msWait) {
 			msWait = 0;
@@ -261,6 +310,7 @@ void Session::needToResumeAndSend() {
 		_connection = std::make_unique<Connection>(_instance);
 		_connection->start(&data, dcWithShift);
 	}
+	msLastSent = getms(true);
 	if (_ping) {
 		_ping = false;
 		emit needToPing();
@@ -350,6 +400,25 @@ void Session::checkRequestsByTimer() {
 		}
 		_instance->clearCallbacksDelayed(std::move(clearCallbacks));
 	}
+	logStats();
+}
+
+void Session::logStats() {
+	if (!Logs::DebugEnabled()) {
+		return;
+	}
+	const auto stats = data.takeStats();
+	if (stats.responsesQueueMax > 1
+		|| stats.updatesQueueMax > 1
+		|| stats.lockWaits > 0) {
+		DEBUG_LOG(("MTP Info: dc %1 received queues max %2 responses, "
+			"%3 updates, waited %4 times for %5us for locks."
+			).arg(dcWithShift
+			).arg(stats.responsesQueueMax
+			).arg(stats.updatesQueueMax
+			).arg(stats.lockWaits
+			).arg(stats.lockWaitNs / 1000));
+	}
 }
 
 void Session::onConnectionStateChange(qint32 newState) {
@@ -362,11 +431,11 @@ void Session::onResetDone() {
 
 void Session::cancel(mtpRequestId requestId, mtpMsgId msgId) {
 	if (requestId) {
-		QWriteLocker locker(data.toSendMutex());
+		CountingWriteLocker locker(data.toSendMutex(), &data);
 		data.toSendMap().remove(requestId);
 	}
 	if (msgId) {
-		QWriteLocker locker(data.haveSentMutex());
+		CountingWriteLocker locker(data.haveSentMutex(), &data);
 		data.haveSentMap().remove(msgId);
 	}
 }
@@ -399,7 +468,7 @@ int32 Session::requestState(mtpRequestId requestId) const {
 	}
 	if (!requestId) return MTP::RequestSent;
 
-	QWriteLocker locker(data.toSendMutex());
+	CountingWriteLocker locker(data.toSendMutex(), &data);
 	const auto &toSend = data.toSendMap();
 	const auto i = toSend.constFind(requestId);
 	if (i != toSend.cend()) {
@@ -474,7 +543,7 @@ mtpRequestId Session::resend(quint64 msgId, qint64 msCanWait, bool forceContaine
 		sendPrepared(request, msCanWait, false);
 		{
 			QWriteLocker locker(data.toResendMutex());
-			data.toResendMap().insert(msgId, request->requestId);
+			data.toResendMap()[msgId] = request->requestId;
 		}
 		return request->requestId;
 	} else {
@@ -512,7 +581,7 @@ void Session::sendPrepared(
 	DEBUG_LOG(("MTP Info: adding request to toSendMap, msCanWait %1"
 		).arg(msCanWait));
 	{
-		QWriteLocker locker(data.toSendMutex());
+		CountingWriteLocker locker(data.toSendMutex(), &data);
 		data.toSendMap().insert(request->requestId, request);
 
 		if (newRequest) {
@@ -578,39 +647,52 @@ void Session::tryToReceive() {
 		return;
 	}
 	while (true) {
-		auto requestId = mtpRequestId(0);
-		auto isUpdate = false;
+		takeReceivedResponses();
+		if (!_receivedResponses.empty()) {
+			const auto response = _receivedResponses.begin();
+			const auto requestId = response->first;
+			const auto message = std::move(response->second);
+			_receivedResponses.erase(response);
+			_instance->execCallback(requestId, message.constData(), message.constData() + message.size());
+			continue;
+		}
 		auto message = SerializedMessage();
-		{
-			QWriteLocker locker(data.haveReceivedMutex());
-			auto &responses = data.haveReceivedResponses();
-			auto response = responses.begin();
-			if (response == responses.cend()) {
-				auto &updates = data.haveReceivedUpdates();
-				auto update = updates.begin();
-				if (update == updates.cend()) {
-					return;
-				} else {
-					message = std::move(*update);
-					isUpdate = true;
-					updates.pop_front();
-				}
-			} else {
-				requestId = response.key();
-				message = std::move(response.value());
-				responses.erase(response);
-			}
+		if (!data.receivedUpdates().try_pop(message)) {
+			return;
 		}
-		if (isUpdate) {
-			if (dcWithShift == BareDcId(dcWithShift)) { // call globalCallback only in main session
-				_instance->globalCallback(message.constData(), message.constData() + message.size());
-			}
-		} else {
-			_instance->execCallback(requestId, message.constData(), message.constData() + message.size());
+		if (dcWithShift == BareDcId(dcWithShift)) { // call globalCallback only in main session
+			_instance->globalCallback(message.constData(), message.constData() + message.size());
 		}
 	}
 }
 
+void Session::takeReceivedResponses() {
+	auto &queue = data.receivedResponses();
+	auto response = ReceivedResponse();
+	while (queue.try_pop(response)) {
+		_receivedResponses.emplace(
+			response.requestId,
+			std::move(response.message));
+	}
+}
+
+void Session::clearCallbacksDelayed(std::vector<RPCCallbackClear> &&ids) {
+	if (ids.empty()) {
+		return;
+	}
+	crl::on_main(this, [=, list = std::move(ids)] {
+		// Responses already received will be processed by tryToReceive().
+		takeReceivedResponses();
+		auto filtered = list;
+		filtered.erase(ranges::remove_if(filtered, [&](
+				const RPCCallbackClear &clear) {
+			return _receivedResponses.find(clear.requestId)
+				!= _receivedResponses.end();
+		}), filtered.end());
+		_instance->clearCallbacksDelayed(std::move(filtered));
+	});
+}
+
 Session::~Session() {
 	Assert(_connection == nullptr);
 }
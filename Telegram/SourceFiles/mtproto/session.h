@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "core/single_timer.h"
 #include "mtproto/rpc_sender.h"
+#include "base/mpsc_queue.h"
 
 namespace MTP {
 
@@ -24,50 +25,38 @@ class Connection;
 using PreRequestMap = QMap<mtpRequestId, SecureRequest>;
 using RequestMap = QMap<mtpMsgId, SecureRequest>;
 
-class RequestIdsMap : public QMap<mtpMsgId, mtpRequestId> {
-public:
-	using ParentType = QMap<mtpMsgId, mtpRequestId>;
-
-	mtpMsgId min() const {
-		return size() ? cbegin().key() : 0;
-	}
-
-	mtpMsgId max() const {
-		ParentType::const_iterator e(cend());
-		return size() ? (--e).key() : 0;
-	}
-
-};
+// Message ids mostly grow, so new ids are appended to the end of the
+// flat_map and the oldest ones are erased from its front in O(1).
+using RequestIdsMap = base::flat_map<mtpMsgId, mtpRequestId>;
 
 class ReceivedMsgIds {
 public:
 	bool registerMsgId(mtpMsgId msgId, bool needAck) {
-		auto i = _idsNeedAck.constFind(msgId);
-		if (i == _idsNeedAck.cend()) {
-			if (_idsNeedAck.size() < MTPIdsBufferSize || msgId > min()) {
-				_idsNeedAck.insert(msgId, needAck);
-				return true;
-			}
-			MTP_LOG(-1, ("No need to handle - %1 < min = %2").arg(msgId).arg(min()));
-		} else {
+		if (_idsNeedAck.contains(msgId)) {
 			MTP_LOG(-1, ("No need to handle - %1 already is in map").arg(msgId));
+		} else if (_idsNeedAck.size() < MTPIdsBufferSize || msgId > min()) {
+			_idsNeedAck.emplace(msgId, needAck);
+			return true;
+		} else {
+			MTP_LOG(-1, ("No need to handle - %1 < min = %2").arg(msgId).arg(min()));
 		}
 		return false;
 	}
 
 	mtpMsgId min() const {
-		return _idsNeedAck.isEmpty() ? 0 : _idsNeedAck.cbegin().key();
+		return _idsNeedAck.empty() ? 0 : _idsNeedAck.front().first;
 	}
 
 	mtpMsgId max() const {
-		auto end = _idsNeedAck.cend();
-		return _idsNeedAck.isEmpty() ? 0 : (--end).key();
+		return _idsNeedAck.empty() ? 0 : _idsNeedAck.back().first;
 	}
 
 	void shrink() {
-		auto size = _idsNeedAck.size();
-		while (size-- > MTPIdsBufferSize) {
-			_idsNeedAck.erase(_idsNeedAck.begin());
+		const auto size = int(_idsNeedAck.size());
+		if (size > MTPIdsBufferSize) {
+			_idsNeedAck.erase(
+				_idsNeedAck.begin(),
+				_idsNeedAck.begin() + (size - MTPIdsBufferSize));
 		}
 	}
 
@@ -77,11 +66,11 @@ public:
 		NoAckNeeded,
 	};
 	State lookup(mtpMsgId msgId) const {
-		auto i = _idsNeedAck.constFind(msgId);
-		if (i == _idsNeedAck.cend()) {
+		const auto i = _idsNeedAck.find(msgId);
+		if (i == _idsNeedAck.end()) {
 			return State::NotFound;
 		}
-		return i.value() ? State::NeedsAck : State::NoAckNeeded;
+		return i->second ? State::NeedsAck : State::NoAckNeeded;
 	}
 
 	void clear() {
@@ -89,7 +78,7 @@ public:
 	}
 
 private:
-	QMap<mtpMsgId, bool> _idsNeedAck;
+	base::flat_map<mtpMsgId, bool> _idsNeedAck;
 
 };
 
@@ -129,6 +118,19 @@ struct ConnectionOptions {
 
 };
 
+struct ReceivedResponse {
+	mtpRequestId requestId = 0;
+	SerializedMessage message;
+};
+
+// Hand-off queue depth and lock contention, see SessionData::takeStats().
+struct SessionStats {
+	int responsesQueueMax = 0;
+	int updatesQueueMax = 0;
+	int lockWaits = 0;
+	int64 lockWaitNs = 0;
+};
+
 class Session;
 class SessionData {
 public:
@@ -204,9 +206,6 @@ public:
 	not_null<QReadWriteLock*> receivedIdsMutex() const {
 		return &_receivedIdsLock;
 	}
-	not_null<QReadWriteLock*> haveReceivedMutex() const {
-		return &_haveReceivedLock;
-	}
 	not_null<QReadWriteLock*> stateRequestMutex() const {
 		return &_stateRequestLock;
 	}
@@ -241,16 +240,26 @@ public:
 	const RequestIdsMap &wereAckedMap() const {
 		return _wereAcked;
 	}
-	QMap<mtpRequestId, SerializedMessage> &haveReceivedResponses() {
-		return _receivedResponses;
+
+	// Responses and updates are pushed by the connection thread and
+	// popped only by the main thread in Session::tryToReceive().
+	void pushReceivedResponse(
+		mtpRequestId requestId,
+		const SerializedMessage &response);
+	void pushReceivedUpdate(SerializedMessage &&update);
+	bool hasReceived() const {
+		return _receivedResponses.size() || _receivedUpdates.size();
 	}
-	const QMap<mtpRequestId, SerializedMessage> &haveReceivedResponses() const {
-		return _receivedResponses;
+	int receivedResponsesCount() const {
+		return _receivedResponses.size();
 	}
-	QList<SerializedMessage> &haveReceivedUpdates() {
-		return _receivedUpdates;
+	int receivedUpdatesCount() const {
+		return _receivedUpdates.size();
 	}
-	const QList<SerializedMessage> &haveReceivedUpdates() const {
+	base::mpsc_queue<ReceivedResponse> &receivedResponses() {
+		return _receivedResponses;
+	}
+	base::mpsc_queue<SerializedMessage> &receivedUpdates() {
 		return _receivedUpdates;
 	}
 	QMap<mtpMsgId, bool> &stateRequestMap() {
@@ -274,7 +283,10 @@ public:
 		return result * 2 + (needAck ? 1 : 0);
 	}
 
-	void clear(Instance *instance);
+	void clear();
+
+	void countLockWait(int64 nanoseconds);
+	SessionStats takeStats();
 
 private:
 	uint64 _session = 0;
@@ -296,8 +308,13 @@ private:
 	RequestIdsMap _wereAcked; // map of msg_id -> request_id, this msg_ids already were acked or do not need ack
 	QMap<mtpMsgId, bool> _stateRequest; // set of msg_id's, whose state should be requested
 
-	QMap<mtpRequestId, SerializedMessage> _receivedResponses; // map of request_id -> response that should be processed in the main thread
-	QList<SerializedMessage> _receivedUpdates; // list of updates that should be processed in the main thread
+	base::mpsc_queue<ReceivedResponse> _receivedResponses; // responses that should be processed in the main thread
+	base::mpsc_queue<SerializedMessage> _receivedUpdates; // updates that should be processed in the main thread
+
+	std::atomic<int> _responsesQueueMax = { 0 };
+	std::atomic<int> _updatesQueueMax = { 0 };
+	std::atomic<int> _lockWaits = { 0 };
+	std::atomic<int64> _lockWaitNs = { 0 };
 
 	// mutexes
 	mutable QReadWriteLock _lock;
@@ -306,11 +323,25 @@ private:
 	mutable QReadWriteLock _toResendLock;
 	mutable QReadWriteLock _receivedIdsLock;
 	mutable QReadWriteLock _wereAckedLock;
-	mutable QReadWriteLock _haveReceivedLock;
 	mutable QReadWriteLock _stateRequestLock;
 
 };
 
+// Write locker that counts the time spent waiting for a contended lock.
+class CountingWriteLocker {
+public:
+	CountingWriteLocker(
+		not_null<QReadWriteLock*> lock,
+		not_null<SessionData*> data);
+	CountingWriteLocker(const CountingWriteLocker &other) = delete;
+	CountingWriteLocker &operator=(const CountingWriteLocker &other) = delete;
+	~CountingWriteLocker();
+
+private:
+	const not_null<QReadWriteLock*> _lock;
+
+};
+
 class Session : public QObject {
 	Q_OBJECT
 
@@ -345,6 +376,9 @@ public:
 		TimeMs msCanWait = 0,
 		bool newRequest = true);
 
+	// May be called from any thread.
+	void clearCallbacksDelayed(std::vector<RPCCallbackClear> &&ids);
+
 	~Session();
 
 signals:
@@ -374,6 +408,8 @@ public slots:
 
 private:
 	void createDcData();
+	void takeReceivedResponses();
+	void logStats();
 
 	bool rpcErrorOccured(mtpRequestId requestId, const RPCFailHandlerPtr &onFail, const RPCError &err);
 
@@ -385,11 +421,15 @@ private:
 
 	SessionData data;
 
+	// Responses are processed in the order of their request ids.
+	std::map<mtpRequestId, SerializedMessage> _receivedResponses;
+
 	ShiftedDcId dcWithShift = 0;
 	std::shared_ptr<Dcenter> dc;
 
 	TimeMs msSendCall = 0;
 	TimeMs msWait = 0;
+	TimeMs msLastSent = 0;
 
 	bool _ping = false;
 
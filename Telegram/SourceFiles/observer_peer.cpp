@@ -8,27 +8,56 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "observer_peer.h"
 
 #include "base/observer.h"
+#include <rpl/event_stream.h>
+#include <chrono>
 
 namespace Notify {
 namespace {
 
-using SmallUpdatesList = QVector<PeerUpdate>;
-NeverFreedPointer<SmallUpdatesList> SmallUpdates;
-using AllUpdatesList = QMap<PeerData*, PeerUpdate>;
-NeverFreedPointer<AllUpdatesList> AllUpdates;
+constexpr auto kStatsLogTimeout = TimeMs(60000);
+constexpr auto kStatsLogLimit = 10;
+
+// Pending updates in the order they were first requested,
+// with at most one merged update for each peer.
+struct PendingUpdates {
+	std::vector<PeerUpdate> list;
+	base::flat_map<PeerData*, int> indices;
+};
+NeverFreedPointer<PendingUpdates> Pending;
+
+// Viewers of a single peer, so that updates of other peers don't
+// reach them. Entries without viewers are removed after the dispatch.
+struct PeerViewers {
+	rpl::event_stream<PeerUpdate> stream;
+	PeerUpdate::Flags flags = 0;
+	int count = 0;
+};
+using PeerViewersMap = base::flat_map<
+	PeerData*,
+	std::unique_ptr<PeerViewers>>;
+NeverFreedPointer<PeerViewersMap> Viewers;
+
+// Dispatch counters, collected only with the debug logs enabled.
+// Subscribers are told apart by the names they were registered with.
+struct HandlerStats {
+	int calls = 0;
+	int64 duration = 0; // In microseconds.
+};
+base::flat_map<const char*, HandlerStats> Stats;
+TimeMs StatsLogTime = 0;
 
 void StartCallback() {
-	SmallUpdates.createIfNull();
-	AllUpdates.createIfNull();
+	Pending.createIfNull();
+	Viewers.createIfNull();
 }
 void FinishCallback() {
-	SmallUpdates.clear();
-	AllUpdates.clear();
+	Pending.clear();
+	Viewers.clear();
 }
 
-base::Observable<PeerUpdate, PeerUpdatedHandler> PeerUpdatedObservable;
-
-} // namespace
+// std::map keeps the observables in place while new buckets are added.
+using Handlers = base::Observable<PeerUpdate, PeerUpdatedHandler>;
+std::map<PeerUpdate::Flags::Type, Handlers> HandlersByFlags;
 
 void mergePeerUpdate(PeerUpdate &mergeTo, const PeerUpdate &mergeFrom) {
 	if (!(mergeTo.flags & PeerUpdate::Flag::NameChanged)) {
@@ -39,65 +68,140 @@ void mergePeerUpdate(PeerUpdate &mergeTo, const PeerUpdate &mergeFrom) {
 	mergeTo.flags |= mergeFrom.flags;
 }
 
-void peerUpdatedDelayed(const PeerUpdate &update) {
-	SmallUpdates.createIfNull();
-	AllUpdates.createIfNull();
+template <typename Callback>
+void CountedCall(const char *name, Callback &&callback) {
+	if (!Logs::DebugEnabled()) {
+		callback();
+		return;
+	}
+	const auto start = std::chrono::steady_clock::now();
+	callback();
+	auto &stats = Stats[name];
+	++stats.calls;
+	stats.duration += std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+}
 
-	Global::RefHandleDelayedPeerUpdates().call();
+void LogStats() {
+	const auto now = getms();
+	if (!StatsLogTime) {
+		StatsLogTime = now + kStatsLogTimeout;
+		return;
+	} else if (now < StatsLogTime) {
+		return;
+	}
+	StatsLogTime = now + kStatsLogTimeout;
 
-	int existingUpdatesCount = SmallUpdates->size();
-	for (int i = 0; i < existingUpdatesCount; ++i) {
-		auto &existingUpdate = (*SmallUpdates)[i];
-		if (existingUpdate.peer == update.peer) {
-			mergePeerUpdate(existingUpdate, update);
-			return;
-		}
+	// Same names from different translation units may have
+	// different addresses, so the stats are merged by the text.
+	auto merged = base::flat_map<QString, HandlerStats>();
+	for (const auto &[name, stats] : base::take(Stats)) {
+		auto &to = merged[QString::fromLatin1(name ? name : "unnamed")];
+		to.calls += stats.calls;
+		to.duration += stats.duration;
 	}
+	auto list = std::vector<std::pair<QString, HandlerStats>>(
+		merged.begin(),
+		merged.end());
+	ranges::sort(list, [](const auto &a, const auto &b) {
+		return (a.second.duration > b.second.duration);
+	});
+	if (list.size() > kStatsLogLimit) {
+		list.resize(kStatsLogLimit);
+	}
+	for (const auto &[name, stats] : list) {
+		DEBUG_LOG(("Peer Updates: %1 called %2 times, %3 mcs."
+			).arg(name
+			).arg(stats.calls
+			).arg(stats.duration));
+	}
+}
 
-	if (AllUpdates->isEmpty()) {
-		if (existingUpdatesCount < 5) {
-			SmallUpdates->push_back(update);
+void NotifyPeerViewers(const PeerUpdate &update) {
+	if (!Viewers) {
+		return;
+	}
+	const auto i = Viewers->find(update.peer);
+	if (i == Viewers->end() || !(i->second->flags & update.flags)) {
+		return;
+	}
+	i->second->stream.fire_copy(update);
+}
+
+void RemoveUnusedPeerViewers() {
+	if (!Viewers) {
+		return;
+	}
+	for (auto i = Viewers->begin(); i != Viewers->end();) {
+		if (i->second->count > 0) {
+			++i;
 		} else {
-			AllUpdates->insert(update.peer, update);
+			i = Viewers->erase(i);
 		}
-	} else {
-		auto it = AllUpdates->find(update.peer);
-		if (it != AllUpdates->cend()) {
-			mergePeerUpdate(it.value(), update);
-			return;
+	}
+}
+
+} // namespace
+
+void PeerUpdatedHandler::operator()(const PeerUpdate &update) const {
+	CountedCall(_name, [&] { _handler(update); });
+}
+
+void peerUpdatedDelayed(const PeerUpdate &update) {
+	Pending.createIfNull();
+
+	Global::RefHandleDelayedPeerUpdates().call();
+
+	const auto i = Pending->indices.find(update.peer);
+	if (i != Pending->indices.end()) {
+		mergePeerUpdate(Pending->list[i->second], update);
+		return;
+	}
+	Pending->indices.emplace(update.peer, int(Pending->list.size()));
+	Pending->list.push_back(update);
+}
+
+void peerUpdatedNow(const PeerUpdate &update) {
+	const auto flags = update.flags.value();
+	for (auto &[subscribed, handlers] : HandlersByFlags) {
+		if (subscribed & flags) {
+			handlers.notify(update, true);
 		}
-		AllUpdates->insert(update.peer, update);
 	}
+	NotifyPeerViewers(update);
 }
 
 void peerUpdatedSendDelayed() {
-	if (!SmallUpdates || !AllUpdates || SmallUpdates->empty()) return;
+	if (!Pending || Pending->list.empty()) return;
 
-	auto smallList = base::take(*SmallUpdates);
-	auto allList = base::take(*AllUpdates);
-	for (auto &update : smallList) {
-		PeerUpdated().notify(std::move(update), true);
+	auto list = base::take(Pending->list);
+	Pending->indices.clear();
+	for (auto &update : list) {
+		peerUpdatedNow(update);
 	}
-	for (auto &update : allList) {
-		PeerUpdated().notify(std::move(update), true);
+	RemoveUnusedPeerViewers();
+	if (Logs::DebugEnabled()) {
+		LogStats();
 	}
 
-	if (SmallUpdates->isEmpty()) {
-		std::swap(smallList, *SmallUpdates);
-		SmallUpdates->resize(0);
+	if (Pending->list.empty()) {
+		list.clear();
+		std::swap(list, Pending->list);
 	}
 }
 
-base::Observable<PeerUpdate, PeerUpdatedHandler> &PeerUpdated() {
-	return PeerUpdatedObservable;
+base::Observable<PeerUpdate, PeerUpdatedHandler> &PeerUpdated(
+		PeerUpdate::Flags flags) {
+	return HandlersByFlags[flags.value()];
 }
 
 rpl::producer<PeerUpdate> PeerUpdateViewer(
-		PeerUpdate::Flags flags) {
+		PeerUpdate::Flags flags,
+		const char *name) {
 	return [=](const auto &consumer) {
 		auto lifetime = rpl::lifetime();
 		lifetime.make_state<base::Subscription>(
-			PeerUpdated().add_subscription({ flags, [=](
+			PeerUpdated(flags).add_subscription({ name, [=](
 					const PeerUpdate &update) {
 				consumer.put_next_copy(update);
 			}}));
@@ -107,22 +211,47 @@ rpl::producer<PeerUpdate> PeerUpdateViewer(
 
 rpl::producer<PeerUpdate> PeerUpdateViewer(
 		not_null<PeerData*> peer,
-		PeerUpdate::Flags flags) {
-	return PeerUpdateViewer(
-		flags
-	) | rpl::filter([=](const PeerUpdate &update) {
-		return (update.peer == peer);
-	});
+		PeerUpdate::Flags flags,
+		const char *name) {
+	return [=](const auto &consumer) {
+		Viewers.createIfNull();
+		auto &viewers = (*Viewers)[peer];
+		if (!viewers) {
+			viewers = std::make_unique<PeerViewers>();
+		}
+		++viewers->count;
+		viewers->flags |= flags;
+
+		auto lifetime = viewers->stream.events(
+		) | rpl::start_with_next([=](const PeerUpdate &update) {
+			if (update.flags & flags) {
+				CountedCall(name, [&] {
+					consumer.put_next_copy(update);
+				});
+			}
+		});
+		lifetime.add([=] {
+			if (!Viewers) {
+				return;
+			}
+			const auto i = Viewers->find(peer);
+			if (i != Viewers->end() && !--i->second->count) {
+				i->second->flags = 0;
+			}
+		});
+		return lifetime;
+	};
 }
 
 rpl::producer<PeerUpdate> PeerUpdateValue(
 		not_null<PeerData*> peer,
-		PeerUpdate::Flags flags) {
+		PeerUpdate::Flags flags,
+		const char *name) {
 	auto initial = PeerUpdate(peer);
 	initial.flags = flags;
 	return rpl::single(
 		initial
-	) | rpl::then(PeerUpdateViewer(peer, flags));
+	) | rpl::then(PeerUpdateViewer(peer, flags, name));
 }
 
 } // namespace Notify
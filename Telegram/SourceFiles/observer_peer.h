@@ -88,33 +88,42 @@ inline void peerUpdatedDelayed(PeerData *peer, PeerUpdate::Flags events) {
 }
 void peerUpdatedSendDelayed();
 
+// Notifies both global handlers and viewers of the updated peer.
+void peerUpdatedNow(const PeerUpdate &update);
+
+// The name identifies the subscriber in the dispatch statistics.
 class PeerUpdatedHandler {
 public:
 	template <typename Lambda>
-	PeerUpdatedHandler(PeerUpdate::Flags events, Lambda &&handler) : _events(events), _handler(std::move(handler)) {
-	}
-	void operator()(const PeerUpdate &update) const {
-		if (update.flags & _events) {
-			_handler(update);
-		}
+	PeerUpdatedHandler(const char *name, Lambda &&handler)
+	: _name(name)
+	, _handler(std::move(handler)) {
 	}
+	void operator()(const PeerUpdate &update) const;
 
 private:
-	PeerUpdate::Flags _events;
+	const char *_name = nullptr;
 	Fn<void(const PeerUpdate&)> _handler;
 
 };
-base::Observable<PeerUpdate, PeerUpdatedHandler> &PeerUpdated();
 
-rpl::producer<PeerUpdate> PeerUpdateViewer(
+// Global handlers are kept in buckets by the flags they are subscribed
+// to, a bucket is notified only about updates with some of its flags.
+base::Observable<PeerUpdate, PeerUpdatedHandler> &PeerUpdated(
 	PeerUpdate::Flags flags);
 
+rpl::producer<PeerUpdate> PeerUpdateViewer(
+	PeerUpdate::Flags flags,
+	const char *name);
+
 rpl::producer<PeerUpdate> PeerUpdateViewer(
 	not_null<PeerData*> peer,
-	PeerUpdate::Flags flags);
+	PeerUpdate::Flags flags,
+	const char *name);
 
 rpl::producer<PeerUpdate> PeerUpdateValue(
 	not_null<PeerData*> peer,
-	PeerUpdate::Flags flags);
+	PeerUpdate::Flags flags,
+	const char *name);
 
 } // namespace Notify
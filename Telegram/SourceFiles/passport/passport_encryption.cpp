@@ -20,6 +20,7 @@ constexpr auto kAesParamsHashSize = 64;
 constexpr auto kMinPadding = 32;
 constexpr auto kMaxPadding = 255;
 constexpr auto kAlignTo = 16;
+constexpr auto kEncryptChunkSize = 64 * 1024;
 
 } // namespace
 
@@ -327,32 +328,86 @@ EncryptedData EncryptData(bytes::const_span bytes) {
 EncryptedData EncryptData(
 		bytes::const_span bytes,
 		bytes::const_span dataSecret) {
+	return EncryptData(bytes, dataSecret, kEncryptChunkSize, nullptr);
+}
+
+EncryptedData EncryptData(
+		bytes::const_span bytes,
+		bytes::const_span dataSecret,
+		int chunkSize,
+		Fn<void(bytes::const_span chunk)> chunkReady) {
+	Expects(chunkSize > 0 && chunkSize % kAlignTo == 0);
+
 	constexpr auto kFromPadding = kMinPadding + kAlignTo - 1;
 	constexpr auto kPaddingDelta = kMaxPadding - kFromPadding;
 	const auto randomPadding = kFromPadding
 		+ (rand_value<uint32>() % kPaddingDelta);
-	const auto padding = randomPadding
-		- ((bytes.size() + randomPadding) % kAlignTo);
+	const auto padding = int(randomPadding
+		- ((bytes.size() + randomPadding) % kAlignTo));
 	Assert(padding >= kMinPadding && padding <= kMaxPadding);
 
-	auto unencrypted = bytes::vector(padding + bytes.size());
-	Assert(unencrypted.size() % kAlignTo == 0);
+	auto paddingBytes = bytes::vector(padding);
+	paddingBytes[0] = static_cast<gsl::byte>(padding);
+	memset_rand(paddingBytes.data() + 1, padding - 1);
 
-	unencrypted[0] = static_cast<gsl::byte>(padding);
-	memset_rand(unencrypted.data() + 1, padding - 1);
-	bytes::copy(
-		gsl::make_span(unencrypted).subspan(padding),
-		bytes);
-	const auto dataHash = openssl::Sha256(unencrypted);
+	// The key depends on the hash of the whole padded data, so it is
+	// hashed in a separate pass before the encryption starts.
+	const auto dataHash = openssl::Sha256(paddingBytes, bytes);
 	const auto bytesForEncryptionKey = bytes::concatenate(
 		dataSecret,
 		dataHash);
-
 	auto params = PrepareAesParams(bytesForEncryptionKey);
+	auto aesKey = AES_KEY();
+	const auto error = AES_set_encrypt_key(
+		reinterpret_cast<const uchar*>(params.key.data()),
+		params.key.size() * CHAR_BIT,
+		&aesKey);
+	if (error != 0) {
+		LOG(("App Error: Could not AES_set_encrypt_key, result %1"
+			).arg(error));
+		return {};
+	}
+
+	// Each chunk of the padded data is assembled right in the result
+	// and encrypted in place while it is still in the cache.
+	auto result = bytes::vector(padding + bytes.size());
+	const auto full = gsl::make_span(result);
+	const auto size = int(result.size());
+	for (auto offset = 0; offset < size; offset += chunkSize) {
+		const auto chunk = full.subspan(
+			offset,
+			std::min(chunkSize, size - offset));
+		const auto paddingPart = std::clamp(
+			padding - offset,
+			0,
+			int(chunk.size()));
+		if (paddingPart > 0) {
+			bytes::copy(
+				chunk,
+				gsl::make_span(paddingBytes).subspan(offset, paddingPart));
+		}
+		if (paddingPart < chunk.size()) {
+			bytes::copy(
+				chunk.subspan(paddingPart),
+				bytes.subspan(
+					offset + paddingPart - padding,
+					chunk.size() - paddingPart));
+		}
+		AES_cbc_encrypt(
+			reinterpret_cast<const uchar*>(chunk.data()),
+			reinterpret_cast<uchar*>(chunk.data()),
+			chunk.size(),
+			&aesKey,
+			reinterpret_cast<uchar*>(params.iv.data()),
+			AES_ENCRYPT);
+		if (chunkReady) {
+			chunkReady(chunk);
+		}
+	}
 	return {
 		{ dataSecret.begin(), dataSecret.end() },
 		{ dataHash.begin(), dataHash.end() },
-		Encrypt(unencrypted, std::move(params))
+		std::move(result)
 	};
 }
 
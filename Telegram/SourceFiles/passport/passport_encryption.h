@@ -44,6 +44,15 @@ EncryptedData EncryptData(
 	bytes::const_span bytes,
 	bytes::const_span dataSecret);
 
+// Encrypts the padded data chunk by chunk without a padded copy of it,
+// every encrypted chunk is passed to chunkReady as soon as it is ready.
+// The chunkSize should be a multiple of 16.
+EncryptedData EncryptData(
+	bytes::const_span bytes,
+	bytes::const_span dataSecret,
+	int chunkSize,
+	Fn<void(bytes::const_span chunk)> chunkReady);
+
 bytes::vector DecryptData(
 	bytes::const_span encrypted,
 	bytes::const_span dataHash,
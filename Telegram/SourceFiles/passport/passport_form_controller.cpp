@@ -1431,18 +1431,23 @@ void FormController::encryptFile(
 		bytes = std::move(content),
 		fileSecret = file.fields.secret
 	] {
+		auto result = UploadScanData();
+		auto md5 = HashMd5();
 		auto data = EncryptData(
 			bytes::make_span(bytes),
-			fileSecret);
-		auto result = UploadScanData();
+			fileSecret,
+			UploadPartSize,
+			[&](bytes::const_span chunk) {
+				md5.feed(chunk.data(), chunk.size());
+				result.parts.emplace_back(
+					reinterpret_cast<const char*>(chunk.data()),
+					chunk.size());
+			});
 		result.fileId = fileId;
 		result.hash = std::move(data.hash);
 		result.bytes = std::move(data.bytes);
 		result.md5checksum.resize(32);
-		hashMd5Hex(
-			result.bytes.data(),
-			result.bytes.size(),
-			result.md5checksum.data());
+		hashMd5Hex(md5.result(), result.md5checksum.data());
 		crl::on_main([=, encrypted = std::move(result)]() mutable {
 			if (weak.lock()) {
 				callback(std::move(encrypted));
@@ -1522,10 +1527,12 @@ void FormController::uploadEncryptedFile(
 		TextWithTags(),
 		std::shared_ptr<SendingAlbum>(nullptr));
 	prepared->type = SendMediaType::Secure;
-	prepared->content = QByteArray::fromRawData(
-		reinterpret_cast<char*>(file.uploadData->bytes.data()),
-		file.uploadData->bytes.size());
-	prepared->setFileData(prepared->content);
+	prepared->partssize = file.uploadData->bytes.size();
+	auto &parts = file.uploadData->parts;
+	for (auto i = 0, count = int(parts.size()); i != count; ++i) {
+		prepared->fileparts.insert(i, std::move(parts[i]));
+	}
+	parts.clear();
 	prepared->filemd5 = file.uploadData->md5checksum;
 
 	file.uploadData->fullId = FullMsgId(0, clientMsgId());
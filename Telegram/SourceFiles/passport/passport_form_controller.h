@@ -68,6 +68,7 @@ struct UploadScanData {
 	QByteArray md5checksum;
 	bytes::vector hash;
 	bytes::vector bytes;
+	std::vector<QByteArray> parts; // Encrypted bytes split for uploading.
 
 	int offset = 0;
 };
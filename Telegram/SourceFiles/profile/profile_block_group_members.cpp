@@ -40,7 +40,7 @@ GroupMembersWidget::GroupMembersWidget(
 	auto observeEvents = UpdateFlag::AdminsChanged
 		| UpdateFlag::MembersChanged
 		| UpdateFlag::UserOnlineChanged;
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(observeEvents, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(observeEvents), Notify::PeerUpdatedHandler("GroupMembersWidget::GroupMembersWidget", [this](const Notify::PeerUpdate &update) {
 		notifyPeerUpdated(update);
 	}));
 
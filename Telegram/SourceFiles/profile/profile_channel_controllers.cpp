@@ -121,14 +121,17 @@ ParticipantsBoxController::ParticipantsBoxController(
 }
 
 void ParticipantsBoxController::setupSortByOnline() {
-	_sortByOnlineTimer.setCallback([this] { sortByOnline(); });
+	_sortByOnlineTimer.setCallback([this] { sortChangedByOnline(); });
 	using UpdateFlag = Notify::PeerUpdate::Flag;
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(
-		UpdateFlag::UserOnlineChanged,
+	subscribe(Notify::PeerUpdated(
+		UpdateFlag::UserOnlineChanged
+	), Notify::PeerUpdatedHandler(
+		"ParticipantsBoxController::setupSortByOnline",
 		[this](const Notify::PeerUpdate &update) {
 			if (auto row = delegate()->peerListFindRow(
 					update.peer->id)) {
 				row->refreshStatus();
+				_onlineChangedRows.insert(row->id());
 				sortByOnlineDelayed();
 			}
 		}));
@@ -150,6 +153,11 @@ void ParticipantsBoxController::setupListChangeViewers() {
 			delegate()->peerListPartitionRows([user](const PeerListRow &row) {
 				return (row.peer() == user);
 			});
+			if (sortingByOnline()) {
+				// The row is out of the online order now, sort it later.
+				_onlineChangedRows.insert(row->id());
+				sortByOnlineDelayed();
+			}
 		} else {
 			delegate()->peerListPrependRow(createRow(user));
 			delegate()->peerListRefreshRows();
@@ -172,20 +180,47 @@ void ParticipantsBoxController::sortByOnlineDelayed() {
 	}
 }
 
+bool ParticipantsBoxController::sortingByOnline() const {
+	return (_role == Role::Profile)
+		&& _channel->isMegagroup()
+		&& (_channel->membersCount() <= Global::ChatSizeMax());
+}
+
+auto ParticipantsBoxController::sortByOnlineCompare() const
+-> Fn<bool(const PeerListRow &a, const PeerListRow &b)> {
+	// All the rows are compared with the same time, so that the rows
+	// sorted before stay sorted and only the changed ones are moved.
+	const auto now = _sortByOnlineTime;
+	return [now](const PeerListRow &a, const PeerListRow &b) {
+		return Data::SortByOnlineValue(a.peer()->asUser(), now) >
+			Data::SortByOnlineValue(b.peer()->asUser(), now);
+	};
+}
+
 void ParticipantsBoxController::sortByOnline() {
-	if (_role != Role::Profile
-		|| !_channel->isMegagroup()
-		|| _channel->membersCount() > Global::ChatSizeMax()) {
+	_onlineChangedRows.clear();
+	if (!sortingByOnline()) {
 		_onlineCount = 0;
 		return;
 	}
-	auto now = unixtime();
-	delegate()->peerListSortRows([now](
-			const PeerListRow &a,
-			const PeerListRow &b) {
-		return Data::SortByOnlineValue(a.peer()->asUser(), now) >
-			Data::SortByOnlineValue(b.peer()->asUser(), now);
-	});
+	_sortByOnlineTime = unixtime();
+	delegate()->peerListSortRows(sortByOnlineCompare());
+	refreshOnlineCount();
+}
+
+void ParticipantsBoxController::sortChangedByOnline() {
+	if (!sortingByOnline()) {
+		_onlineChangedRows.clear();
+		_onlineCount = 0;
+		return;
+	} else if (!_sortByOnlineTime) {
+		sortByOnline();
+		return;
+	} else if (_onlineChangedRows.empty()) {
+		return;
+	}
+	const auto changed = base::take(_onlineChangedRows);
+	delegate()->peerListSortChangedRows(changed, sortByOnlineCompare());
 	refreshOnlineCount();
 }
 
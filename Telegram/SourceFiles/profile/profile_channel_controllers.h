@@ -118,7 +118,11 @@ private:
 	void setupSortByOnline();
 	void setupListChangeViewers();
 	void sortByOnlineDelayed();
+	bool sortingByOnline() const;
+	auto sortByOnlineCompare() const
+		-> Fn<bool(const PeerListRow &a, const PeerListRow &b)>;
 	void sortByOnline();
+	void sortChangedByOnline();
 	void showAdmin(not_null<UserData*> user);
 	void editAdminDone(
 		not_null<UserData*> user,
@@ -155,6 +159,8 @@ private:
 	QPointer<PeerListBox> _addBox;
 
 	base::Timer _sortByOnlineTimer;
+	TimeId _sortByOnlineTime = 0;
+	base::flat_set<PeerListRowId> _onlineChangedRows;
 	rpl::variable<int> _onlineCount = 0;
 
 };
@@ -57,7 +57,7 @@ CoverWidget::CoverWidget(QWidget *parent, UserData *self)
 	_editNameInline->addClickHandler([this] { editName(); });
 
 	auto observeEvents = Notify::PeerUpdate::Flag::NameChanged | Notify::PeerUpdate::Flag::PhotoChanged;
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(observeEvents, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(observeEvents), Notify::PeerUpdatedHandler("Settings::CoverWidget::CoverWidget", [this](const Notify::PeerUpdate &update) {
 		notifyPeerUpdated(update);
 	}));
 
@@ -25,7 +25,7 @@ using UpdateFlag = Notify::PeerUpdate::Flag;
 
 InfoWidget::InfoWidget(QWidget *parent, UserData *self) : BlockWidget(parent, self, lang(lng_settings_section_info)) {
 	auto observeEvents = UpdateFlag::UsernameChanged | UpdateFlag::UserPhoneChanged | UpdateFlag::AboutChanged;
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(observeEvents, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(observeEvents), Notify::PeerUpdatedHandler("Settings::InfoWidget::InfoWidget", [this](const Notify::PeerUpdate &update) {
 		notifyPeerUpdated(update);
 	}));
 
@@ -47,7 +47,7 @@ private:
 
 void BlockUserBoxController::prepareViewHook() {
 	delegate()->peerListSetTitle(langFactory(lng_blocked_list_add_title));
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(Notify::PeerUpdate::Flag::UserIsBlocked, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(Notify::PeerUpdate::Flag::UserIsBlocked), Notify::PeerUpdatedHandler("BlockUserBoxController::prepareViewHook", [this](const Notify::PeerUpdate &update) {
 		if (auto user = update.peer->asUser()) {
 			if (auto row = delegate()->peerListFindRow(user->id)) {
 				updateIsBlocked(row, user);
@@ -90,7 +90,7 @@ void BlockedBoxController::prepare() {
 	setDescriptionText(lang(lng_contacts_loading));
 	delegate()->peerListRefreshRows();
 
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(Notify::PeerUpdate::Flag::UserIsBlocked, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(Notify::PeerUpdate::Flag::UserIsBlocked), Notify::PeerUpdatedHandler("BlockedBoxController::prepare", [this](const Notify::PeerUpdate &update) {
 		if (auto user = update.peer->asUser()) {
 			handleBlockedEvent(user);
 		}
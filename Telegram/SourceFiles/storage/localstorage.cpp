@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "storage/serialize_document.h"
 #include "storage/serialize_common.h"
+#include "storage/storage_passcode_key.h"
 #include "chat_helpers/stickers.h"
 #include "data/data_drafts.h"
 #include "boxes/send_files_box.h"
@@ -30,6 +31,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/flags.h"
 #include "data/data_session.h"
 #include "history/history.h"
+#include "history/history_item.h"
+#include "dialogs/dialogs_indexed_list.h"
 
 #ifndef BETTERGRAM_UPDATES
 #define BETTERGRAM_UPDATES (1)
@@ -53,6 +56,11 @@ constexpr auto kSinglePeerTypeChannel = qint32(3);
 constexpr auto kSinglePeerTypeSelf = qint32(4);
 constexpr auto kSinglePeerTypeEmpty = qint32(0);
 
+constexpr auto kDialogsSnapshotLimit = 3000;
+constexpr auto kSharedMediaPeersLimit = 64;
+constexpr auto kSharedMediaIdsLimit = 1000;
+constexpr auto kSearchIndexLimit = 20000;
+
 using FileKey = quint64;
 
 constexpr char tdfMagic[] = { 'T', 'D', 'F', '$' };
@@ -154,6 +162,9 @@ auto SettingsKey = MTP::AuthKeyPtr();
 auto PassKey = MTP::AuthKeyPtr();
 auto LocalKey = MTP::AuthKeyPtr();
 
+// Newer passcode changes win over the ones still being derived.
+auto PasscodeGeneration = 0;
+
 void createLocalKey(const QByteArray &pass, QByteArray *salt, MTP::AuthKeyPtr *result) {
 	auto key = MTP::AuthKey::Data { { gsl::byte{} } };
 	auto iterCount = pass.size() ? LocalEncryptIterCount : LocalEncryptNoPwdIterCount; // dont slow down for no password
@@ -514,6 +525,9 @@ enum { // Local Storage Keys
 	lskFavedStickers = 0x12, // no data
 	lskExportSettings = 0x13, // no data
 	lskBackground = 0x14, // no data
+	lskDialogsSnapshot = 0x15, // no data
+	lskSharedMedia = 0x16, // data: PeerId peer
+	lskSearchIndex = 0x17, // no data
 };
 
 enum {
@@ -615,6 +629,11 @@ DraftsMap _draftsMap, _draftCursorsMap;
 typedef QMap<PeerId, bool> DraftsNotReadMap;
 DraftsNotReadMap _draftsNotReadMap;
 
+// Peers are kept from the least to the most recently written.
+typedef QMap<PeerId, FileKey> SharedMediaMap;
+SharedMediaMap _sharedMediaMap;
+QList<PeerId> _sharedMediaOrder;
+
 typedef QPair<FileKey, qint32> FileDesc; // file, size
 
 typedef QMultiMap<MediaKey, FileLocation> FileLocations;
@@ -657,6 +676,8 @@ bool _recentHashtagsAndBotsWereRead = false;
 FileKey _exportSettingsKey = 0;
 
 FileKey _savedPeersKey = 0;
+FileKey _dialogsSnapshotKey = 0;
+FileKey _searchIndexKey = 0;
 FileKey _langPackKey = 0;
 
 typedef QMap<StorageKey, FileDesc> StorageMap;
@@ -2068,7 +2089,19 @@ void _readMtpData() {
 	applyReadContext(std::move(context));
 }
 
-ReadMapState _readMap(const QByteArray &pass) {
+bool _readMapSalt(QByteArray &salt) {
+	FileReadDescriptor mapData;
+	if (!readFile(mapData, qsl("map"))) {
+		return false;
+	}
+	mapData.stream >> salt;
+	return _checkStreamStatus(mapData.stream)
+		&& Storage::IsGoodPasscodeSalt(salt);
+}
+
+ReadMapState _readMap(
+		const QByteArray &pass,
+		MTP::AuthKeyPtr passKey = nullptr) {
 	auto ms = getms();
 	QByteArray dataNameUtf8 = (cDataFile() + (cTestMode() ? qsl(":/test/") : QString())).toUtf8();
 	FileKey dataNameHash[2];
@@ -2088,11 +2121,16 @@ ReadMapState _readMap(const QByteArray &pass) {
 		return ReadMapFailed;
 	}
 
-	if (salt.size() != LocalEncryptSaltSize) {
+	if (!Storage::IsGoodPasscodeSalt(salt)) {
 		LOG(("App Error: bad salt in map file, size: %1").arg(salt.size()));
 		return ReadMapFailed;
+	} else if (!passKey
+		&& pass.isEmpty()
+		&& !Storage::IsLegacyPasscodeSalt(salt)) {
+		// Such salts are generated only for non-empty passcodes.
+		return ReadMapPassNeeded;
 	}
-	createLocalKey(pass, &salt, &PassKey);
+	PassKey = passKey ? passKey : Storage::CreatePasscodeKey(pass, salt);
 
 	EncryptedDescriptor keyData, map;
 	if (!decryptLocal(keyData, keyEncrypted, PassKey)) {
@@ -2117,6 +2155,8 @@ ReadMapState _readMap(const QByteArray &pass) {
 
 	DraftsMap draftsMap, draftCursorsMap;
 	DraftsNotReadMap draftsNotReadMap;
+	SharedMediaMap sharedMediaMap;
+	QList<PeerId> sharedMediaOrder;
 	StorageMap imagesMap, stickerImagesMap, audiosMap;
 	qint64 storageImagesSize = 0, storageStickersSize = 0, storageAudiosSize = 0;
 	quint64 locationsKey = 0, reportSpamStatusesKey = 0, trustedBotsKey = 0;
@@ -2125,6 +2165,8 @@ ReadMapState _readMap(const QByteArray &pass) {
 	quint64 savedGifsKey = 0;
 	quint64 backgroundKeyDay = 0, backgroundKeyNight = 0;
 	quint64 userSettingsKey = 0, recentHashtagsAndBotsKey = 0, savedPeersKey = 0, exportSettingsKey = 0;
+	quint64 dialogsSnapshotKey = 0;
+	quint64 searchIndexKey = 0;
 	while (!map.stream.atEnd()) {
 		quint32 keyType;
 		map.stream >> keyType;
@@ -2231,6 +2273,23 @@ ReadMapState _readMap(const QByteArray &pass) {
 		case lskSavedPeers: {
 			map.stream >> savedPeersKey;
 		} break;
+		case lskDialogsSnapshot: {
+			map.stream >> dialogsSnapshotKey;
+		} break;
+		case lskSearchIndex: {
+			map.stream >> searchIndexKey;
+		} break;
+		case lskSharedMedia: {
+			quint32 count = 0;
+			map.stream >> count;
+			for (quint32 i = 0; i < count; ++i) {
+				FileKey key;
+				quint64 p;
+				map.stream >> key >> p;
+				sharedMediaMap.insert(p, key);
+				sharedMediaOrder.push_back(p);
+			}
+		} break;
 		case lskExportSettings: {
 			map.stream >> exportSettingsKey;
 		} break;
@@ -2246,6 +2305,8 @@ ReadMapState _readMap(const QByteArray &pass) {
 	_draftsMap = draftsMap;
 	_draftCursorsMap = draftCursorsMap;
 	_draftsNotReadMap = draftsNotReadMap;
+	_sharedMediaMap = sharedMediaMap;
+	_sharedMediaOrder = sharedMediaOrder;
 
 	_imagesMap = imagesMap;
 	_storageImagesSize = storageImagesSize;
@@ -2265,6 +2326,8 @@ ReadMapState _readMap(const QByteArray &pass) {
 	_archivedStickersKey = archivedStickersKey;
 	_savedGifsKey = savedGifsKey;
 	_savedPeersKey = savedPeersKey;
+	_dialogsSnapshotKey = dialogsSnapshotKey;
+	_searchIndexKey = searchIndexKey;
 	_backgroundKeyDay = backgroundKeyDay;
 	_backgroundKeyNight = backgroundKeyNight;
 	_userSettingsKey = userSettingsKey;
@@ -2318,9 +2381,8 @@ void _writeMap(WriteMapWhen when) {
 		memset_rand(salt.data(), salt.size());
 		createLocalKey(pass, &salt, &LocalKey);
 
-		_passKeySalt.resize(LocalEncryptSaltSize);
-		memset_rand(_passKeySalt.data(), _passKeySalt.size());
-		createLocalKey(QByteArray(), &_passKeySalt, &PassKey);
+		_passKeySalt = Storage::GeneratePasscodeSalt(false);
+		PassKey = Storage::CreatePasscodeKey(QByteArray(), _passKeySalt);
 
 		EncryptedDescriptor passKeyData(kLocalKeySize);
 		LocalKey->write(passKeyData.stream);
@@ -2345,6 +2407,9 @@ void _writeMap(WriteMapWhen when) {
 	if (_favedStickersKey) mapSize += sizeof(quint32) + sizeof(quint64);
 	if (_savedGifsKey) mapSize += sizeof(quint32) + sizeof(quint64);
 	if (_savedPeersKey) mapSize += sizeof(quint32) + sizeof(quint64);
+	if (_dialogsSnapshotKey) mapSize += sizeof(quint32) + sizeof(quint64);
+	if (_searchIndexKey) mapSize += sizeof(quint32) + sizeof(quint64);
+	if (!_sharedMediaMap.isEmpty()) mapSize += sizeof(quint32) * 2 + _sharedMediaMap.size() * sizeof(quint64) * 2;
 	if (_backgroundKeyDay || _backgroundKeyNight) mapSize += sizeof(quint32) + sizeof(quint64) + sizeof(quint64);
 	if (_userSettingsKey) mapSize += sizeof(quint32) + sizeof(quint64);
 	if (_recentHashtagsAndBotsKey) mapSize += sizeof(quint32) + sizeof(quint64);
@@ -2417,6 +2482,18 @@ void _writeMap(WriteMapWhen when) {
 	if (_savedPeersKey) {
 		mapData.stream << quint32(lskSavedPeers) << quint64(_savedPeersKey);
 	}
+	if (_dialogsSnapshotKey) {
+		mapData.stream << quint32(lskDialogsSnapshot) << quint64(_dialogsSnapshotKey);
+	}
+	if (_searchIndexKey) {
+		mapData.stream << quint32(lskSearchIndex) << quint64(_searchIndexKey);
+	}
+	if (!_sharedMediaMap.isEmpty()) {
+		mapData.stream << quint32(lskSharedMedia) << quint32(_sharedMediaMap.size());
+		for (const auto peer : _sharedMediaOrder) {
+			mapData.stream << quint64(_sharedMediaMap.value(peer)) << quint64(peer);
+		}
+	}
 	if (_backgroundKeyDay || _backgroundKeyNight) {
 		mapData.stream
 			<< quint32(lskBackground)
@@ -2441,6 +2518,17 @@ void _writeMap(WriteMapWhen when) {
 	}
 }
 
+ReadMapState _readMapOrRewrite(
+		const QByteArray &pass,
+		MTP::AuthKeyPtr passKey = nullptr) {
+	const auto result = _readMap(pass, passKey);
+	if (result == ReadMapFailed) {
+		_mapChanged = true;
+		_writeMap(WriteMapWhen::Now);
+	}
+	return result;
+}
+
 } // namespace
 
 void finish() {
@@ -2687,8 +2775,11 @@ void reset() {
 	}
 
 	_passKeySalt.clear(); // reset passcode, local key
+	++PasscodeGeneration;
 	_draftsMap.clear();
 	_draftCursorsMap.clear();
+	_sharedMediaMap.clear();
+	_sharedMediaOrder.clear();
 	_fileLocations.clear();
 	_fileLocationPairs.clear();
 	_fileLocationAliases.clear();
@@ -2706,6 +2797,8 @@ void reset() {
 	_backgroundKeyDay = _backgroundKeyNight = 0;
 	Window::Theme::Background()->reset();
 	_userSettingsKey = _recentHashtagsAndBotsKey = _savedPeersKey = _exportSettingsKey = 0;
+	_dialogsSnapshotKey = 0;
+	_searchIndexKey = 0;
 	_oldMapVersion = _oldSettingsVersion = 0;
 	StoredAuthSessionCache.reset();
 	_mapChanged = true;
@@ -2714,33 +2807,76 @@ void reset() {
 	_writeMtpData();
 }
 
-bool checkPasscode(const QByteArray &passcode) {
-	auto checkKey = MTP::AuthKeyPtr();
-	createLocalKey(passcode, &_passKeySalt, &checkKey);
-	return checkKey->equals(PassKey);
-}
+void checkPasscodeAsync(
+		const QByteArray &passcode,
+		Fn<void(bool)> done) {
+	const auto salt = _passKeySalt;
+	const auto passKey = PassKey;
+	const auto started = getms(true);
+	Storage::CreatePasscodeKeyAsync(passcode, salt, [=](
+			MTP::AuthKeyPtr checkKey) {
+		DEBUG_LOG(("Local Info: passcode key checked in %1ms."
+			).arg(getms(true) - started));
+		const auto correct = passKey && checkKey->equals(passKey);
+		if (correct
+			&& !passcode.isEmpty()
+			&& Storage::IsLegacyPasscodeSalt(salt)
+			&& salt == _passKeySalt) {
+			setPasscodeAsync(passcode);
+		}
+		done(correct);
+	});
+}
+
+void setPasscodeAsync(const QByteArray &passcode, Fn<void()> done) {
+	const auto salt = Storage::GeneratePasscodeSalt(!passcode.isEmpty());
+	const auto generation = ++PasscodeGeneration;
+	Storage::CreatePasscodeKeyAsync(passcode, salt, [=](
+			MTP::AuthKeyPtr passKey) {
+		if (generation != PasscodeGeneration || !LocalKey) {
+			return;
+		}
+		PassKey = passKey;
+		_passKeySalt = salt;
 
-void setPasscode(const QByteArray &passcode) {
-	createLocalKey(passcode, &_passKeySalt, &PassKey);
+		EncryptedDescriptor passKeyData(kLocalKeySize);
+		LocalKey->write(passKeyData.stream);
+		_passKeyEncrypted = FileWriteDescriptor::prepareEncrypted(passKeyData, PassKey);
 
-	EncryptedDescriptor passKeyData(kLocalKeySize);
-	LocalKey->write(passKeyData.stream);
-	_passKeyEncrypted = FileWriteDescriptor::prepareEncrypted(passKeyData, PassKey);
+		_mapChanged = true;
+		_writeMap(WriteMapWhen::Now);
 
-	_mapChanged = true;
-	_writeMap(WriteMapWhen::Now);
+		Global::SetLocalPasscode(!passcode.isEmpty());
+		Global::RefLocalPasscodeChanged().notify();
 
-	Global::SetLocalPasscode(!passcode.isEmpty());
-	Global::RefLocalPasscodeChanged().notify();
+		if (done) {
+			done();
+		}
+	});
 }
 
 ReadMapState readMap(const QByteArray &pass) {
-	ReadMapState result = _readMap(pass);
-	if (result == ReadMapFailed) {
-		_mapChanged = true;
-		_writeMap(WriteMapWhen::Now);
+	return _readMapOrRewrite(pass);
+}
+
+void readMapAsync(const QByteArray &pass, Fn<void(ReadMapState)> done) {
+	auto salt = QByteArray();
+	if (!_readMapSalt(salt)) {
+		done(readMap(pass));
+		return;
 	}
-	return result;
+	const auto started = getms(true);
+	Storage::CreatePasscodeKeyAsync(pass, salt, [=](MTP::AuthKeyPtr passKey) {
+		DEBUG_LOG(("Local Info: passcode key derived in %1ms."
+			).arg(getms(true) - started));
+		const auto result = _readMapOrRewrite(pass, passKey);
+		if (result == ReadMapDone
+			&& !pass.isEmpty()
+			&& Storage::IsLegacyPasscodeSalt(salt)) {
+			setPasscodeAsync(pass);
+		}
+		done(result);
+	});
 }
 
 int32 oldMapVersion() {
@@ -5036,6 +5172,368 @@ void readSavedPeers() {
 	Auth().api().requestPeers(peers);
 }
 
+void writeDialogsSnapshot() {
+	if (!_working() || !AuthSession::Exists() || !App::main()) return;
+
+	auto histories = std::vector<not_null<History*>>();
+	for (const auto row : App::main()->dialogsList()->unfilteredAll()) {
+		if (int(histories.size()) >= kDialogsSnapshotLimit) {
+			break;
+		} else if (const auto history = row->history()) {
+			if (!history->useProxyPromotion()
+				&& history->chatsListTimeId() != 0) {
+				histories.push_back(history);
+			}
+		}
+	}
+	auto pinned = std::vector<not_null<History*>>();
+	for (const auto &key : Auth().data().pinnedDialogsOrder()) {
+		if (const auto history = key.history()) {
+			pinned.push_back(history);
+		}
+	}
+	if (histories.empty()) {
+		// Keep the previous snapshot until the dialogs are loaded.
+		return;
+	}
+	if (!_dialogsSnapshotKey) {
+		_dialogsSnapshotKey = genKey();
+		_mapChanged = true;
+		_writeMap(WriteMapWhen::Fast);
+	}
+
+	const auto preview = [](not_null<History*> history) {
+		if (const auto item = history->lastMessage()) {
+			return item->inDialogsText(HistoryItem::DrawInDialog::Normal);
+		}
+		return history->snapshotPreview();
+	};
+
+	// pinned count + pinned ids + count
+	auto size = sizeof(quint32)
+		+ pinned.size() * sizeof(quint64)
+		+ sizeof(quint32);
+	for (const auto history : histories) {
+		// peer + date + unread count + unread mark + unread mentions + text
+		size += _peerSize(history->peer)
+			+ sizeof(qint32) * 4
+			+ Serialize::stringSize(preview(history));
+	}
+
+	EncryptedDescriptor data(size);
+	data.stream << quint32(pinned.size());
+	for (const auto history : pinned) {
+		data.stream << quint64(history->peer->id);
+	}
+	data.stream << quint32(histories.size());
+	for (const auto history : histories) {
+		_writePeer(data.stream, history->peer);
+		data.stream
+			<< qint32(history->chatsListTimeId())
+			<< qint32(history->unreadCountKnown()
+				? history->unreadCount()
+				: -1)
+			<< qint32(history->unreadMark() ? 1 : 0)
+			<< qint32(history->getUnreadMentionsCount())
+			<< preview(history);
+	}
+
+	FileWriteDescriptor file(_dialogsSnapshotKey);
+	file.writeEncrypted(data);
+}
+
+std::vector<not_null<History*>> readDialogsSnapshot() {
+	auto result = std::vector<not_null<History*>>();
+	if (!_dialogsSnapshotKey) return result;
+
+	FileReadDescriptor snapshot;
+	if (!readEncryptedFile(snapshot, _dialogsSnapshotKey)) {
+		clearKey(_dialogsSnapshotKey);
+		_dialogsSnapshotKey = 0;
+		_writeMap();
+		return result;
+	}
+
+	quint32 pinnedCount = 0;
+	snapshot.stream >> pinnedCount;
+	auto pinned = std::vector<PeerId>();
+	pinned.reserve(std::min(pinnedCount, quint32(kDialogsSnapshotLimit)));
+	for (auto i = quint32(0); i != pinnedCount; ++i) {
+		quint64 peerId = 0;
+		snapshot.stream >> peerId;
+		if (!_checkStreamStatus(snapshot.stream)) {
+			return result;
+		}
+		pinned.push_back(PeerId(peerId));
+	}
+
+	quint32 count = 0;
+	snapshot.stream >> count;
+	result.reserve(std::min(count, quint32(kDialogsSnapshotLimit)));
+	for (auto i = quint32(0); i != count; ++i) {
+		const auto peer = _readPeer(snapshot.version, snapshot.stream);
+		if (!peer) break;
+
+		qint32 date = 0, unreadCount = 0, unreadMark = 0, mentions = 0;
+		QString preview;
+		snapshot.stream
+			>> date
+			>> unreadCount
+			>> unreadMark
+			>> mentions
+			>> preview;
+		if (!_checkStreamStatus(snapshot.stream)) {
+			break;
+		}
+
+		// Everything received from the server already is more recent.
+		const auto history = App::history(peer->id);
+		if (history->lastMessageKnown() || !date) {
+			continue;
+		}
+		if (unreadCount >= 0 && !history->unreadCountKnown()) {
+			history->setUnreadCount(unreadCount);
+			history->setUnreadMark(unreadMark != 0);
+		}
+		if (mentions >= 0 && history->getUnreadMentionsCount() < 0) {
+			history->setUnreadMentionsCount(mentions);
+		}
+		history->setSnapshotPreview(preview);
+		history->setChatsListTimeId(date);
+		result.push_back(history);
+	}
+
+	if (!Auth().data().pinnedDialogsCount()) {
+		for (auto i = pinned.size(); i != 0;) {
+			if (const auto peer = App::peerLoaded(pinned[--i])) {
+				Auth().data().setPinnedDialog(App::history(peer), true);
+			}
+		}
+	}
+	return result;
+}
+
+void writeSharedMedia(
+		const PeerId &peer,
+		const std::vector<SharedMediaSlice> &slices) {
+	if (!_working()) return;
+
+	if (slices.empty()) {
+		const auto i = _sharedMediaMap.find(peer);
+		if (i != _sharedMediaMap.end()) {
+			clearKey(i.value());
+			_sharedMediaMap.erase(i);
+			_sharedMediaOrder.removeOne(peer);
+			_mapChanged = true;
+			_writeMap();
+		}
+		return;
+	}
+
+	auto key = _sharedMediaMap.value(peer);
+	if (key) {
+		_sharedMediaOrder.removeOne(peer);
+	} else {
+		key = genKey();
+		_sharedMediaMap.insert(peer, key);
+		while (_sharedMediaMap.size() > kSharedMediaPeersLimit) {
+			clearKey(_sharedMediaMap.take(_sharedMediaOrder.takeFirst()));
+		}
+	}
+	_sharedMediaOrder.push_back(peer);
+	_mapChanged = true;
+	_writeMap();
+
+	// count + (type + message id + direction + range + full count
+	// + ids count + ids) for each slice
+	auto size = sizeof(quint32);
+	for (const auto &slice : slices) {
+		size += sizeof(qint32) * 6
+			+ sizeof(quint32)
+			+ sizeof(qint32) * slice.messageIds.size();
+	}
+
+	EncryptedDescriptor data(size);
+	data.stream << quint32(slices.size());
+	for (const auto &slice : slices) {
+		data.stream
+			<< qint32(slice.type)
+			<< qint32(slice.messageId)
+			<< qint32(slice.direction)
+			<< qint32(slice.noSkipRange.from)
+			<< qint32(slice.noSkipRange.till)
+			<< qint32(slice.fullCount)
+			<< quint32(slice.messageIds.size());
+		for (const auto messageId : slice.messageIds) {
+			data.stream << qint32(messageId);
+		}
+	}
+
+	FileWriteDescriptor file(key);
+	file.writeEncrypted(data);
+}
+
+std::vector<SharedMediaSlice> readSharedMedia(const PeerId &peer) {
+	auto result = std::vector<SharedMediaSlice>();
+	const auto key = _sharedMediaMap.value(peer);
+	if (!key) return result;
+
+	FileReadDescriptor media;
+	if (!readEncryptedFile(media, key)) {
+		clearKey(key);
+		_sharedMediaMap.remove(peer);
+		_sharedMediaOrder.removeOne(peer);
+		_mapChanged = true;
+		_writeMap();
+		return result;
+	}
+
+	quint32 count = 0;
+	media.stream >> count;
+	for (auto i = quint32(0); i != count; ++i) {
+		qint32 type = 0, messageId = 0, direction = 0;
+		qint32 from = 0, till = 0, fullCount = 0;
+		quint32 idsCount = 0;
+		media.stream
+			>> type
+			>> messageId
+			>> direction
+			>> from
+			>> till
+			>> fullCount
+			>> idsCount;
+		auto messageIds = std::vector<MsgId>();
+		messageIds.reserve(std::min(idsCount, quint32(kSharedMediaIdsLimit)));
+		for (auto j = quint32(0); j != idsCount; ++j) {
+			qint32 id = 0;
+			media.stream >> id;
+			if (media.stream.status() != QDataStream::Ok) {
+				break;
+			}
+			messageIds.push_back(MsgId(id));
+		}
+		if (!_checkStreamStatus(media.stream)) {
+			return std::vector<SharedMediaSlice>();
+		}
+		result.push_back({
+			Storage::SharedMediaType(type),
+			MsgId(messageId),
+			Data::LoadDirection(direction),
+			std::move(messageIds),
+			MsgRange(from, till),
+			fullCount });
+	}
+	return result;
+}
+
+Fn<QByteArray()> prepareSearchIndex(
+		std::vector<SearchIndexEntry> &&entries) {
+	return [entries = std::move(entries), key = LocalKey] {
+		if (entries.empty()) {
+			return QByteArray();
+		}
+
+		// count + (peer + id + date + from + hash + words count + words) for each
+		auto size = sizeof(quint32);
+		for (const auto &entry : entries) {
+			size += sizeof(quint64) * 2
+				+ sizeof(qint32) * 2
+				+ sizeof(quint32) * 2;
+			for (const auto &word : entry.words) {
+				size += Serialize::stringSize(word);
+			}
+		}
+
+		EncryptedDescriptor data(size);
+		data.stream << quint32(entries.size());
+		for (const auto &entry : entries) {
+			data.stream
+				<< quint64(entry.peer)
+				<< qint32(entry.msgId)
+				<< qint32(entry.date)
+				<< quint64(entry.from)
+				<< quint32(entry.textHash)
+				<< quint32(entry.words.size());
+			for (const auto &word : entry.words) {
+				data.stream << word;
+			}
+		}
+		return FileWriteDescriptor::prepareEncrypted(data, key);
+	};
+}
+
+void writeSearchIndex(const QByteArray &prepared) {
+	if (!_working()) return;
+
+	if (prepared.isEmpty()) {
+		if (_searchIndexKey) {
+			clearKey(_searchIndexKey);
+			_searchIndexKey = 0;
+			_mapChanged = true;
+			_writeMap();
+		}
+		return;
+	}
+	if (!_searchIndexKey) {
+		_searchIndexKey = genKey();
+		_mapChanged = true;
+		_writeMap(WriteMapWhen::Fast);
+	}
+
+	FileWriteDescriptor file(_searchIndexKey);
+	file.writeData(prepared);
+}
+
+std::vector<SearchIndexEntry> readSearchIndex() {
+	auto result = std::vector<SearchIndexEntry>();
+	if (!_searchIndexKey) return result;
+
+	FileReadDescriptor index;
+	if (!readEncryptedFile(index, _searchIndexKey)) {
+		clearKey(_searchIndexKey);
+		_searchIndexKey = 0;
+		_mapChanged = true;
+		_writeMap();
+		return result;
+	}
+
+	quint32 count = 0;
+	index.stream >> count;
+	result.reserve(std::min(count, quint32(kSearchIndexLimit)));
+	for (auto i = quint32(0); i != count; ++i) {
+		quint64 peer = 0, from = 0;
+		qint32 msgId = 0, date = 0;
+		quint32 textHash = 0, wordsCount = 0;
+		index.stream
+			>> peer
+			>> msgId
+			>> date
+			>> from
+			>> textHash
+			>> wordsCount;
+		auto entry = SearchIndexEntry();
+		entry.peer = PeerId(peer);
+		entry.msgId = MsgId(msgId);
+		entry.date = TimeId(date);
+		entry.from = PeerId(from);
+		entry.textHash = uint(textHash);
+		entry.words.reserve(std::min(wordsCount, quint32(kSearchIndexLimit)));
+		for (auto j = quint32(0); j != wordsCount; ++j) {
+			QString word;
+			index.stream >> word;
+			entry.words.push_back(word);
+			if (index.stream.status() != QDataStream::Ok) {
+				break;
+			}
+		}
+		if (!_checkStreamStatus(index.stream)) {
+			return std::vector<SearchIndexEntry>();
+		}
+		result.push_back(std::move(entry));
+	}
+	return result;
+}
+
 void addSavedPeer(PeerData *peer, const QDateTime &position) {
 	auto &savedPeers = cRefSavedPeers();
 	auto i = savedPeers.find(peer);
@@ -5217,6 +5715,19 @@ bool ClearManager::addTask(int task) {
 			_savedPeersKey = 0;
 			_mapChanged = true;
 		}
+		if (_dialogsSnapshotKey) {
+			_dialogsSnapshotKey = 0;
+			_mapChanged = true;
+		}
+		if (_searchIndexKey) {
+			_searchIndexKey = 0;
+			_mapChanged = true;
+		}
+		if (!_sharedMediaMap.isEmpty()) {
+			_sharedMediaMap.clear();
+			_sharedMediaOrder.clear();
+			_mapChanged = true;
+		}
 		_writeMap();
 	} else {
 		if (task & ClearManagerStorage) {
@@ -21,6 +21,14 @@ namespace Export {
 struct Settings;
 } // namespace Export
 
+namespace Storage {
+enum class SharedMediaType : signed char;
+} // namespace Storage
+
+namespace Data {
+enum class LoadDirection : char;
+} // namespace Data
+
 namespace Local {
 
 void start();
@@ -36,8 +44,10 @@ QString readAutoupdatePrefix();
 
 void reset();
 
-bool checkPasscode(const QByteArray &passcode);
-void setPasscode(const QByteArray &passcode);
+// Passcode keys are derived on background threads, callbacks are invoked
+// on the main thread. Legacy keys are upgraded after a successful check.
+void checkPasscodeAsync(const QByteArray &passcode, Fn<void(bool)> done);
+void setPasscodeAsync(const QByteArray &passcode, Fn<void()> done = nullptr);
 
 enum ClearManagerTask {
 	ClearManagerAll = 0xFFFF,
@@ -76,6 +86,7 @@ enum ReadMapState {
 	ReadMapPassNeeded = 2,
 };
 ReadMapState readMap(const QByteArray &pass);
+void readMapAsync(const QByteArray &pass, Fn<void(ReadMapState)> done);
 int32 oldMapVersion();
 
 int32 oldSettingsVersion();
@@ -171,6 +182,40 @@ void addSavedPeer(PeerData *peer, const QDateTime &position);
 void removeSavedPeer(PeerData *peer);
 void readSavedPeers();
 
+// Cached chats list shown at startup until the dialogs are received.
+void writeDialogsSnapshot();
+std::vector<not_null<History*>> readDialogsSnapshot();
+
+struct SharedMediaSlice {
+	Storage::SharedMediaType type;
+	MsgId messageId = 0;
+	Data::LoadDirection direction;
+	std::vector<MsgId> messageIds;
+	MsgRange noSkipRange;
+	int fullCount = 0;
+};
+void writeSharedMedia(
+	const PeerId &peer,
+	const std::vector<SharedMediaSlice> &slices);
+std::vector<SharedMediaSlice> readSharedMedia(const PeerId &peer);
+
+// Words of the messages known to the local search index.
+struct SearchIndexEntry {
+	PeerId peer = 0;
+	MsgId msgId = 0;
+	TimeId date = 0;
+	PeerId from = 0;
+	uint textHash = 0;
+	QStringList words;
+};
+
+// The returned job serializes and encrypts the entries, it is safe to run
+// it on any thread. The result is passed to writeSearchIndex() on the main
+// thread, an empty result clears the saved index.
+Fn<QByteArray()> prepareSearchIndex(std::vector<SearchIndexEntry> &&entries);
+void writeSearchIndex(const QByteArray &prepared);
+std::vector<SearchIndexEntry> readSearchIndex();
+
 void writeReportSpamStatuses();
 
 void makeBotTrusted(UserData *bot);
@@ -0,0 +1,282 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "storage/storage_passcode_key.h"
+
+#include "base/openssl_help.h"
+
+#include <atomic>
+
+namespace Storage {
+namespace {
+
+// 16 MB of memory per lane, four lanes derived in parallel.
+constexpr auto kScryptLogN = 14;
+constexpr auto kScryptR = 8;
+constexpr auto kScryptP = 4;
+
+constexpr auto kScryptMagic = "SCR1";
+constexpr auto kScryptMagicSize = 4;
+constexpr auto kScryptHeaderSize = 8;
+constexpr auto kKeySize = MTP::AuthKey::kSize;
+
+struct ScryptParams {
+	int logN = 0;
+	int r = 0;
+	int p = 0;
+};
+
+bool ParseScryptSalt(const QByteArray &salt, ScryptParams &params) {
+	if (salt.size() != kScryptHeaderSize + LocalEncryptSaltSize
+		|| memcmp(salt.constData(), kScryptMagic, kScryptMagicSize) != 0) {
+		return false;
+	}
+	const auto data = reinterpret_cast<const uchar*>(salt.constData());
+	params.logN = data[kScryptMagicSize];
+	params.r = data[kScryptMagicSize + 1];
+	params.p = data[kScryptMagicSize + 2];
+	return (params.logN >= 10 && params.logN <= 20)
+		&& (params.r >= 1 && params.r <= 32)
+		&& (params.p >= 1 && params.p <= 16);
+}
+
+inline uint32 Rotate(uint32 value, int bits) {
+	return (value << bits) | (value >> (32 - bits));
+}
+
+void Salsa208(uint32 *block) {
+	uint32 x[16];
+	std::copy(block, block + 16, x);
+	for (auto i = 0; i != 8; i += 2) {
+		x[4] ^= Rotate(x[0] + x[12], 7);
+		x[8] ^= Rotate(x[4] + x[0], 9);
+		x[12] ^= Rotate(x[8] + x[4], 13);
+		x[0] ^= Rotate(x[12] + x[8], 18);
+		x[9] ^= Rotate(x[5] + x[1], 7);
+		x[13] ^= Rotate(x[9] + x[5], 9);
+		x[1] ^= Rotate(x[13] + x[9], 13);
+		x[5] ^= Rotate(x[1] + x[13], 18);
+		x[14] ^= Rotate(x[10] + x[6], 7);
+		x[2] ^= Rotate(x[14] + x[10], 9);
+		x[6] ^= Rotate(x[2] + x[14], 13);
+		x[10] ^= Rotate(x[6] + x[2], 18);
+		x[3] ^= Rotate(x[15] + x[11], 7);
+		x[7] ^= Rotate(x[3] + x[15], 9);
+		x[11] ^= Rotate(x[7] + x[3], 13);
+		x[15] ^= Rotate(x[11] + x[7], 18);
+
+		x[1] ^= Rotate(x[0] + x[3], 7);
+		x[2] ^= Rotate(x[1] + x[0], 9);
+		x[3] ^= Rotate(x[2] + x[1], 13);
+		x[0] ^= Rotate(x[3] + x[2], 18);
+		x[6] ^= Rotate(x[5] + x[4], 7);
+		x[7] ^= Rotate(x[6] + x[5], 9);
+		x[4] ^= Rotate(x[7] + x[6], 13);
+		x[5] ^= Rotate(x[4] + x[7], 18);
+		x[11] ^= Rotate(x[10] + x[9], 7);
+		x[8] ^= Rotate(x[11] + x[10], 9);
+		x[9] ^= Rotate(x[8] + x[11], 13);
+		x[10] ^= Rotate(x[9] + x[8], 18);
+		x[12] ^= Rotate(x[15] + x[14], 7);
+		x[13] ^= Rotate(x[12] + x[15], 9);
+		x[14] ^= Rotate(x[13] + x[12], 13);
+		x[15] ^= Rotate(x[14] + x[13], 18);
+	}
+	for (auto i = 0; i != 16; ++i) {
+		block[i] += x[i];
+	}
+}
+
+// Input has 32 * r words, even output blocks go to the first half.
+void BlockMix(const uint32 *input, uint32 *output, int r) {
+	uint32 x[16];
+	std::copy(input + (2 * r - 1) * 16, input + 2 * r * 16, x);
+	for (auto i = 0; i != 2 * r; ++i) {
+		for (auto j = 0; j != 16; ++j) {
+			x[j] ^= input[i * 16 + j];
+		}
+		Salsa208(x);
+		std::copy(x, x + 16, output + ((i / 2) + (i % 2) * r) * 16);
+	}
+}
+
+void RoMix(bytes::span lane, const ScryptParams &params) {
+	const auto words = 32 * params.r;
+	const auto count = (1 << params.logN);
+	auto block = std::vector<uint32>(words);
+	auto mixed = std::vector<uint32>(words);
+	auto memory = std::vector<uint32>(size_t(words) * count);
+
+	const auto data = reinterpret_cast<uchar*>(lane.data());
+	for (auto i = 0; i != words; ++i) {
+		const auto bytes = data + i * 4;
+		block[i] = uint32(bytes[0])
+			| (uint32(bytes[1]) << 8)
+			| (uint32(bytes[2]) << 16)
+			| (uint32(bytes[3]) << 24);
+	}
+	for (auto i = 0; i != count; ++i) {
+		std::copy(block.begin(), block.end(), memory.begin() + i * words);
+		BlockMix(block.data(), mixed.data(), params.r);
+		std::swap(block, mixed);
+	}
+	for (auto i = 0; i != count; ++i) {
+		const auto j = block[(2 * params.r - 1) * 16] & (count - 1);
+		const auto from = memory.data() + size_t(j) * words;
+		for (auto k = 0; k != words; ++k) {
+			block[k] ^= from[k];
+		}
+		BlockMix(block.data(), mixed.data(), params.r);
+		std::swap(block, mixed);
+	}
+	for (auto i = 0; i != words; ++i) {
+		const auto bytes = data + i * 4;
+		bytes[0] = uchar(block[i]);
+		bytes[1] = uchar(block[i] >> 8);
+		bytes[2] = uchar(block[i] >> 16);
+		bytes[3] = uchar(block[i] >> 24);
+	}
+}
+
+bytes::vector Pbkdf2Sha256(
+		bytes::const_span password,
+		bytes::const_span salt,
+		int size) {
+	auto result = bytes::vector(size);
+	PKCS5_PBKDF2_HMAC(
+		reinterpret_cast<const char*>(password.data()),
+		password.size(),
+		reinterpret_cast<const unsigned char*>(salt.data()),
+		salt.size(),
+		1,
+		EVP_sha256(),
+		result.size(),
+		reinterpret_cast<unsigned char*>(result.data()));
+	return result;
+}
+
+bytes::const_span Span(const QByteArray &data) {
+	return bytes::make_span(data);
+}
+
+MTP::AuthKeyPtr CreateLegacyKey(
+		const QByteArray &passcode,
+		const QByteArray &salt) {
+	auto key = MTP::AuthKey::Data{ { gsl::byte{} } };
+
+	// Don't slow down for no passcode, it is not secure anyway.
+	const auto iterations = passcode.isEmpty()
+		? LocalEncryptNoPwdIterCount
+		: LocalEncryptIterCount;
+	PKCS5_PBKDF2_HMAC_SHA1(
+		passcode.constData(),
+		passcode.size(),
+		reinterpret_cast<const uchar*>(salt.constData()),
+		salt.size(),
+		iterations,
+		key.size(),
+		reinterpret_cast<uchar*>(key.data()));
+	return std::make_shared<MTP::AuthKey>(key);
+}
+
+MTP::AuthKeyPtr FinishScryptKey(
+		const QByteArray &passcode,
+		bytes::const_span lanes) {
+	auto key = MTP::AuthKey::Data{ { gsl::byte{} } };
+	bytes::copy(key, Pbkdf2Sha256(Span(passcode), lanes, kKeySize));
+	return std::make_shared<MTP::AuthKey>(key);
+}
+
+} // namespace
+
+QByteArray GeneratePasscodeSalt(bool hasPasscode) {
+	auto result = QByteArray(LocalEncryptSaltSize, Qt::Uninitialized);
+	memset_rand(result.data(), result.size());
+	if (!hasPasscode) {
+		return result;
+	}
+	auto header = QByteArray(kScryptMagic, kScryptMagicSize);
+	header.append(char(kScryptLogN));
+	header.append(char(kScryptR));
+	header.append(char(kScryptP));
+	header.append(char(0));
+	return header + result;
+}
+
+bool IsGoodPasscodeSalt(const QByteArray &salt) {
+	auto params = ScryptParams();
+	return IsLegacyPasscodeSalt(salt) || ParseScryptSalt(salt, params);
+}
+
+bool IsLegacyPasscodeSalt(const QByteArray &salt) {
+	return (salt.size() == LocalEncryptSaltSize);
+}
+
+MTP::AuthKeyPtr CreatePasscodeKey(
+		const QByteArray &passcode,
+		const QByteArray &salt) {
+	auto params = ScryptParams();
+	if (!ParseScryptSalt(salt, params)) {
+		return CreateLegacyKey(passcode, salt);
+	}
+	const auto laneSize = 128 * params.r;
+	auto lanes = Pbkdf2Sha256(
+		Span(passcode),
+		Span(salt),
+		laneSize * params.p);
+	for (auto i = 0; i != params.p; ++i) {
+		RoMix(bytes::make_span(lanes).subspan(i * laneSize, laneSize), params);
+	}
+	return FinishScryptKey(passcode, lanes);
+}
+
+void CreatePasscodeKeyAsync(
+		const QByteArray &passcode,
+		const QByteArray &salt,
+		Fn<void(MTP::AuthKeyPtr)> done) {
+	auto params = ScryptParams();
+	if (!ParseScryptSalt(salt, params)) {
+		crl::async([=] {
+			auto key = CreateLegacyKey(passcode, salt);
+			crl::on_main([=, key = std::move(key)] {
+				done(key);
+			});
+		});
+		return;
+	}
+
+	struct State {
+		bytes::vector lanes;
+		std::atomic<int> left = { 0 };
+	};
+	const auto state = std::make_shared<State>();
+	crl::async([=] {
+		const auto laneSize = 128 * params.r;
+		state->lanes = Pbkdf2Sha256(
+			Span(passcode),
+			Span(salt),
+			laneSize * params.p);
+		state->left = params.p;
+		for (auto i = 0; i != params.p; ++i) {
+			crl::async([=] {
+				const auto lane = bytes::make_span(
+					state->lanes
+				).subspan(i * laneSize, laneSize);
+				RoMix(lane, params);
+				if (--state->left) {
+					return;
+				}
+				auto key = FinishScryptKey(passcode, state->lanes);
+				crl::on_main([=, key = std::move(key)] {
+					done(key);
+				});
+			});
+		}
+	});
+}
+
+} // namespace Storage
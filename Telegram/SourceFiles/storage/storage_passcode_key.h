@@ -0,0 +1,33 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "mtproto/auth_key.h"
+
+namespace Storage {
+
+// The salt stored with the passcode key tells which derivation it uses.
+// Legacy salts are plain random bytes for PBKDF2-HMAC-SHA1, new salts
+// for non-empty passcodes have a header with the scrypt parameters.
+QByteArray GeneratePasscodeSalt(bool hasPasscode);
+bool IsGoodPasscodeSalt(const QByteArray &salt);
+bool IsLegacyPasscodeSalt(const QByteArray &salt);
+
+// Blocks the caller, scrypt lanes are computed one by one.
+MTP::AuthKeyPtr CreatePasscodeKey(
+	const QByteArray &passcode,
+	const QByteArray &salt);
+
+// Derives the key on background threads, scrypt lanes in parallel.
+// The callback is invoked on the main thread.
+void CreatePasscodeKeyAsync(
+	const QByteArray &passcode,
+	const QByteArray &salt,
+	Fn<void(MTP::AuthKeyPtr)> done);
+
+} // namespace Storage
@@ -0,0 +1,237 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "storage/storage_search_index.h"
+
+#include "storage/localstorage.h"
+#include "history/history.h"
+#include "history/history_item.h"
+
+namespace Storage {
+namespace {
+
+constexpr auto kEntriesLimit = 20000;
+constexpr auto kSaveDelay = TimeMs(5 * 60 * 1000);
+
+QStringList PrepareWords(const QString &text) {
+	auto result = TextUtilities::PrepareSearchWords(text);
+	result.sort();
+	result.removeDuplicates();
+	return result;
+}
+
+} // namespace
+
+SearchIndex::SearchIndex() : _saveTimer([=] { save(); }) {
+}
+
+SearchIndex::~SearchIndex() {
+	// The delayed save won't happen anymore, write the changes right away.
+	if (_saveTimer.isActive()) {
+		Local::writeSearchIndex(Local::prepareSearchIndex(collectEntries())());
+	}
+}
+
+void SearchIndex::add(not_null<HistoryItem*> item) {
+	if (!IsServerMsgId(item->id)
+		|| item->isLogEntry()
+		|| item->serviceMsg()) {
+		return;
+	}
+	load();
+
+	const auto key = Key(item->history()->peer->id, item->id);
+	const auto text = item->originalText().text;
+	const auto textHash = qHash(text);
+	const auto i = _entries.find(key);
+	const auto existed = (i != _entries.end());
+	if (existed) {
+		if (i->second.textHash == textHash) {
+			return;
+		}
+		erase(i);
+	}
+	auto entry = Entry();
+	entry.date = item->date();
+	entry.from = item->from()->id;
+	entry.words = PrepareWords(text);
+	entry.textHash = textHash;
+	if (!entry.words.isEmpty()) {
+		insert(key, std::move(entry));
+	} else if (!existed) {
+		return;
+	}
+	saveDelayed();
+}
+
+void SearchIndex::remove(PeerId peerId, MsgId msgId) {
+	load();
+
+	const auto i = _entries.find(Key(peerId, msgId));
+	if (i != _entries.end()) {
+		erase(i);
+		saveDelayed();
+	}
+}
+
+void SearchIndex::remove(PeerId peerId) {
+	load();
+
+	auto i = _entries.lower_bound(
+		Key(peerId, std::numeric_limits<MsgId>::min()));
+	if (i == _entries.end() || i->first.first != peerId) {
+		return;
+	}
+	while (i != _entries.end() && i->first.first == peerId) {
+		erase(i++);
+	}
+	saveDelayed();
+}
+
+std::vector<SearchIndexResult> SearchIndex::query(
+		const SearchIndexQuery &query) {
+	load();
+
+	auto found = std::vector<Key>();
+	auto first = true;
+	for (const auto &word : TextUtilities::PrepareSearchWords(query.query)) {
+		auto keys = find(word);
+		if (first) {
+			found = std::move(keys);
+			first = false;
+		} else {
+			auto intersection = std::vector<Key>();
+			std::set_intersection(
+				found.begin(),
+				found.end(),
+				keys.begin(),
+				keys.end(),
+				std::back_inserter(intersection));
+			found = std::move(intersection);
+		}
+		if (found.empty()) {
+			break;
+		}
+	}
+
+	auto result = std::vector<SearchIndexResult>();
+	for (const auto &key : found) {
+		const auto peerId = key.first;
+		if (query.peerId && peerId != query.peerId) {
+			continue;
+		}
+		const auto &entry = _entries.find(key)->second;
+		if (query.fromId && entry.from != query.fromId) {
+			continue;
+		}
+		result.push_back({ peerId, key.second, entry.date });
+	}
+	ranges::sort(result, [](
+			const SearchIndexResult &a,
+			const SearchIndexResult &b) {
+		return (a.date > b.date)
+			|| (a.date == b.date && a.msgId > b.msgId);
+	});
+	return result;
+}
+
+void SearchIndex::load() {
+	if (_loaded) {
+		return;
+	}
+	_loaded = true;
+	for (auto &entry : Local::readSearchIndex()) {
+		auto loaded = Entry();
+		loaded.date = entry.date;
+		loaded.from = entry.from;
+		loaded.textHash = entry.textHash;
+		loaded.words = std::move(entry.words);
+		if (!loaded.words.isEmpty()) {
+			const auto key = Key(entry.peer, entry.msgId);
+			const auto i = _entries.find(key);
+			if (i != _entries.end()) {
+				erase(i);
+			}
+			insert(key, std::move(loaded));
+		}
+	}
+}
+
+void SearchIndex::insert(Key key, Entry &&entry) {
+	for (const auto &word : entry.words) {
+		_words[word].insert(key);
+	}
+	_byDate.emplace(entry.date, key);
+	_entries.emplace(key, std::move(entry));
+
+	while (_entries.size() > kEntriesLimit) {
+		erase(_entries.find(_byDate.begin()->second));
+	}
+}
+
+void SearchIndex::erase(std::map<Key, Entry>::iterator i) {
+	const auto key = i->first;
+	for (const auto &word : i->second.words) {
+		const auto j = _words.find(word);
+		if (j != _words.end()) {
+			j->second.removeOne(key);
+			if (j->second.empty()) {
+				_words.erase(j);
+			}
+		}
+	}
+	_byDate.erase(std::make_pair(i->second.date, key));
+	_entries.erase(i);
+}
+
+std::vector<SearchIndex::Key> SearchIndex::find(
+		const QString &prefix) const {
+	auto result = std::vector<Key>();
+	for (auto i = _words.lower_bound(prefix); i != _words.end(); ++i) {
+		if (!i->first.startsWith(prefix)) {
+			break;
+		}
+		result.insert(result.end(), i->second.begin(), i->second.end());
+	}
+	ranges::sort(result);
+	result.erase(ranges::unique(result), result.end());
+	return result;
+}
+
+void SearchIndex::saveDelayed() {
+	if (!_saveTimer.isActive()) {
+		_saveTimer.callOnce(kSaveDelay);
+	}
+}
+
+void SearchIndex::save() {
+	auto prepare = Local::prepareSearchIndex(collectEntries());
+	crl::async([=, weak = base::make_weak(this)] {
+		auto prepared = prepare();
+		crl::on_main(weak, [prepared = std::move(prepared)] {
+			Local::writeSearchIndex(prepared);
+		});
+	});
+}
+
+std::vector<Local::SearchIndexEntry> SearchIndex::collectEntries() const {
+	auto result = std::vector<Local::SearchIndexEntry>();
+	result.reserve(_entries.size());
+	for (const auto &[key, entry] : _entries) {
+		auto saved = Local::SearchIndexEntry();
+		saved.peer = key.first;
+		saved.msgId = key.second;
+		saved.date = entry.date;
+		saved.from = entry.from;
+		saved.textHash = entry.textHash;
+		saved.words = entry.words;
+		result.push_back(std::move(saved));
+	}
+	return result;
+}
+
+} // namespace Storage
@@ -0,0 +1,71 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/timer.h"
+#include "base/weak_ptr.h"
+
+namespace Local {
+struct SearchIndexEntry;
+} // namespace Local
+
+namespace Storage {
+
+struct SearchIndexQuery {
+	QString query;
+	PeerId peerId = 0; // Search in all chats if empty.
+	PeerId fromId = 0;
+};
+
+struct SearchIndexResult {
+	PeerId peerId = 0;
+	MsgId msgId = 0;
+	TimeId date = 0;
+};
+
+// Full text index of the messages that were loaded at least once.
+// Words are prepared by TextUtilities::PrepareSearchWords(), every
+// query word should be a prefix of some word of the message.
+class SearchIndex final : public base::has_weak_ptr {
+public:
+	SearchIndex();
+	~SearchIndex();
+
+	void add(not_null<HistoryItem*> item);
+	void remove(PeerId peerId, MsgId msgId);
+	void remove(PeerId peerId);
+
+	// Newest messages go first.
+	std::vector<SearchIndexResult> query(const SearchIndexQuery &query);
+
+private:
+	using Key = std::pair<PeerId, MsgId>;
+	struct Entry {
+		TimeId date = 0;
+		PeerId from = 0;
+		QStringList words;
+		uint textHash = 0;
+	};
+
+	void load();
+	void insert(Key key, Entry &&entry);
+	void erase(std::map<Key, Entry>::iterator i);
+	std::vector<Key> find(const QString &prefix) const;
+	void saveDelayed();
+	void save();
+	std::vector<Local::SearchIndexEntry> collectEntries() const;
+
+	bool _loaded = false;
+	std::map<Key, Entry> _entries;
+	std::set<std::pair<TimeId, Key>> _byDate;
+	std::map<QString, base::flat_set<Key>> _words;
+	base::Timer _saveTimer;
+
+};
+
+} // namespace Storage
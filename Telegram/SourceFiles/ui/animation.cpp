@@ -26,6 +26,9 @@ ReaderPointer::~ReaderPointer() {
 
 namespace {
 
+constexpr auto kVisibilityCheckDelta = TimeMs(250);
+constexpr auto kWakeupsCountPeriod = TimeMs(1000);
+
 AnimationManager *_manager = nullptr;
 bool AnimationsDisabled = false;
 
@@ -108,6 +111,16 @@ void SetDisabled(bool disabled) {
 	}
 }
 
+void WindowsVisibilityChanged() {
+	if (_manager) {
+		_manager->checkWindowsVisibility();
+	}
+}
+
+int WakeupsPerSecond() {
+	return _manager ? _manager->wakeupsPerSecond() : 0;
+}
+
 } // anim
 
 void BasicAnimation::start() {
@@ -137,7 +150,12 @@ void AnimationManager::start(BasicAnimation *obj) {
 			_stopping.remove(obj);
 		}
 	} else {
-		if (_objects.isEmpty()) {
+		if (_paused) {
+			// Someone wants to animate, most likely a window was shown.
+			_paused = false;
+			_visibilityCheckedMs = getms();
+		}
+		if (_objects.isEmpty() || !_timer.isActive()) {
 			_timer.start(AnimationTimerDelta);
 		}
 		_objects.insert(obj);
@@ -161,9 +179,60 @@ void AnimationManager::stop(BasicAnimation *obj) {
 	}
 }
 
+void AnimationManager::checkWindowsVisibility() {
+	_visibilityCheckedMs = getms();
+	if (!hasVisibleWindows()) {
+		pause();
+	} else if (_paused) {
+		resume();
+	}
+}
+
+int AnimationManager::wakeupsPerSecond() const {
+	const auto passed = getms() - _wakeupsCountStartMs;
+	return (passed < 2 * kWakeupsCountPeriod) ? _wakeupsPerSecond : 0;
+}
+
+bool AnimationManager::hasVisibleWindows() const {
+	for (const auto widget : QApplication::topLevelWidgets()) {
+		if (widget->isVisible() && !widget->isMinimized()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void AnimationManager::countWakeup(TimeMs ms) {
+	++_wakeupsCount;
+	const auto passed = ms - _wakeupsCountStartMs;
+	if (passed >= kWakeupsCountPeriod) {
+		_wakeupsPerSecond = (passed < 2 * kWakeupsCountPeriod)
+			? int(_wakeupsCount * kWakeupsCountPeriod / passed)
+			: 0;
+		_wakeupsCount = 0;
+		_wakeupsCountStartMs = ms;
+	}
+}
+
+void AnimationManager::pause() {
+	if (_paused) {
+		return;
+	}
+	_paused = true;
+	_timer.stop();
+}
+
+void AnimationManager::resume() {
+	_paused = false;
+	if (!_objects.empty()) {
+		_timer.start(AnimationTimerDelta);
+	}
+}
+
 void AnimationManager::timeout() {
 	_iterating = true;
 	auto ms = getms();
+	countWakeup(ms);
 	for_const (auto object, _objects) {
 		if (!_stopping.contains(object)) {
 			object->step(ms, true);
@@ -185,6 +254,10 @@ void AnimationManager::timeout() {
 	}
 	if (_objects.empty()) {
 		_timer.stop();
+	} else if (ms - _visibilityCheckedMs >= kVisibilityCheckDelta) {
+		// Animations depend only on time, so when the windows
+		// are shown again they will jump right to the actual state.
+		checkWindowsVisibility();
 	}
 }
 
@@ -417,6 +417,11 @@ QPainterPath path(QPointF (&from)[N]) {
 bool Disabled();
 void SetDisabled(bool disabled);
 
+// All animations are stepped by one timer, it is stopped while nothing
+// is animating or while all the application windows are hidden.
+void WindowsVisibilityChanged();
+int WakeupsPerSecond();
+
 };
 
 class BasicAnimation;
@@ -699,15 +704,28 @@ public:
 	void start(BasicAnimation *obj);
 	void stop(BasicAnimation *obj);
 
+	void checkWindowsVisibility();
+	int wakeupsPerSecond() const;
+
 public slots:
 	void timeout();
 
 	void clipCallback(Media::Clip::Reader *reader, qint32 threadIndex, qint32 notification);
 
 private:
+	bool hasVisibleWindows() const;
+	void countWakeup(TimeMs ms);
+	void pause();
+	void resume();
+
 	using AnimatingObjects = OrderedSet<BasicAnimation*>;
 	AnimatingObjects _objects, _starting, _stopping;
 	QTimer _timer;
 	bool _iterating;
+	bool _paused = false;
+	TimeMs _visibilityCheckedMs = 0;
+	TimeMs _wakeupsCountStartMs = 0;
+	int _wakeupsCount = 0;
+	int _wakeupsPerSecond = 0;
 
 };
@@ -12,15 +12,168 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "chat_helpers/emoji_suggestions_helper.h"
 #include "auth_session.h"
+#include "base/timer.h"
+
+#include <QtGui/QImageReader>
 
 namespace Ui {
 namespace Emoji {
 namespace {
 
 constexpr auto kSaveRecentEmojiTimeout = 3000;
+constexpr auto kTileRows = 8;
+constexpr auto kReleaseSourceTimeout = TimeMs(30000);
+constexpr auto kTileUnusedTimeout = TimeMs(120000);
 
 auto WorkingIndex = -1;
 
+struct Sprites {
+	int index = -1;
+	int size = 0;
+	int rows = 0;
+	QImage source;
+	bool loading = false;
+	base::flat_set<int> waiting;
+	std::vector<QPixmap> tiles;
+	std::vector<TimeMs> used;
+};
+
+Sprites Normal;
+Sprites Large;
+std::unique_ptr<base::Timer> ReleaseSourceTimer;
+
+// Pending decodes are dropped if the sprites were cleared meanwhile.
+auto Generation = 0;
+
+Sprites &SpritesBySize(int size) {
+	const auto large = (size != Size(Index()));
+	auto &result = large ? Large : Normal;
+	if (result.index < 0) {
+		result.index = large ? (Index() + 1) : Index();
+		result.size = Size(result.index);
+
+		// Only the header is read here, the atlas is decoded on demand.
+		const auto full = QImageReader(Filename(result.index)).size();
+		result.rows = (full.height() + result.size - 1) / result.size;
+		const auto count = (result.rows + kTileRows - 1) / kTileRows;
+		result.tiles.resize(count);
+		result.used.resize(count, 0);
+	}
+	return result;
+}
+
+int64 MemoryUsed(const Sprites &sprites) {
+	auto result = int64(sprites.source.byteCount());
+	for (const auto &tile : sprites.tiles) {
+		result += int64(tile.width()) * tile.height() * 4;
+	}
+	return result;
+}
+
+void LogMemoryUsed() {
+	DEBUG_LOG(("Emoji: %1 KB of sprites in memory."
+		).arg((MemoryUsed(Normal) + MemoryUsed(Large)) / 1024));
+}
+
+void ReleaseSources() {
+	Normal.source = QImage();
+	Large.source = QImage();
+	LogMemoryUsed();
+}
+
+void RepaintAll() {
+	for (const auto widget : QApplication::topLevelWidgets()) {
+		if (widget->isVisible()) {
+			widget->update();
+		}
+	}
+}
+
+void CutTile(Sprites &sprites, int tile) {
+	const auto top = tile * kTileRows * sprites.size;
+	const auto height = std::min(
+		kTileRows * sprites.size,
+		sprites.source.height() - top);
+	auto &result = sprites.tiles[tile];
+	result = App::pixmapFromImageInPlace(sprites.source.copy(
+		0,
+		top,
+		sprites.source.width(),
+		height));
+	if (cRetina()) result.setDevicePixelRatio(cRetinaFactor());
+}
+
+// Keeps the source while the tiles are still requested.
+void ReleaseSourceDelayed(Sprites &sprites) {
+	const auto missing = [](const QPixmap &tile) {
+		return tile.isNull();
+	};
+	if (ranges::find_if(sprites.tiles, missing) == end(sprites.tiles)) {
+		// All tiles are ready, the source is not needed anymore.
+		sprites.source = QImage();
+	} else {
+		if (!ReleaseSourceTimer) {
+			ReleaseSourceTimer = std::make_unique<base::Timer>(
+				ReleaseSources);
+		}
+		ReleaseSourceTimer->callOnce(kReleaseSourceTimeout);
+	}
+}
+
+void SourceLoaded(Sprites &sprites, QImage &&source) {
+	sprites.loading = false;
+	sprites.source = std::move(source);
+	for (const auto tile : base::take(sprites.waiting)) {
+		if (sprites.tiles[tile].isNull()) {
+			CutTile(sprites, tile);
+		}
+	}
+
+	ReleaseSourceDelayed(sprites);
+	LogMemoryUsed();
+	RepaintAll();
+}
+
+// The atlas is decoded in the background, so a tile freed by the cache
+// cleanup is not painted for a moment instead of blocking the paint.
+void LoadSource(Sprites &sprites) {
+	if (sprites.loading) {
+		return;
+	}
+	sprites.loading = true;
+	const auto large = (&sprites == &Large);
+	const auto index = sprites.index;
+	const auto generation = Generation;
+	crl::async([=] {
+		const auto ms = getms();
+		auto source = QImage(Filename(index)).convertToFormat(
+			QImage::Format_ARGB32_Premultiplied);
+		DEBUG_LOG(("Emoji: atlas %1 decoded in %2ms."
+			).arg(index
+			).arg(getms() - ms));
+		crl::on_main([=, source = std::move(source)]() mutable {
+			if (generation == Generation) {
+				SourceLoaded(large ? Large : Normal, std::move(source));
+			}
+		});
+	});
+}
+
+const QPixmap &PrepareTile(Sprites &sprites, int tile) {
+	auto &result = sprites.tiles[tile];
+	sprites.used[tile] = getms(true);
+	if (!result.isNull()) {
+		return result;
+	} else if (sprites.source.isNull()) {
+		sprites.waiting.emplace(tile);
+		LoadSource(sprites);
+		return result;
+	}
+	CutTile(sprites, tile);
+	ReleaseSourceDelayed(sprites);
+	return result;
+}
+
 void AppendPartToResult(TextWithEntities &result, const QChar *start, const QChar *from, const QChar *to) {
 	if (to <= from) {
 		return;
@@ -81,6 +234,57 @@ int Index() {
 	return WorkingIndex;
 }
 
+void Draw(QPainter &p, EmojiPtr emoji, int size, int x, int y) {
+	auto &sprites = SpritesBySize(size);
+	const auto tile = emoji->y() / kTileRows;
+	if (tile >= int(sprites.tiles.size())) {
+		return;
+	}
+	const auto &pixmap = PrepareTile(sprites, tile);
+	if (pixmap.isNull()) {
+		return;
+	}
+	p.drawPixmap(
+		QPoint(x, y),
+		pixmap,
+		QRect(
+			emoji->x() * size,
+			(emoji->y() % kTileRows) * size,
+			size,
+			size));
+}
+
+void Preload(const EmojiPack &list, int size) {
+	auto &sprites = SpritesBySize(size);
+	for (const auto emoji : list) {
+		const auto tile = emoji->y() / kTileRows;
+		if (tile < int(sprites.tiles.size())) {
+			PrepareTile(sprites, tile);
+		}
+	}
+}
+
+void ClearIrrelevantCache() {
+	const auto now = getms(true);
+	const auto clear = [&](Sprites &sprites) {
+		for (auto i = 0, count = int(sprites.tiles.size()); i != count; ++i) {
+			if (sprites.used[i] + kTileUnusedTimeout <= now) {
+				sprites.tiles[i] = QPixmap();
+			}
+		}
+	};
+	clear(Normal);
+	clear(Large);
+	ReleaseSources();
+}
+
+void Clear() {
+	++Generation;
+	ReleaseSourceTimer = nullptr;
+	Normal = Sprites();
+	Large = Sprites();
+}
+
 int One::variantsCount() const {
 	return hasVariants() ? 5 : 0;
 }
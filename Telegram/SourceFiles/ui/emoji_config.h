@@ -139,6 +139,13 @@ inline QString Filename(int index = Index()) {
 	return QString::fromLatin1(EmojiNames[index]);
 }
 
+// Sprites are cut from the atlas by tiles of several rows which are
+// prepared on the first use and may be freed later when not used.
+void Draw(QPainter &p, EmojiPtr emoji, int size, int x, int y);
+void Preload(const EmojiPack &list, int size);
+void ClearIrrelevantCache();
+void Clear();
+
 void ReplaceInText(TextWithEntities &result);
 RecentEmojiPack &GetRecent();
 void AddRecent(EmojiPtr emoji);
@@ -400,6 +400,41 @@ uint64 SinglePixKey(Images::Options options) {
 	return PixKey(0, 0, options);
 }
 
+int PixKeyWidth(uint64 key) {
+	return static_cast<int>(key & 0xFFFFFFULL);
+}
+
+Images::Options PixKeyOptions(uint64 key) {
+	return Images::Options::from_raw(
+		static_cast<Images::Options::Type>(key >> 48));
+}
+
+Images::Options RoundOptions(ImageRoundRadius radius, RectParts corners) {
+	const auto cornerOptions = [&] {
+		return (corners & RectPart::TopLeft ? Images::Option::RoundedTopLeft : Images::Option::None)
+			| (corners & RectPart::TopRight ? Images::Option::RoundedTopRight : Images::Option::None)
+			| (corners & RectPart::BottomLeft ? Images::Option::RoundedBottomLeft : Images::Option::None)
+			| (corners & RectPart::BottomRight ? Images::Option::RoundedBottomRight : Images::Option::None);
+	};
+	if (radius == ImageRoundRadius::Large) {
+		return Images::Option::RoundedLarge | cornerOptions();
+	} else if (radius == ImageRoundRadius::Small) {
+		return Images::Option::RoundedSmall | cornerOptions();
+	} else if (radius == ImageRoundRadius::Ellipse) {
+		return Images::Option::Circled | cornerOptions();
+	}
+	return Images::Option::None;
+}
+
+QImage ReadSavedImage(QByteArray data, const QByteArray &format) {
+	QBuffer buffer(&data);
+	QImageReader reader(&buffer, format);
+#ifndef OS_MAC_OLD
+	reader.setAutoTransform(true);
+#endif // OS_MAC_OLD
+	return reader.read();
+}
+
 } // namespace
 
 StorageImageLocation StorageImageLocation::Null;
@@ -518,19 +553,7 @@ const QPixmap &Image::pixRounded(
 		h *= cIntRetinaFactor();
 	}
 	auto options = Images::Option::Smooth | Images::Option::None;
-	auto cornerOptions = [](RectParts corners) {
-		return (corners & RectPart::TopLeft ? Images::Option::RoundedTopLeft : Images::Option::None)
-			| (corners & RectPart::TopRight ? Images::Option::RoundedTopRight : Images::Option::None)
-			| (corners & RectPart::BottomLeft ? Images::Option::RoundedBottomLeft : Images::Option::None)
-			| (corners & RectPart::BottomRight ? Images::Option::RoundedBottomRight : Images::Option::None);
-	};
-	if (radius == ImageRoundRadius::Large) {
-		options |= Images::Option::RoundedLarge | cornerOptions(corners);
-	} else if (radius == ImageRoundRadius::Small) {
-		options |= Images::Option::RoundedSmall | cornerOptions(corners);
-	} else if (radius == ImageRoundRadius::Ellipse) {
-		options |= Images::Option::Circled | cornerOptions(corners);
-	}
+	options |= RoundOptions(radius, corners);
 	auto k = PixKey(w, h, options);
 	auto i = _sizesCache.constFind(k);
 	if (i == _sizesCache.cend()) {
@@ -695,19 +718,7 @@ const QPixmap &Image::pixSingle(
 	}
 
 	auto options = Images::Option::Smooth | Images::Option::None;
-	auto cornerOptions = [](RectParts corners) {
-		return (corners & RectPart::TopLeft ? Images::Option::RoundedTopLeft : Images::Option::None)
-			| (corners & RectPart::TopRight ? Images::Option::RoundedTopRight : Images::Option::None)
-			| (corners & RectPart::BottomLeft ? Images::Option::RoundedBottomLeft : Images::Option::None)
-			| (corners & RectPart::BottomRight ? Images::Option::RoundedBottomRight : Images::Option::None);
-	};
-	if (radius == ImageRoundRadius::Large) {
-		options |= Images::Option::RoundedLarge | cornerOptions(corners);
-	} else if (radius == ImageRoundRadius::Small) {
-		options |= Images::Option::RoundedSmall | cornerOptions(corners);
-	} else if (radius == ImageRoundRadius::Ellipse) {
-		options |= Images::Option::Circled | cornerOptions(corners);
-	}
+	options |= RoundOptions(radius, corners);
 	if (colored) {
 		options |= Images::Option::Colored;
 	}
@@ -746,19 +757,7 @@ const QPixmap &Image::pixBlurredSingle(
 	}
 
 	auto options = Images::Option::Smooth | Images::Option::Blurred;
-	auto cornerOptions = [](RectParts corners) {
-		return (corners & RectPart::TopLeft ? Images::Option::RoundedTopLeft : Images::Option::None)
-			| (corners & RectPart::TopRight ? Images::Option::RoundedTopRight : Images::Option::None)
-			| (corners & RectPart::BottomLeft ? Images::Option::RoundedBottomLeft : Images::Option::None)
-			| (corners & RectPart::BottomRight ? Images::Option::RoundedBottomRight : Images::Option::None);
-	};
-	if (radius == ImageRoundRadius::Large) {
-		options |= Images::Option::RoundedLarge | cornerOptions(corners);
-	} else if (radius == ImageRoundRadius::Small) {
-		options |= Images::Option::RoundedSmall | cornerOptions(corners);
-	} else if (radius == ImageRoundRadius::Ellipse) {
-		options |= Images::Option::Circled | cornerOptions(corners);
-	}
+	options |= RoundOptions(radius, corners);
 
 	auto k = SinglePixKey(options);
 	auto i = _sizesCache.constFind(k);
@@ -776,6 +775,240 @@ const QPixmap &Image::pixBlurredSingle(
 	return i.value();
 }
 
+const QPixmap &Image::pixAsync(
+		Data::FileOrigin origin,
+		int32 w,
+		int32 h) const {
+	checkload();
+
+	if (w <= 0 || !width() || !height()) {
+		w = width();
+	} else if (cRetina()) {
+		w *= cIntRetinaFactor();
+		h *= cIntRetinaFactor();
+	}
+	const auto options = Images::Option::Smooth | Images::Option::None;
+	return pixCachedAsync(origin, w, h, options);
+}
+
+const QPixmap &Image::pixRoundedAsync(
+		Data::FileOrigin origin,
+		int32 w,
+		int32 h,
+		ImageRoundRadius radius,
+		RectParts corners) const {
+	checkload();
+
+	if (w <= 0 || !width() || !height()) {
+		w = width();
+	} else if (cRetina()) {
+		w *= cIntRetinaFactor();
+		h *= cIntRetinaFactor();
+	}
+	const auto options = Images::Option::Smooth
+		| RoundOptions(radius, corners);
+	return pixCachedAsync(origin, w, h, options);
+}
+
+const QPixmap &Image::pixBlurredAsync(
+		Data::FileOrigin origin,
+		int32 w,
+		int32 h) const {
+	checkload();
+
+	if (w <= 0 || !width() || !height()) {
+		w = width() * cIntRetinaFactor();
+	} else if (cRetina()) {
+		w *= cIntRetinaFactor();
+		h *= cIntRetinaFactor();
+	}
+	const auto options = Images::Option::Smooth | Images::Option::Blurred;
+	return pixCachedAsync(origin, w, h, options);
+}
+
+const QPixmap &Image::pixColoredAsync(
+		Data::FileOrigin origin,
+		style::color add,
+		int32 w,
+		int32 h) const {
+	checkload();
+
+	if (w <= 0 || !width() || !height()) {
+		w = width() * cIntRetinaFactor();
+	} else if (cRetina()) {
+		w *= cIntRetinaFactor();
+		h *= cIntRetinaFactor();
+	}
+	const auto options = Images::Option::Smooth | Images::Option::Colored;
+	return pixCachedAsync(origin, w, h, options, &add);
+}
+
+const QPixmap &Image::pixCircledAsync(
+		Data::FileOrigin origin,
+		int32 w,
+		int32 h) const {
+	checkload();
+
+	if (w <= 0 || !width() || !height()) {
+		w = width();
+	} else if (cRetina()) {
+		w *= cIntRetinaFactor();
+		h *= cIntRetinaFactor();
+	}
+	const auto options = Images::Option::Smooth | Images::Option::Circled;
+	return pixCachedAsync(origin, w, h, options);
+}
+
+const QPixmap &Image::pixCachedAsync(
+		Data::FileOrigin origin,
+		int32 w,
+		int32 h,
+		Images::Options options,
+		const style::color *colored) const {
+	const auto k = PixKey(w, h, options);
+	auto i = _sizesCache.constFind(k);
+	if (i != _sizesCache.cend()) {
+		return i.value();
+	}
+	if (!loading()) const_cast<Image*>(this)->load(origin);
+
+	if (isNull() || (_data.isNull() && !_forgot)) {
+		// Nothing to decode yet, the blank placeholder is cheap.
+		auto p = colored
+			? pixColoredNoCache(origin, *colored, w, h, true)
+			: pixNoCache(origin, w, h, options);
+		if (cRetina()) p.setDevicePixelRatio(cRetinaFactor());
+		i = _sizesCache.insert(k, p);
+		if (!p.isNull()) {
+			globalAcquiredSize += int64(p.width()) * p.height() * 4;
+		}
+		return i.value();
+	}
+
+	if (!_sizesRequested.contains(k)) {
+		_sizesRequested.emplace(k);
+
+		// Blur and scale on a background thread, masks and colorizing
+		// use main thread caches and are applied when the result lands.
+		const auto threadOptions = options
+			& (Images::Option::Smooth | Images::Option::Blurred);
+		const auto mainOptions = options & ~threadOptions;
+		const auto color = colored ? *colored : style::color();
+		const auto hasColor = (colored != nullptr);
+		const auto generation = _sizesGeneration;
+		const auto saved = _forgot ? _saved : QByteArray();
+		const auto format = _format;
+		const auto weak = base::make_weak(this);
+		auto source = _forgot ? QImage() : _data.toImage();
+		crl::async([=, source = std::move(source)]() mutable {
+			auto original = QImage();
+			if (source.isNull()) {
+				original = ReadSavedImage(saved, format);
+				source = original;
+			}
+			auto result = source.isNull()
+				? QImage()
+				: Images::prepare(std::move(source), w, h, threadOptions, 0, 0);
+			crl::on_main(weak, [=,
+					original = std::move(original),
+					result = std::move(result)]() mutable {
+				if (generation != _sizesGeneration) {
+					return;
+				}
+				if (!original.isNull()) {
+					pixRestored(std::move(original));
+				}
+				if (!result.isNull() && mainOptions) {
+					result = Images::prepare(
+						std::move(result),
+						0,
+						0,
+						mainOptions,
+						0,
+						0,
+						hasColor ? &color : nullptr);
+				}
+				pixPrepared(k, std::move(result));
+			});
+		});
+	}
+	return pixPlaceholder(k, w, h, options);
+}
+
+const QPixmap &Image::pixPlaceholder(
+		uint64 key,
+		int32 w,
+		int32 h,
+		Images::Options options) const {
+	auto i = _sizesPlaceholders.constFind(key);
+	if (i != _sizesPlaceholders.cend()) {
+		return i.value();
+	}
+
+	// Any cached size of the same shape will do, blurred or not.
+	const auto shape = [](Images::Options value) {
+		return value & ~(Images::Option::Smooth | Images::Option::Blurred);
+	};
+	auto closest = _sizesCache.cend();
+	auto closestDistance = 0;
+	for (auto j = _sizesCache.cbegin(), e = _sizesCache.cend(); j != e; ++j) {
+		if (j->isNull()
+			|| !PixKeyWidth(j.key())
+			|| shape(PixKeyOptions(j.key())) != shape(options)) {
+			continue;
+		}
+		const auto distance = qAbs(j->width() - w);
+		if (closest == e || distance < closestDistance) {
+			closest = j;
+			closestDistance = distance;
+		}
+	}
+	auto p = QPixmap();
+	if (closest != _sizesCache.cend()) {
+		const auto height = (h > 0)
+			? h
+			: qMax(qRound(closest->height() * w / float64(closest->width())), 1);
+		p = closest->scaled(w, height, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+		if (cRetina()) p.setDevicePixelRatio(cRetinaFactor());
+	}
+	i = _sizesPlaceholders.insert(key, p);
+	if (!p.isNull()) {
+		globalAcquiredSize += int64(p.width()) * p.height() * 4;
+	}
+	return i.value();
+}
+
+void Image::pixPrepared(uint64 key, QImage &&result) const {
+	_sizesRequested.remove(key);
+	const auto placeholder = _sizesPlaceholders.find(key);
+	if (placeholder != _sizesPlaceholders.end()) {
+		if (!placeholder->isNull()) {
+			globalAcquiredSize -= int64(placeholder->width()) * placeholder->height() * 4;
+		}
+		_sizesPlaceholders.erase(placeholder);
+	}
+
+	auto p = App::pixmapFromImageInPlace(std::move(result));
+	if (cRetina()) p.setDevicePixelRatio(cRetinaFactor());
+	_sizesCache.insert(key, p);
+	if (!p.isNull()) {
+		globalAcquiredSize += int64(p.width()) * p.height() * 4;
+	}
+	if (AuthSession::Exists()) {
+		Auth().downloaderTaskFinished().notify();
+	}
+}
+
+void Image::pixRestored(QImage &&original) const {
+	if (!_forgot) return;
+
+	_data = App::pixmapFromImageInPlace(std::move(original));
+	if (!_data.isNull()) {
+		globalAcquiredSize += int64(_data.width()) * _data.height() * 4;
+	}
+	_forgot = false;
+}
+
 QPixmap Image::pixNoCache(
 		Data::FileOrigin origin,
 		int w,
@@ -922,6 +1155,14 @@ void Image::invalidateSizeCache() const {
 		}
 	}
 	_sizesCache.clear();
+	for (auto &pix : _sizesPlaceholders) {
+		if (!pix.isNull()) {
+			globalAcquiredSize -= int64(pix.width()) * pix.height() * 4;
+		}
+	}
+	_sizesPlaceholders.clear();
+	_sizesRequested.clear();
+	++_sizesGeneration;
 }
 
 Image::~Image() {
@@ -954,6 +1195,14 @@ int64 imageCacheSize() {
 	return globalAcquiredSize;
 }
 
+void acquireImageCacheMemory(int64 size) {
+	globalAcquiredSize += size;
+}
+
+void releaseImageCacheMemory(int64 size) {
+	globalAcquiredSize -= size;
+}
+
 void RemoteImage::doCheckload() const {
 	if (!amLoading() || !_loader->finished()) return;
 
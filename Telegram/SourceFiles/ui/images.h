@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "base/flags.h"
+#include "base/weak_ptr.h"
 #include "data/data_file_origin.h"
 
 enum class ImageRoundRadius {
@@ -246,7 +247,7 @@ inline bool operator!=(const WebFileLocation &a, const WebFileLocation &b) {
 class DelayedStorageImage;
 
 class HistoryItem;
-class Image {
+class Image : public base::has_weak_ptr {
 public:
 	Image(const QString &file, QByteArray format = QByteArray());
 	Image(const QByteArray &filecontent, QByteArray format = QByteArray());
@@ -327,6 +328,35 @@ public:
 		Data::FileOrigin origin,
 		int32 w = 0,
 		int32 h = 0) const;
+
+	// Same as the methods above, but a cache miss never blocks the caller:
+	// decoding, scaling and blurring are done on a background thread and
+	// until the result is ready the closest already cached size is shown.
+	// Subscribers of downloaderTaskFinished() are notified on completion.
+	const QPixmap &pixAsync(
+		Data::FileOrigin origin,
+		int32 w = 0,
+		int32 h = 0) const;
+	const QPixmap &pixRoundedAsync(
+		Data::FileOrigin origin,
+		int32 w = 0,
+		int32 h = 0,
+		ImageRoundRadius radius = ImageRoundRadius::None,
+		RectParts corners = RectPart::AllCorners) const;
+	const QPixmap &pixBlurredAsync(
+		Data::FileOrigin origin,
+		int32 w = 0,
+		int32 h = 0) const;
+	const QPixmap &pixColoredAsync(
+		Data::FileOrigin origin,
+		style::color add,
+		int32 w = 0,
+		int32 h = 0) const;
+	const QPixmap &pixCircledAsync(
+		Data::FileOrigin origin,
+		int32 w = 0,
+		int32 h = 0) const;
+
 	QPixmap pixNoCache(
 		Data::FileOrigin origin,
 		int w = 0,
@@ -419,8 +449,25 @@ protected:
 	mutable QPixmap _data;
 
 private:
+	const QPixmap &pixCachedAsync(
+		Data::FileOrigin origin,
+		int32 w,
+		int32 h,
+		Images::Options options,
+		const style::color *colored = nullptr) const;
+	const QPixmap &pixPlaceholder(
+		uint64 key,
+		int32 w,
+		int32 h,
+		Images::Options options) const;
+	void pixPrepared(uint64 key, QImage &&result) const;
+	void pixRestored(QImage &&original) const;
+
 	using Sizes = QMap<uint64, QPixmap>;
 	mutable Sizes _sizesCache;
+	mutable Sizes _sizesPlaceholders;
+	mutable base::flat_set<uint64> _sizesRequested;
+	mutable int _sizesGeneration = 0;
 
 };
 
@@ -719,6 +766,11 @@ void clearStorageImages();
 void clearAllImages();
 int64 imageCacheSize();
 
+// Pixmaps cached outside of Image objects are counted as well,
+// so that App::checkImageCacheSize() takes them into account.
+void acquireImageCacheMemory(int64 size);
+void releaseImageCacheMemory(int64 size);
+
 class PsFileBookmark;
 class ReadAccessEnabler {
 public:
@@ -511,7 +511,8 @@ void UserpicButton::openPeerPhoto() {
 void UserpicButton::setupPeerViewers() {
 	Notify::PeerUpdateViewer(
 		_peer,
-		Notify::PeerUpdate::Flag::PhotoChanged
+		Notify::PeerUpdate::Flag::PhotoChanged,
+		"Ui::UserpicButton::setupPeerViewers"
 	) | rpl::start_with_next([this] {
 		processNewPeerPhoto();
 		update();
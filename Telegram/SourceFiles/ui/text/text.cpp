@@ -3126,6 +3126,5 @@ void Text::clearFields() {
 Text::~Text() = default;
 
 void emojiDraw(QPainter &p, EmojiPtr e, int x, int y) {
-	auto size = Ui::Emoji::Size();
-	p.drawPixmap(QPoint(x, y), App::emoji(), QRect(e->x() * size, e->y() * size, size, size));
+	Ui::Emoji::Draw(p, e, Ui::Emoji::Size(), x, y);
 }
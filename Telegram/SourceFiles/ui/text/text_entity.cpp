@@ -7,6 +7,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "ui/text/text_entity.h"
 
+#include "ui/text/text_forward_matcher.h"
 #include "auth_session.h"
 #include "lang/lang_tag.h"
 
@@ -1594,6 +1595,41 @@ void ParseEntities(TextWithEntities &result, int32 flags, bool rich) {
 	int32 len = result.text.size(), commandOffset = rich ? 0 : len;
 	bool inLink = false, commandIsLink = false;
 	const QChar *start = result.text.constData(), *end = start + result.text.size();
+
+	// Each expression requires some char to be present in the text,
+	// so we check them all at once and skip what can't be matched.
+	auto hasDot = false;
+	auto hasColon = false;
+	auto hasHash = false;
+	auto hasAt = false;
+	auto hasSlash = false;
+	for (auto ch = start; ch != end; ++ch) {
+		switch (ch->unicode()) {
+		case '.': hasDot = true; break;
+		case ':': hasColon = true; break;
+		case '#': hasHash = true; break;
+		case '@': hasAt = true; break;
+		case '/': hasSlash = true; break;
+		}
+	}
+	auto domains = ForwardMatcher(RegExpDomain(), result.text, hasDot);
+	auto explicitDomains = ForwardMatcher(
+		RegExpDomainExplicit(),
+		result.text,
+		hasColon);
+	auto hashtags = ForwardMatcher(
+		RegExpHashtag(),
+		result.text,
+		withHashtags && hasHash);
+	auto mentions = ForwardMatcher(
+		RegExpMention(),
+		result.text,
+		withMentions && hasAt);
+	auto botCommands = ForwardMatcher(
+		RegExpBotCommand(),
+		result.text,
+		withBotCommands && hasSlash);
+
 	for (int32 offset = 0, matchOffset = offset, mentionSkip = 0; offset < len;) {
 		if (commandOffset <= offset) {
 			for (commandOffset = offset; commandOffset < len; ++commandOffset) {
@@ -1604,11 +1640,11 @@ void ParseEntities(TextWithEntities &result, int32 flags, bool rich) {
 				}
 			}
 		}
-		auto mDomain = RegExpDomain().match(result.text, matchOffset);
-		auto mExplicitDomain = RegExpDomainExplicit().match(result.text, matchOffset);
-		auto mHashtag = withHashtags ? RegExpHashtag().match(result.text, matchOffset) : QRegularExpressionMatch();
-		auto mMention = withMentions ? RegExpMention().match(result.text, qMax(mentionSkip, matchOffset)) : QRegularExpressionMatch();
-		auto mBotCommand = withBotCommands ? RegExpBotCommand().match(result.text, matchOffset) : QRegularExpressionMatch();
+		auto mDomain = domains.match(matchOffset);
+		auto mExplicitDomain = explicitDomains.match(matchOffset);
+		auto mHashtag = hashtags.match(matchOffset);
+		auto mMention = mentions.match(qMax(mentionSkip, matchOffset));
+		auto mBotCommand = botCommands.match(matchOffset);
 
 		EntityInTextType lnkType = EntityInTextUrl;
 		int32 lnkStart = 0, lnkLength = 0;
@@ -1648,7 +1684,7 @@ void ParseEntities(TextWithEntities &result, int32 flags, bool rich) {
 			}
 			if (!(start + mentionStart + 1)->isLetter() || !(start + mentionEnd - 1)->isLetterOrNumber()) {
 				mentionSkip = mentionEnd;
-				mMention = RegExpMention().match(result.text, qMax(mentionSkip, matchOffset));
+				mMention = mentions.match(qMax(mentionSkip, matchOffset));
 				if (mMention.hasMatch()) {
 					mentionStart = mMention.capturedStart();
 					mentionEnd = mMention.capturedEnd();
@@ -0,0 +1,55 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <QtCore/QRegularExpression>
+
+namespace TextUtilities {
+
+// Finds the first match of the expression starting not before an offset.
+//
+// The match at some position doesn't depend on the offset the search
+// started from, so a match found earlier is the answer while it starts
+// after the requested offset and the offset didn't move back. The same way
+// if nothing was found from some offset nothing will be found after it.
+class ForwardMatcher {
+public:
+	ForwardMatcher(
+		const QRegularExpression &expression,
+		const QString &text,
+		bool enabled)
+	: _expression(expression)
+	, _text(text)
+	, _enabled(enabled) {
+	}
+
+	QRegularExpressionMatch match(int offset) {
+		if (!_enabled) {
+			return _match;
+		}
+		const auto searched = (_offset >= 0);
+		const auto movedBack = (offset < _offset);
+		const auto passed = _match.hasMatch()
+			&& (_match.capturedStart() < offset);
+		if (!searched || movedBack || passed) {
+			_match = _expression.match(_text, offset);
+			_offset = offset;
+		}
+		return _match;
+	}
+
+private:
+	const QRegularExpression &_expression;
+	const QString &_text;
+	QRegularExpressionMatch _match;
+	int _offset = -1;
+	bool _enabled = false;
+
+};
+
+} // namespace TextUtilities
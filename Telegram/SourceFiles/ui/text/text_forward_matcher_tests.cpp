@@ -0,0 +1,188 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "ui/text/text_forward_matcher.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+using TextUtilities::ForwardMatcher;
+
+namespace {
+
+QString RandomText(std::mt19937 &generator, int length) {
+	const auto alphabet = QString::fromLatin1("ab1#@/. _x:");
+	auto result = QString();
+	result.reserve(length);
+	for (auto i = 0; i != length; ++i) {
+		result.push_back(alphabet[int(generator() % alphabet.size())]);
+	}
+	return result;
+}
+
+// Words with a few entities, like in the usual chat messages.
+QString RandomMessage(std::mt19937 &generator) {
+	const auto words = {
+		QStringLiteral("hello"),
+		QStringLiteral("there"),
+		QStringLiteral("what"),
+		QStringLiteral("about"),
+		QStringLiteral("tomorrow"),
+		QStringLiteral("meeting"),
+		QStringLiteral("ok"),
+		QStringLiteral("#release"),
+		QStringLiteral("@someone"),
+		QStringLiteral("telegram.org"),
+		QStringLiteral("/start"),
+	};
+	const auto count = 5 + int(generator() % 40);
+	auto result = QString();
+	for (auto i = 0; i != count; ++i) {
+		result.append(*(words.begin() + (generator() % words.size())));
+		result.append(QChar(' '));
+	}
+	return result;
+}
+
+// Finds entities the way TextUtilities::ParseEntities does: all the
+// expressions are matched from the offset after the previous entity.
+template <typename Match>
+int CountEntities(const QString &text, int expressionsCount, Match match) {
+	auto result = 0;
+	for (auto offset = 0; offset < text.size();) {
+		auto found = QRegularExpressionMatch();
+		for (auto i = 0; i != expressionsCount; ++i) {
+			const auto m = match(i, offset);
+			if (m.hasMatch()
+				&& (!found.hasMatch()
+					|| m.capturedStart() < found.capturedStart())) {
+				found = m;
+			}
+		}
+		if (!found.hasMatch()) {
+			break;
+		}
+		++result;
+		offset = std::max(found.capturedEnd(), offset + 1);
+	}
+	return result;
+}
+
+bool SameMatch(
+		const QRegularExpressionMatch &a,
+		const QRegularExpressionMatch &b) {
+	if (a.hasMatch() != b.hasMatch()) {
+		return false;
+	}
+	return !a.hasMatch()
+		|| (a.capturedStart() == b.capturedStart()
+			&& a.capturedEnd() == b.capturedEnd());
+}
+
+} // namespace
+
+TEST_CASE("forward matcher returns the cached match", "[forward_matcher]") {
+	const auto expression = QRegularExpression(QStringLiteral("#[a-z]+"));
+	const auto text = QString::fromLatin1("one #two three #four");
+	auto matcher = ForwardMatcher(expression, text, true);
+
+	REQUIRE(matcher.match(0).capturedStart() == 4);
+	REQUIRE(matcher.match(4).capturedStart() == 4);
+	REQUIRE(matcher.match(5).capturedStart() == 15);
+	REQUIRE(!matcher.match(16).hasMatch());
+
+	SECTION("offset moved back finds the earlier match again") {
+		REQUIRE(matcher.match(2).capturedStart() == 4);
+	}
+
+	SECTION("disabled matcher finds nothing") {
+		auto disabled = ForwardMatcher(expression, text, false);
+		REQUIRE(!disabled.match(0).hasMatch());
+	}
+}
+
+TEST_CASE("forward matcher matches uncached search", "[forward_matcher]") {
+	const auto expressions = {
+		QRegularExpression(QStringLiteral("(^|[^a-z0-9_])#[a-z0-9_]+")),
+		QRegularExpression(QStringLiteral("(?<![a-z0-9_])@[a-z0-9_]{2,}")),
+		QRegularExpression(QStringLiteral("(?<![\\w/])/[a-z]+(@[a-z]+)?")),
+		QRegularExpression(QStringLiteral("(?<![\\w\\.])(?:[a-z0-9]+\\.){1,3}[a-z]{2,}")),
+	};
+	auto generator = std::mt19937(239);
+	for (auto iteration = 0; iteration != 500; ++iteration) {
+		const auto text = RandomText(generator, 1 + (generator() % 200));
+		for (const auto &expression : expressions) {
+			auto matcher = ForwardMatcher(expression, text, true);
+			auto offset = 0;
+			for (auto step = 0; step != 100; ++step) {
+				if (generator() % 5) {
+					offset += int(generator() % 8);
+				} else {
+					// The entities parser may go back to a command offset.
+					offset -= int(generator() % 16);
+				}
+				offset = std::clamp(offset, 0, text.size());
+				const auto expected = expression.match(text, offset);
+				REQUIRE(SameMatch(matcher.match(offset), expected));
+			}
+		}
+	}
+}
+
+TEST_CASE("forward matcher parsing benchmark", "[forward_matcher]") {
+	const auto expressions = std::vector<QRegularExpression>{
+		QRegularExpression(QStringLiteral("(^|[^a-z0-9_])#[a-z0-9_]+")),
+		QRegularExpression(QStringLiteral("(?<![a-z0-9_])@[a-z0-9_]{2,}")),
+		QRegularExpression(QStringLiteral("(?<![\\w/])/[a-z]+(@[a-z]+)?")),
+		QRegularExpression(QStringLiteral("(?<![\\w\\.])(?:[a-z0-9]+\\.){1,3}[a-z]{2,}")),
+	};
+	const auto count = int(expressions.size());
+	auto generator = std::mt19937(239);
+	auto messages = std::vector<QString>();
+	for (auto i = 0; i != 2000; ++i) {
+		messages.push_back(RandomMessage(generator));
+	}
+
+	using Clock = std::chrono::steady_clock;
+	auto uncachedCounts = std::vector<int>();
+	const auto uncachedStart = Clock::now();
+	for (const auto &text : messages) {
+		const auto match = [&](int index, int offset) {
+			return expressions[index].match(text, offset);
+		};
+		uncachedCounts.push_back(CountEntities(text, count, match));
+	}
+	const auto uncachedTime = Clock::now() - uncachedStart;
+
+	auto cachedCounts = std::vector<int>();
+	const auto cachedStart = Clock::now();
+	for (const auto &text : messages) {
+		auto matchers = std::vector<ForwardMatcher>();
+		matchers.reserve(expressions.size());
+		for (const auto &expression : expressions) {
+			matchers.emplace_back(expression, text, true);
+		}
+		const auto match = [&](int index, int offset) {
+			return matchers[index].match(offset);
+		};
+		cachedCounts.push_back(CountEntities(text, count, match));
+	}
+	const auto cachedTime = Clock::now() - cachedStart;
+
+	REQUIRE(cachedCounts == uncachedCounts);
+
+	const auto perSecond = [&](Clock::duration duration) {
+		using namespace std::chrono;
+		const auto us = duration_cast<microseconds>(duration).count();
+		return int64_t(messages.size()) * 1000000 / std::max(us, decltype(us)(1));
+	};
+	WARN("Entities parsing: "
+		<< perSecond(uncachedTime) << " messages/sec uncached, "
+		<< perSecond(cachedTime) << " messages/sec with ForwardMatcher.");
+}
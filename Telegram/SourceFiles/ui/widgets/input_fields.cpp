@@ -7,6 +7,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "ui/widgets/input_fields.h"
 
+#include "ui/widgets/input_fields_text_cache.h"
 #include "ui/widgets/popup_menu.h"
 #include "ui/countryinput.h"
 #include "emoji_suggestions_data.h"
@@ -34,19 +35,10 @@ const auto &kTagBold = InputField::kTagBold;
 const auto &kTagItalic = InputField::kTagItalic;
 const auto &kTagCode = InputField::kTagCode;
 const auto &kTagPre = InputField::kTagPre;
-const auto kNewlineChars = QString("\r\n")
-	+ QChar(0xfdd0) // QTextBeginningOfFrame
-	+ QChar(0xfdd1) // QTextEndOfFrame
-	+ QChar(QChar::ParagraphSeparator)
-	+ QChar(QChar::LineSeparator);
 const auto kClearFormatSequence = QKeySequence("ctrl+shift+n");
 const auto kMonospaceSequence = QKeySequence("ctrl+shift+m");
 const auto kEditLinkSequence = QKeySequence("ctrl+k");
 
-bool IsNewline(QChar ch) {
-	return (kNewlineChars.indexOf(ch) >= 0);
-}
-
 QString GetFullSimpleTextTag(const TextWithTags &textWithTags) {
 	const auto &text = textWithTags.text;
 	const auto &tags = textWithTags.tags;
@@ -538,6 +530,13 @@ QTextImageFormat PrepareEmojiFormat(EmojiPtr emoji, const QFont &font) {
 	return result;
 }
 
+QString EmojiText(const QTextImageFormat &format) {
+	if (const auto emoji = Ui::Emoji::FromUrl(format.name())) {
+		return emoji->text();
+	}
+	return QString();
+}
+
 // Optimization: with null page size document does not re-layout
 // on each insertText / mergeCharFormat.
 void PrepareFormattingOptimization(not_null<QTextDocument*> document) {
@@ -1310,6 +1309,7 @@ void InputField::setMarkdownReplacesEnabled(rpl::producer<bool> enabled) {
 				handleContentsChanged();
 			} else {
 				_lastMarkdownTags = {};
+				_markdownTagsOutdated = false;
 			}
 		}
 	}, lifetime());
@@ -1716,14 +1716,15 @@ QString InputField::getTextPart(
 		start = 0;
 	}
 	const auto full = (start == 0 && end < 0);
+	if (full) {
+		return getFullText(outTagsList, outTagsChanged, outMarkdownTags);
+	}
 
 	auto lastTag = QString();
 	TagAccumulator tagAccumulator(outTagsList);
-	MarkdownTagAccumulator markdownTagAccumulator(outMarkdownTags);
-	const auto newline = outMarkdownTags ? QString(1, '\n') : QString();
 
 	const auto document = _inner->document();
-	const auto from = full ? document->begin() : document->findBlock(start);
+	const auto from = document->findBlock(start);
 	auto till = (end < 0) ? document->end() : document->findBlock(end);
 	if (till.isValid()) {
 		till = till.next();
@@ -1735,7 +1736,7 @@ QString InputField::getTextPart(
 	}
 	auto result = QString();
 	result.reserve(possibleLength);
-	if (!full && end < 0) {
+	if (end < 0) {
 		end = possibleLength;
 	}
 
@@ -1746,80 +1747,84 @@ QString InputField::getTextPart(
 				continue;
 			}
 
-			const auto fragmentPosition = full ? 0 : fragment.position();
-			const auto fragmentEnd = full
-				? 0
-				: (fragmentPosition + fragment.length());
+			const auto fragmentPosition = fragment.position();
+			const auto fragmentEnd = fragmentPosition + fragment.length();
 			const auto format = fragment.charFormat();
-			if (!full) {
-				if (fragmentPosition == end) {
-					tagAccumulator.feed(
-						format.property(kTagProperty).toString(),
-						result.size());
-					break;
-				} else if (fragmentPosition > end) {
-					break;
-				} else if (fragmentEnd <= start) {
-					continue;
-				}
+			if (fragmentPosition == end) {
+				tagAccumulator.feed(
+					format.property(kTagProperty).toString(),
+					result.size());
+				break;
+			} else if (fragmentPosition > end) {
+				break;
+			} else if (fragmentEnd <= start) {
+				continue;
 			}
 
-			const auto emojiText = [&] {
-				if (format.isImageFormat()) {
-					const auto imageName = format.toImageFormat().name();
-					if (const auto emoji = Ui::Emoji::FromUrl(imageName)) {
-						return emoji->text();
-					}
-				}
-				return QString();
-			}();
 			auto text = [&] {
 				const auto result = fragment.text();
-				if (!full) {
-					if (fragmentPosition < start) {
-						return result.mid(start - fragmentPosition, end - start);
-					} else if (fragmentEnd > end) {
-						return result.mid(0, end - fragmentPosition);
-					}
+				if (fragmentPosition < start) {
+					return result.mid(start - fragmentPosition, end - start);
+				} else if (fragmentEnd > end) {
+					return result.mid(0, end - fragmentPosition);
 				}
 				return result;
 			}();
 
-			if (full || !text.isEmpty()) {
+			if (!text.isEmpty()) {
 				lastTag = format.property(kTagProperty).toString();
 				tagAccumulator.feed(lastTag, result.size());
 			}
+			AppendFragmentText(result, text, format, EmojiText);
+		}
 
-			auto begin = text.data();
-			auto ch = begin;
-			auto adjustedLength = text.size();
-			for (const auto end = begin + text.size(); ch != end; ++ch) {
-				if (IsNewline(*ch) && ch->unicode() != '\r') {
-					*ch = QLatin1Char('\n');
-				} else switch (ch->unicode()) {
-				case QChar::Nbsp: {
-					*ch = QLatin1Char(' ');
-				} break;
-				case QChar::ObjectReplacementCharacter: {
-					if (ch > begin) {
-						result.append(begin, ch - begin);
-					}
-					adjustedLength += (emojiText.size() - 1);
-					if (!emojiText.isEmpty()) {
-						result.append(emojiText);
-					}
-					begin = ch + 1;
-				} break;
-				}
-			}
-			if (ch > begin) {
-				result.append(begin, ch - begin);
-			}
+		block = block.next();
+		if (block != till) {
+			result.append('\n');
+		}
+	}
 
-			if (full || !text.isEmpty()) {
-				markdownTagAccumulator.feed(text, adjustedLength, lastTag);
-			}
+	tagAccumulator.feed(QString(), result.size());
+	tagAccumulator.finish();
+
+	outTagsChanged = tagAccumulator.changed();
+	return result;
+}
+
+QString InputField::getFullText(
+		TagList &outTagsList,
+		bool &outTagsChanged,
+		std::vector<MarkdownTag> *outMarkdownTags) const {
+	auto lastTag = QString();
+	TagAccumulator tagAccumulator(outTagsList);
+	MarkdownTagAccumulator markdownTagAccumulator(outMarkdownTags);
+	const auto newline = outMarkdownTags ? QString(1, '\n') : QString();
+
+	const auto document = _inner->document();
+	const auto from = document->begin();
+	const auto till = document->end();
+
+	auto possibleLength = 0;
+	for (auto block = from; block != till; block = block.next()) {
+		possibleLength += block.length();
+	}
+	auto result = QString();
+	result.reserve(possibleLength);
+
+	for (auto block = from; block != till;) {
+		const auto &cache = ComputeBlockTextCache(
+			block,
+			kTagProperty,
+			EmojiText);
+		for (const auto &fragment : cache.fragments) {
+			lastTag = fragment.tag;
+			tagAccumulator.feed(lastTag, result.size() + fragment.offset);
+			markdownTagAccumulator.feed(
+				fragment.text,
+				fragment.adjustedLength,
+				lastTag);
 		}
+		result.append(cache.text);
 
 		block = block.next();
 		if (block != till) {
@@ -1836,6 +1841,30 @@ QString InputField::getTextPart(
 	return result;
 }
 
+void InputField::clearTextCache(int position, int length) {
+	const auto document = _inner->document();
+	const auto till = document->findBlock(position + length);
+	for (auto block = document->findBlock(position)
+		; block.isValid()
+		; block = block.next()) {
+		block.setUserData(nullptr);
+		if (block == till) {
+			break;
+		}
+	}
+}
+
+const std::vector<InputField::MarkdownTag> &InputField::getMarkdownTags() const {
+	if (_markdownTagsOutdated) {
+		_markdownTagsOutdated = false;
+
+		auto tags = TagList();
+		auto changed = false;
+		getFullText(tags, changed, &_lastMarkdownTags);
+	}
+	return _lastMarkdownTags;
+}
+
 bool InputField::isUndoAvailable() const {
 	return _undoAvailable;
 }
@@ -2055,6 +2084,9 @@ void InputField::onDocumentContentsChange(
 		int position,
 		int charsRemoved,
 		int charsAdded) {
+	// Formatting corrections change the document as well.
+	clearTextCache(position, charsAdded);
+
 	if (_correcting) {
 		return;
 	}
@@ -2118,11 +2150,11 @@ void InputField::chopByMaxLength(int insertPosition, int insertLength) {
 		return;
 	}
 
-	auto cursor = QTextCursor(document()->docHandle(), 0);
-	cursor.movePosition(QTextCursor::End);
-	const auto fullSize = cursor.position();
+	// Without the last paragraph separator, like QTextCursor::End.
+	const auto fullSize = document()->characterCount() - 1;
 	const auto toRemove = fullSize - _maxLength;
 	if (toRemove > 0) {
+		auto cursor = QTextCursor(document()->docHandle(), 0);
 		if (toRemove > insertLength) {
 			if (insertLength) {
 				cursor.setPosition(insertPosition);
@@ -2148,13 +2180,14 @@ void InputField::chopByMaxLength(int insertPosition, int insertLength) {
 void InputField::handleContentsChanged() {
 	setErrorShown(false);
 
+	// Markdown tags are parsed only when they are requested.
 	auto tagsChanged = false;
 	const auto currentText = getTextPart(
 		0,
 		-1,
 		_lastTextWithTags.tags,
-		tagsChanged,
-		_markdownEnabled ? &_lastMarkdownTags : nullptr);
+		tagsChanged);
+	_markdownTagsOutdated = _markdownEnabled;
 
 	//highlightMarkdown();
 
@@ -2180,7 +2213,7 @@ void InputField::highlightMarkdown() {
 		cursor.mergeCharFormat(format);
 		from = b;
 	};
-	for (const auto &tag : _lastMarkdownTags) {
+	for (const auto &tag : getMarkdownTags()) {
 		if (tag.internalStart > from) {
 			applyColor(from, tag.internalStart, QColor(0, 0, 0));
 		} else if (tag.internalStart < from) {
@@ -2350,7 +2383,8 @@ TextWithTags InputField::getTextWithTagsPart(int start, int end) const {
 }
 
 TextWithTags InputField::getTextWithAppliedMarkdown() const {
-	if (!_markdownEnabled || _lastMarkdownTags.empty()) {
+	const auto &markdownTags = getMarkdownTags();
+	if (!_markdownEnabled || markdownTags.empty()) {
 		return getTextWithTags();
 	}
 	const auto &originalText = _lastTextWithTags.text;
@@ -2364,7 +2398,7 @@ TextWithTags InputField::getTextWithAppliedMarkdown() const {
 
 	auto result = TextWithTags();
 	result.text.reserve(originalText.size());
-	result.tags.reserve(originalTags.size() + _lastMarkdownTags.size());
+	result.tags.reserve(originalTags.size() + markdownTags.size());
 	auto removed = 0;
 	auto originalTag = originalTags.begin();
 	const auto originalTagsEnd = originalTags.end();
@@ -2383,7 +2417,7 @@ TextWithTags InputField::getTextWithAppliedMarkdown() const {
 	};
 	auto link = links.begin();
 	const auto linksEnd = links.end();
-	for (const auto &tag : _lastMarkdownTags) {
+	for (const auto &tag : markdownTags) {
 		const auto tagLength = int(tag.tag.size());
 		if (!tag.closed || tag.adjustedStart < from) {
 			continue;
@@ -2806,7 +2840,7 @@ void InputField::processInstantReplaces(const QString &appended) {
 		return;
 	}
 	const auto position = textCursor().position();
-	for (const auto &tag : _lastMarkdownTags) {
+	for (const auto &tag : getMarkdownTags()) {
 		if (tag.internalStart < position
 			&& tag.internalStart + tag.internalLength >= position
 			&& (tag.tag == kTagCode || tag.tag == kTagPre)) {
@@ -168,9 +168,7 @@ public:
 	const TextWithTags &getTextWithTags() const {
 		return _lastTextWithTags;
 	}
-	const std::vector<MarkdownTag> &getMarkdownTags() const {
-		return _lastMarkdownTags;
-	}
+	const std::vector<MarkdownTag> &getMarkdownTags() const;
 	TextWithTags getTextWithTagsPart(int start, int end = -1) const;
 	TextWithTags getTextWithAppliedMarkdown() const;
 	void insertTag(const QString &text, QString tagId = QString());
@@ -368,6 +366,14 @@ private:
 		bool &outTagsChanged,
 		std::vector<MarkdownTag> *outMarkdownTags = nullptr) const;
 
+	// Full text is built from the serialized blocks cached in their
+	// user data, so only the blocks changed after the last call are read.
+	QString getFullText(
+		TagList &outTagsList,
+		bool &outTagsChanged,
+		std::vector<MarkdownTag> *outMarkdownTags) const;
+	void clearTextCache(int position, int length);
+
 	// After any characters added we must postprocess them. This includes:
 	// 1. Replacing font family to semibold for ~ characters, if we used Open Sans 13px.
 	// 2. Replacing font family from semibold for all non-~ characters, if we used ...
@@ -418,7 +424,8 @@ private:
 	const std::unique_ptr<Inner> _inner;
 
 	TextWithTags _lastTextWithTags;
-	std::vector<MarkdownTag> _lastMarkdownTags;
+	mutable std::vector<MarkdownTag> _lastMarkdownTags;
+	mutable bool _markdownTagsOutdated = false;
 	QString _lastPreEditText;
 	Fn<bool(
 		EditLinkSelection selection,
@@ -0,0 +1,121 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <QtGui/QTextBlock>
+#include <QtGui/QTextDocument>
+#include <vector>
+
+namespace Ui {
+
+inline bool IsNewline(QChar ch) {
+	switch (ch.unicode()) {
+	case '\r':
+	case '\n':
+	case 0xfdd0: // QTextBeginningOfFrame
+	case 0xfdd1: // QTextEndOfFrame
+	case QChar::ParagraphSeparator:
+	case QChar::LineSeparator: return true;
+	}
+	return false;
+}
+
+// Serialized text of one QTextBlock, kept in the block user data.
+// It is dropped by InputField::clearTextCache() when the block is changed.
+class BlockTextCache final : public QTextBlockUserData {
+public:
+	struct Fragment {
+		QString tag;
+		int offset = 0; // In the serialized block text.
+
+		// With each emoji being QChar::ObjectReplacementCharacter.
+		QString text;
+		int adjustedLength = 0;
+	};
+
+	QString text;
+	std::vector<Fragment> fragments;
+
+};
+
+// Normalizes newlines and spaces in the fragment text in place and
+// appends it to the result with emoji replaced by emojiText(format).
+// Returns the fragment text length adjusted by emoji.
+template <typename EmojiText>
+int AppendFragmentText(
+		QString &result,
+		QString &text,
+		const QTextCharFormat &format,
+		EmojiText &&emojiText) {
+	const auto replacement = format.isImageFormat()
+		? emojiText(format.toImageFormat())
+		: QString();
+
+	auto begin = text.data();
+	auto ch = begin;
+	auto adjustedLength = text.size();
+	for (const auto end = begin + text.size(); ch != end; ++ch) {
+		if (IsNewline(*ch) && ch->unicode() != '\r') {
+			*ch = QLatin1Char('\n');
+		} else switch (ch->unicode()) {
+		case QChar::Nbsp: {
+			*ch = QLatin1Char(' ');
+		} break;
+		case QChar::ObjectReplacementCharacter: {
+			if (ch > begin) {
+				result.append(begin, ch - begin);
+			}
+			adjustedLength += (replacement.size() - 1);
+			if (!replacement.isEmpty()) {
+				result.append(replacement);
+			}
+			begin = ch + 1;
+		} break;
+		}
+	}
+	if (ch > begin) {
+		result.append(begin, ch - begin);
+	}
+	return adjustedLength;
+}
+
+// Fragment tags are read from the tagProperty of their char formats.
+template <typename EmojiText>
+const BlockTextCache &ComputeBlockTextCache(
+		QTextBlock block,
+		int tagProperty,
+		EmojiText &&emojiText) {
+	if (const auto cached = block.userData()) {
+		return *static_cast<const BlockTextCache*>(cached);
+	}
+	auto result = new BlockTextCache();
+	result->text.reserve(block.length());
+	for (auto item = block.begin(); !item.atEnd(); ++item) {
+		const auto fragment = item.fragment();
+		if (!fragment.isValid()) {
+			continue;
+		}
+		const auto format = fragment.charFormat();
+		auto cached = BlockTextCache::Fragment();
+		cached.tag = format.property(tagProperty).toString();
+		cached.offset = result->text.size();
+		cached.text = fragment.text();
+		cached.adjustedLength = AppendFragmentText(
+			result->text,
+			cached.text,
+			format,
+			emojiText);
+		result->fragments.push_back(std::move(cached));
+	}
+
+	// Block takes ownership of the user data.
+	block.setUserData(result);
+	return *result;
+}
+
+} // namespace Ui
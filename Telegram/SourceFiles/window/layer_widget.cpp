@@ -840,7 +840,8 @@ void MediaPreviewWidget::paintEvent(QPaintEvent *e) {
 		auto emojiLeft = (width() - emojiWidth) / 2;
 		auto esize = Ui::Emoji::Size(Ui::Emoji::Index() + 1);
 		for (auto emoji : _emojiList) {
-			p.drawPixmapLeft(emojiLeft, (height() - h) / 2 - (_emojiSize * 2), width(), App::emojiLarge(), QRect(emoji->x() * esize, emoji->y() * esize, esize, esize));
+			auto x = rtl() ? (width() - emojiLeft - (esize / cIntRetinaFactor())) : emojiLeft;
+			Ui::Emoji::Draw(p, emoji, esize, x, (height() - h) / 2 - (_emojiSize * 2));
 			emojiLeft += _emojiSize + st::stickerEmojiSkip;
 		}
 	}
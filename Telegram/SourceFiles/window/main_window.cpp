@@ -273,6 +273,7 @@ void MainWindow::init() {
 
 void MainWindow::handleStateChanged(Qt::WindowState state) {
 	stateChangedHook(state);
+	anim::WindowsVisibilityChanged();
 	updateIsActive((state == Qt::WindowMinimized) ? Global::OfflineBlurTimeout() : Global::OnlineFocusTimeout());
 	psUserActionDone();
 	if (state == Qt::WindowMinimized && Global::WorkMode().value() == dbiwmTrayOnly) {
@@ -282,6 +283,7 @@ void MainWindow::handleStateChanged(Qt::WindowState state) {
 }
 
 void MainWindow::handleActiveChanged() {
+	anim::WindowsVisibilityChanged();
 	if (isActiveWindow()) {
 		Messenger::Instance().checkMediaViewActivation();
 	}
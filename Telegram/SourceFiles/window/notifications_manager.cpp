@@ -30,6 +30,9 @@ namespace {
 // not more than one sound in 500ms from one peer - grouping
 constexpr auto kMinimalAlertDelay = TimeMs(500);
 
+// not more than one notification from a burst in one peer
+constexpr auto kCoalesceBurstCount = 3;
+
 } // namespace
 
 System::System(AuthSession *session) : _authSession(session) {
@@ -105,17 +108,23 @@ void System::schedule(History *history, HistoryItem *item) {
 	}
 
 	auto when = ms + delay;
-	_whenAlerts[history].insert(when, notifyBy);
+	auto &bucket = _buckets[history];
+	bucket.alerts[when] = notifyBy;
+	queueAlert(history, bucket);
 	if (Global::DesktopNotify() && !Platform::Notifications::SkipToast()) {
-		auto &whenMap = _whenMaps[history];
-		if (whenMap.constFind(item->id) == whenMap.cend()) {
-			whenMap.insert(item->id, when);
-		}
+		bucket.pending.emplace(item->id, Pending{ when, ms });
 
-		auto &addTo = haveSetting ? _waiters : _settingWaiters;
-		auto it = addTo.constFind(history);
-		if (it == addTo.cend() || it->when > when) {
-			addTo.insert(history, Waiter(item->id, when, notifyBy));
+		if (haveSetting) {
+			if (!bucket.waiting || bucket.waiter.when > when) {
+				setWaiter(history, bucket, Waiter(item->id, when, notifyBy));
+			}
+		} else {
+			auto i = _settingWaiters.find(history);
+			if (i == _settingWaiters.end()) {
+				_settingWaiters.emplace(history, Waiter(item->id, when, notifyBy));
+			} else if (i->second.when > when) {
+				i->second = Waiter(item->id, when, notifyBy);
+			}
 		}
 	}
 	if (haveSetting) {
@@ -128,22 +137,22 @@ void System::schedule(History *history, HistoryItem *item) {
 void System::clearAll() {
 	_manager->clearAll();
 
-	for (auto i = _whenMaps.cbegin(), e = _whenMaps.cend(); i != e; ++i) {
-		i.key()->clearNotifications();
+	for (const auto &[history, bucket] : _buckets) {
+		if (!bucket.pending.empty()) {
+			history->clearNotifications();
+		}
 	}
-	_whenMaps.clear();
-	_whenAlerts.clear();
-	_waiters.clear();
+	_buckets.clear();
 	_settingWaiters.clear();
+	_waiters.clear();
+	_alerts.clear();
 }
 
 void System::clearFromHistory(History *history) {
 	_manager->clearFromHistory(history);
 
 	history->clearNotifications();
-	_whenMaps.remove(history);
-	_whenAlerts.remove(history);
-	_waiters.remove(history);
+	removeBucket(history);
 	_settingWaiters.remove(history);
 
 	_waitTimer.stop();
@@ -157,22 +166,22 @@ void System::clearFromItem(HistoryItem *item) {
 void System::clearAllFast() {
 	_manager->clearAllFast();
 
-	_whenMaps.clear();
-	_whenAlerts.clear();
-	_waiters.clear();
+	_buckets.clear();
 	_settingWaiters.clear();
+	_waiters.clear();
+	_alerts.clear();
 }
 
 void System::checkDelayed() {
 	for (auto i = _settingWaiters.begin(); i != _settingWaiters.end();) {
-		const auto history = i.key();
+		const auto history = i->first;
 		const auto peer = history->peer;
 		auto loaded = false;
 		auto muted = false;
 		if (!Auth().data().notifyMuteUnknown(peer)) {
 			if (!Auth().data().notifyIsMuted(peer)) {
 				loaded = true;
-			} else if (const auto from = i.value().notifyBy) {
+			} else if (const auto from = i->second.notifyBy) {
 				if (!Auth().data().notifyMuteUnknown(from)) {
 					if (!Auth().data().notifyIsMuted(from)) {
 						loaded = true;
@@ -187,7 +196,7 @@ void System::checkDelayed() {
 		if (loaded) {
 			const auto fullId = FullMsgId(
 				history->channelId(),
-				i.value().msg);
+				i->second.msg);
 			if (const auto item = App::histItemById(fullId)) {
 				if (!item->notificationReady()) {
 					loaded = false;
@@ -198,7 +207,7 @@ void System::checkDelayed() {
 		}
 		if (loaded) {
 			if (!muted) {
-				_waiters.insert(i.key(), i.value());
+				setWaiter(history, _buckets[history], i->second);
 			}
 			i = _settingWaiters.erase(i);
 		} else {
@@ -209,41 +218,236 @@ void System::checkDelayed() {
 	showNext();
 }
 
-void System::showNext() {
-	if (App::quitting()) return;
+void System::setWaiter(
+		History *history,
+		Bucket &bucket,
+		const Waiter &waiter) {
+	if (bucket.waiting) {
+		_waiters.erase({ bucket.waiter.when, history });
+	}
+	bucket.waiter = waiter;
+	bucket.waiting = true;
+	_waiters.emplace(waiter.when, history);
+}
+
+void System::removeWaiter(History *history, Bucket &bucket) {
+	if (bucket.waiting) {
+		_waiters.erase({ bucket.waiter.when, history });
+		bucket.waiting = false;
+	}
+}
+
+void System::queueAlert(History *history, Bucket &bucket) {
+	const auto when = bucket.alerts.empty()
+		? TimeMs(0)
+		: bucket.alerts.begin()->first;
+	if (bucket.alertQueued == when) {
+		return;
+	} else if (bucket.alertQueued) {
+		_alerts.erase({ bucket.alertQueued, history });
+	}
+	bucket.alertQueued = when;
+	if (when) {
+		_alerts.emplace(when, history);
+	}
+}
+
+void System::removeBucket(History *history) {
+	const auto i = _buckets.find(history);
+	if (i == _buckets.end()) {
+		return;
+	}
+	removeWaiter(history, i->second);
+	if (i->second.alertQueued) {
+		_alerts.erase({ i->second.alertQueued, history });
+	}
+	_buckets.erase(i);
+}
+
+void System::removeBucketIfEmpty(History *history) {
+	const auto i = _buckets.find(history);
+	if (i != _buckets.end()
+		&& i->second.pending.empty()
+		&& i->second.alerts.empty()
+		&& !i->second.waiting) {
+		removeBucket(history);
+	}
+}
 
-	auto ms = getms(true), nextAlert = 0LL;
-	bool alert = false;
-	int32 now = unixtime();
-	for (auto i = _whenAlerts.begin(); i != _whenAlerts.end();) {
-		while (!i.value().isEmpty() && i.value().begin().key() <= ms) {
-			const auto peer = i.key()->peer;
+bool System::showAlerts(TimeMs ms) {
+	auto result = false;
+	while (!_alerts.empty() && _alerts.begin()->first <= ms) {
+		const auto history = _alerts.begin()->second;
+		auto &bucket = _buckets[history];
+		auto &alerts = bucket.alerts;
+		while (!alerts.empty() && alerts.begin()->first <= ms) {
+			const auto peer = history->peer;
 			const auto peerUnknown = Auth().data().notifyMuteUnknown(peer);
 			const auto peerAlert = !peerUnknown
 				&& !Auth().data().notifyIsMuted(peer);
-			const auto from = i.value().begin().value();
+			const auto from = alerts.begin()->second;
 			const auto fromUnknown = (!from
 				|| Auth().data().notifyMuteUnknown(from));
 			const auto fromAlert = !fromUnknown
 				&& !Auth().data().notifyIsMuted(from);
 			if (peerAlert || fromAlert) {
-				alert = true;
+				result = true;
 			}
-			while (!i.value().isEmpty()
-				&& i.value().begin().key() <= ms + kMinimalAlertDelay) {
-				i.value().erase(i.value().begin());
+
+			// Alerts of a burst in one chat are grouped in one sound.
+			while (!alerts.empty()
+				&& alerts.begin()->first <= ms + kMinimalAlertDelay) {
+				alerts.erase(alerts.begin());
 			}
 		}
-		if (i.value().isEmpty()) {
-			i = _whenAlerts.erase(i);
-		} else {
-			if (!nextAlert || nextAlert > i.value().begin().key()) {
-				nextAlert = i.value().begin().key();
+		queueAlert(history, bucket);
+		removeBucketIfEmpty(history);
+	}
+	return result;
+}
+
+bool System::syncWaiter(History *history, Bucket &bucket) {
+	const auto current = history->currentNotification();
+	if (current && current->id != bucket.waiter.msg) {
+		if (bucket.pending.empty()) {
+			history->clearNotifications();
+			return false;
+		}
+		do {
+			const auto i = bucket.pending.find(
+				history->currentNotification()->id);
+			if (i != bucket.pending.end()) {
+				setWaiter(
+					history,
+					bucket,
+					Waiter(i->first, i->second.when, bucket.waiter.notifyBy));
+				break;
+			}
+			history->skipNotification();
+		} while (history->currentNotification());
+	}
+	return (history->currentNotification() != nullptr);
+}
+
+bool System::coalesceBurst(History *history, Bucket &bucket, TimeMs ms) {
+	if (history->currentNotification()->Has<HistoryMessageForwarded>()) {
+		return false;
+	}
+	const auto due = std::count_if(
+		bucket.pending.begin(),
+		bucket.pending.end(),
+		[&](const auto &pair) { return (pair.second.when <= ms); });
+	if (due < kCoalesceBurstCount) {
+		return false;
+	}
+
+	// Show only the last of many notifications in one chat at once.
+	auto skipped = 0;
+	while (skipped + 1 < due && history->notificationsCount() > 1) {
+		const auto id = history->currentNotification()->id;
+		const auto i = bucket.pending.find(id);
+		if (i != bucket.pending.end()) {
+			if (i->second.when > ms) {
+				break;
+			}
+			bucket.pending.erase(i);
+			++skipped;
+		}
+		history->skipNotification();
+	}
+	bucket.coalesced += skipped;
+	DEBUG_LOG(("Notifications: %1 coalesced in a burst.").arg(skipped));
+	return (skipped > 0);
+}
+
+void System::showWaiter(History *history, Bucket &bucket, TimeMs ms) {
+	const auto notifyItem = history->currentNotification();
+
+	// forwarded notify grouping
+	auto forwardedItem = notifyItem->Has<HistoryMessageForwarded>()
+		? notifyItem
+		: nullptr;
+	auto forwardedCount = 1;
+
+	// The skipped notifications of a burst are counted in the shown one.
+	const auto coalescedCount = base::take(bucket.coalesced);
+
+	if (const auto i = bucket.pending.find(notifyItem->id)
+		; i != bucket.pending.end()) {
+		DEBUG_LOG(("Notifications: shown %1ms after receiving, "
+			"%2ms later than planned."
+			).arg(ms - i->second.scheduled
+			).arg(ms - i->second.when));
+	}
+
+	auto nextNotify = (HistoryItem*)nullptr;
+	do {
+		history->skipNotification();
+		if (!history->hasNotification()) {
+			break;
+		}
+
+		bucket.pending.remove(
+			(forwardedItem ? forwardedItem : notifyItem)->id);
+		do {
+			const auto i = bucket.pending.find(
+				history->currentNotification()->id);
+			if (i != bucket.pending.end()) {
+				nextNotify = history->currentNotification();
+				setWaiter(history, bucket, Waiter(i->first, i->second.when, 0));
+				break;
+			}
+			history->skipNotification();
+		} while (history->hasNotification());
+		if (nextNotify) {
+			if (forwardedItem) {
+				auto nextForwarded = nextNotify->Has<HistoryMessageForwarded>() ? nextNotify : nullptr;
+				if (nextForwarded
+					&& forwardedItem->author() == nextForwarded->author()
+					&& qAbs(int64(nextForwarded->date()) - int64(forwardedItem->date())) < 2) {
+					forwardedItem = nextForwarded;
+					++forwardedCount;
+				} else {
+					nextNotify = nullptr;
+				}
+			} else {
+				nextNotify = nullptr;
 			}
-			++i;
 		}
+	} while (nextNotify);
+
+	if (!history->hasNotification()) {
+		bucket.pending.clear();
+		removeWaiter(history, bucket);
+		removeBucketIfEmpty(history);
+	}
+
+	_manager->showNotification(notifyItem, forwardedCount, coalescedCount);
+}
+
+void System::startWaitTimer(TimeMs ms) {
+	auto next = TimeMs(0);
+	if (!_alerts.empty()) {
+		next = _alerts.begin()->first;
 	}
-	if (alert) {
+	if (!_waiters.empty()
+		&& Global::DesktopNotify()
+		&& !Platform::Notifications::SkipToast()) {
+		const auto when = _waiters.begin()->first;
+		if (!next || next > when) {
+			next = when;
+		}
+	}
+	if (next) {
+		_waitTimer.start(std::max(next - ms, TimeMs(0)));
+	}
+}
+
+void System::showNext() {
+	if (App::quitting()) return;
+
+	const auto ms = getms(true);
+	if (showAlerts(ms)) {
 		Platform::Notifications::FlashBounce();
 		if (Global::SoundNotify() && !Platform::Notifications::SkipAudio()) {
 			ensureSoundCreated();
@@ -253,117 +457,27 @@ void System::showNext() {
 		}
 	}
 
-	if (_waiters.isEmpty() || !Global::DesktopNotify() || Platform::Notifications::SkipToast()) {
-		if (nextAlert) {
-			_waitTimer.start(nextAlert - ms);
-		}
-		return;
-	}
-
-	while (true) {
-		auto next = 0LL;
-		HistoryItem *notifyItem = nullptr;
-		History *notifyHistory = nullptr;
-		for (auto i = _waiters.begin(); i != _waiters.end();) {
-			History *history = i.key();
-			if (history->currentNotification() && history->currentNotification()->id != i.value().msg) {
-				auto j = _whenMaps.find(history);
-				if (j == _whenMaps.end()) {
-					history->clearNotifications();
-					i = _waiters.erase(i);
-					continue;
-				}
-				do {
-					auto k = j.value().constFind(history->currentNotification()->id);
-					if (k != j.value().cend()) {
-						i.value().msg = k.key();
-						i.value().when = k.value();
-						break;
-					}
-					history->skipNotification();
-				} while (history->currentNotification());
-			}
-			if (!history->currentNotification()) {
-				_whenMaps.remove(history);
-				i = _waiters.erase(i);
+	if (Global::DesktopNotify() && !Platform::Notifications::SkipToast()) {
+		while (!_waiters.empty()) {
+			const auto [when, history] = *_waiters.begin();
+			auto &bucket = _buckets[history];
+			if (!syncWaiter(history, bucket)) {
+				bucket.pending.clear();
+				removeWaiter(history, bucket);
+				removeBucketIfEmpty(history);
 				continue;
-			}
-			auto when = i.value().when;
-			if (!notifyItem || next > when) {
-				next = when;
-				notifyItem = history->currentNotification();
-				notifyHistory = history;
-			}
-			++i;
-		}
-		if (notifyItem) {
-			if (next > ms) {
-				if (nextAlert && nextAlert < next) {
-					next = nextAlert;
-					nextAlert = 0;
-				}
-				_waitTimer.start(next - ms);
+			} else if (bucket.waiter.when != when) {
+				// The waiter was moved to the next notification.
+				continue;
+			} else if (when > ms) {
 				break;
-			} else {
-				auto forwardedItem = notifyItem->Has<HistoryMessageForwarded>() ? notifyItem : nullptr; // forwarded notify grouping
-				auto forwardedCount = 1;
-
-				auto ms = getms(true);
-				auto history = notifyItem->history();
-				auto j = _whenMaps.find(history);
-				if (j == _whenMaps.cend()) {
-					history->clearNotifications();
-				} else {
-					auto nextNotify = (HistoryItem*)nullptr;
-					do {
-						history->skipNotification();
-						if (!history->hasNotification()) {
-							break;
-						}
-
-						j.value().remove((forwardedItem ? forwardedItem : notifyItem)->id);
-						do {
-							auto k = j.value().constFind(history->currentNotification()->id);
-							if (k != j.value().cend()) {
-								nextNotify = history->currentNotification();
-								_waiters.insert(notifyHistory, Waiter(k.key(), k.value(), 0));
-								break;
-							}
-							history->skipNotification();
-						} while (history->hasNotification());
-						if (nextNotify) {
-							if (forwardedItem) {
-								auto nextForwarded = nextNotify->Has<HistoryMessageForwarded>() ? nextNotify : nullptr;
-								if (nextForwarded
-									&& forwardedItem->author() == nextForwarded->author()
-									&& qAbs(int64(nextForwarded->date()) - int64(forwardedItem->date())) < 2) {
-									forwardedItem = nextForwarded;
-									++forwardedCount;
-								} else {
-									nextNotify = nullptr;
-								}
-							} else {
-								nextNotify = nullptr;
-							}
-						}
-					} while (nextNotify);
-				}
-
-				_manager->showNotification(notifyItem, forwardedCount);
-
-				if (!history->hasNotification()) {
-					_waiters.remove(history);
-					_whenMaps.remove(history);
-					continue;
-				}
+			} else if (coalesceBurst(history, bucket, ms)) {
+				continue;
 			}
-		} else {
-			break;
+			showWaiter(history, bucket, ms);
 		}
 	}
-	if (nextAlert) {
-		_waitTimer.start(nextAlert - ms);
-	}
+	startWaitTimer(ms);
 }
 
 void System::ensureSoundCreated() {
@@ -454,16 +568,21 @@ void Manager::notificationReplied(
 	Auth().api().sendMessage(std::move(message));
 }
 
-void NativeManager::doShowNotification(HistoryItem *item, int forwardedCount) {
+void NativeManager::doShowNotification(
+		HistoryItem *item,
+		int forwardedCount,
+		int coalescedCount) {
 	const auto options = getNotificationOptions(item);
 
 	const auto title = options.hideNameAndPhoto ? qsl("Bettergram") : item->history()->peer->name;
 	const auto subtitle = options.hideNameAndPhoto ? QString() : item->notificationHeader();
 	const auto text = options.hideMessageText
 		? lang(lng_notification_preview)
-		: (forwardedCount < 2
-			? item->notificationText()
-			: lng_forward_messages(lt_count, forwardedCount));
+		: (forwardedCount > 1)
+		? lng_forward_messages(lt_count, forwardedCount)
+		: (coalescedCount > 0)
+		? lng_notification_messages(lt_count, coalescedCount + 1)
+		: item->notificationText();
 
 	doShowNativeNotification(
 		item->history()->peer,
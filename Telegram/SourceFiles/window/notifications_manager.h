@@ -75,29 +75,54 @@ public:
 	~System();
 
 private:
-	void showNext();
-	void ensureSoundCreated();
-
-	AuthSession *_authSession = nullptr;
-
-	QMap<History*, QMap<MsgId, TimeMs>> _whenMaps;
-
 	struct Waiter {
+		Waiter() = default;
 		Waiter(MsgId msg, TimeMs when, PeerData *notifyBy)
 		: msg(msg)
 		, when(when)
 		, notifyBy(notifyBy) {
 		}
-		MsgId msg;
-		TimeMs when;
-		PeerData *notifyBy;
+		MsgId msg = 0;
+		TimeMs when = 0;
+		PeerData *notifyBy = nullptr;
+	};
+	struct Pending {
+		TimeMs when = 0;
+		TimeMs scheduled = 0;
 	};
-	using Waiters = QMap<History*, Waiter>;
-	Waiters _waiters;
-	Waiters _settingWaiters;
-	SingleTimer _waitTimer;
 
-	QMap<History*, QMap<TimeMs, PeerData*>> _whenAlerts;
+	// All scheduled notifications and alerts of one history. Only the
+	// nearest waiter and alert of each bucket are put in the queues.
+	struct Bucket {
+		base::flat_map<MsgId, Pending> pending;
+		base::flat_map<TimeMs, PeerData*> alerts;
+		Waiter waiter;
+		int coalesced = 0;
+		bool waiting = false;
+		TimeMs alertQueued = 0;
+	};
+	using Queue = std::set<std::pair<TimeMs, History*>>;
+
+	void showNext();
+	bool showAlerts(TimeMs ms);
+	bool syncWaiter(History *history, Bucket &bucket);
+	bool coalesceBurst(History *history, Bucket &bucket, TimeMs ms);
+	void showWaiter(History *history, Bucket &bucket, TimeMs ms);
+	void setWaiter(History *history, Bucket &bucket, const Waiter &waiter);
+	void removeWaiter(History *history, Bucket &bucket);
+	void queueAlert(History *history, Bucket &bucket);
+	void removeBucket(History *history);
+	void removeBucketIfEmpty(History *history);
+	void startWaitTimer(TimeMs ms);
+	void ensureSoundCreated();
+
+	AuthSession *_authSession = nullptr;
+
+	base::flat_map<History*, Bucket> _buckets;
+	base::flat_map<History*, Waiter> _settingWaiters;
+	Queue _waiters;
+	Queue _alerts;
+	SingleTimer _waitTimer;
 
 	std::unique_ptr<Manager> _manager;
 
@@ -112,8 +137,11 @@ public:
 	Manager(System *system) : _system(system) {
 	}
 
-	void showNotification(HistoryItem *item, int forwardedCount) {
-		doShowNotification(item, forwardedCount);
+	void showNotification(
+			HistoryItem *item,
+			int forwardedCount,
+			int coalescedCount) {
+		doShowNotification(item, forwardedCount, coalescedCount);
 	}
 	void updateAll() {
 		doUpdateAll();
@@ -152,7 +180,10 @@ protected:
 	}
 
 	virtual void doUpdateAll() = 0;
-	virtual void doShowNotification(HistoryItem *item, int forwardedCount) = 0;
+	virtual void doShowNotification(
+		HistoryItem *item,
+		int forwardedCount,
+		int coalescedCount) = 0;
 	virtual void doClearAll() = 0;
 	virtual void doClearAllFast() = 0;
 	virtual void doClearFromItem(HistoryItem *item) = 0;
@@ -183,7 +214,10 @@ protected:
 	}
 	void doClearFromItem(HistoryItem *item) override {
 	}
-	void doShowNotification(HistoryItem *item, int forwardedCount) override;
+	void doShowNotification(
+		HistoryItem *item,
+		int forwardedCount,
+		int coalescedCount) override;
 
 	virtual void doShowNativeNotification(PeerData *peer, MsgId msgId, const QString &title, const QString &subtitle, const QString &msg, bool hideNameAndPhoto, bool hideReplyButton) = 0;
 
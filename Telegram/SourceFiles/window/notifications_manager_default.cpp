@@ -67,12 +67,14 @@ Manager::Manager(System *system) : Notifications::Manager(system) {
 
 Manager::QueuedNotification::QueuedNotification(
 	not_null<HistoryItem*> item
-	, int forwardedCount)
+	, int forwardedCount
+	, int coalescedCount)
 : history(item->history())
 , peer(history->peer)
 , author((!peer->isUser() && !item->isPost()) ? item->author().get() : nullptr)
 , item((forwardedCount < 2) ? item.get() : nullptr)
-, forwardedCount(forwardedCount) {
+, forwardedCount(forwardedCount)
+, coalescedCount(coalescedCount) {
 }
 
 QPixmap Manager::hiddenUserpicPlaceholder() const {
@@ -206,6 +208,7 @@ void Manager::showNextFromQueue() {
 			queued.author,
 			queued.item,
 			queued.forwardedCount,
+			queued.coalescedCount,
 			startPosition, startShift, shiftDirection);
 		_notifications.push_back(std::move(notification));
 		--count;
@@ -288,8 +291,12 @@ void Manager::removeWidget(internal::Widget *remove) {
 	showNextFromQueue();
 }
 
-void Manager::doShowNotification(HistoryItem *item, int forwardedCount) {
-	_queuedNotifications.push_back(QueuedNotification(item, forwardedCount));
+void Manager::doShowNotification(
+		HistoryItem *item,
+		int forwardedCount,
+		int coalescedCount) {
+	_queuedNotifications.push_back(
+		QueuedNotification(item, forwardedCount, coalescedCount));
 	showNextFromQueue();
 }
 
@@ -479,12 +486,13 @@ void Background::paintEvent(QPaintEvent *e) {
 	p.fillRect(st::notifyBorderWidth, height() - st::notifyBorderWidth, width() - 2 * st::notifyBorderWidth, st::notifyBorderWidth, st::notifyBorder);
 }
 
-Notification::Notification(Manager *manager, History *history, PeerData *peer, PeerData *author, HistoryItem *msg, int forwardedCount, QPoint startPosition, int shift, Direction shiftDirection) : Widget(manager, startPosition, shift, shiftDirection)
+Notification::Notification(Manager *manager, History *history, PeerData *peer, PeerData *author, HistoryItem *msg, int forwardedCount, int coalescedCount, QPoint startPosition, int shift, Direction shiftDirection) : Widget(manager, startPosition, shift, shiftDirection)
 , _history(history)
 , _peer(peer)
 , _author(author)
 , _item(msg)
 , _forwardedCount(forwardedCount)
+, _coalescedCount(coalescedCount)
 #ifdef Q_OS_WIN
 , _started(GetTickCount())
 #endif // Q_OS_WIN
@@ -661,7 +669,11 @@ void Notification::updateNotifyDisplay() {
 			const HistoryItem *textCachedFor = 0;
 			Text itemTextCache(itemWidth);
 			QRect r(st::notifyPhotoPos.x() + st::notifyPhotoSize + st::notifyTextLeft, st::notifyItemTop + st::msgNameFont->height, itemWidth, 2 * st::dialogsTextFont->height);
-			if (_item) {
+			if (_item && _coalescedCount > 0) {
+				p.setFont(st::dialogsTextFont);
+				p.setPen(st::dialogsTextFg);
+				p.drawText(r.left(), r.top() + st::dialogsTextFont->ascent, lng_notification_messages(lt_count, _coalescedCount + 1));
+			} else if (_item) {
 				auto active = false, selected = false;
 				_item->drawInDialog(
 					p,
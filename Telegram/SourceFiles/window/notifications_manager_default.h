@@ -51,7 +51,10 @@ private:
 	QPixmap hiddenUserpicPlaceholder() const;
 
 	void doUpdateAll() override;
-	void doShowNotification(HistoryItem *item, int forwardedCount) override;
+	void doShowNotification(
+		HistoryItem *item,
+		int forwardedCount,
+		int coalescedCount) override;
 	void doClearAll() override;
 	void doClearAllFast() override;
 	void doClearFromHistory(History *history) override;
@@ -82,13 +85,17 @@ private:
 	SingleTimer _inputCheckTimer;
 
 	struct QueuedNotification {
-		QueuedNotification(not_null<HistoryItem*> item, int forwardedCount);
+		QueuedNotification(
+			not_null<HistoryItem*> item,
+			int forwardedCount,
+			int coalescedCount);
 
 		not_null<History*> history;
 		not_null<PeerData*> peer;
 		PeerData *author;
 		HistoryItem *item;
 		int forwardedCount;
+		int coalescedCount;
 	};
 	std::deque<QueuedNotification> _queuedNotifications;
 
@@ -165,7 +172,7 @@ protected:
 
 class Notification : public Widget {
 public:
-	Notification(Manager *manager, History *history, PeerData *peer, PeerData *author, HistoryItem *item, int forwardedCount, QPoint startPosition, int shift, Direction shiftDirection);
+	Notification(Manager *manager, History *history, PeerData *peer, PeerData *author, HistoryItem *item, int forwardedCount, int coalescedCount, QPoint startPosition, int shift, Direction shiftDirection);
 
 	void startHiding();
 	void stopHiding();
@@ -224,6 +231,7 @@ private:
 	PeerData *_author;
 	HistoryItem *_item;
 	int _forwardedCount;
+	int _coalescedCount;
 	object_ptr<Ui::IconButton> _close;
 	object_ptr<Ui::RoundButton> _reply;
 	object_ptr<Background> _background = { nullptr };
@@ -121,7 +121,9 @@ void PasscodeLockWidget::paintContent(Painter &p) {
 }
 
 void PasscodeLockWidget::submit() {
-	if (_passcode->text().isEmpty()) {
+	if (_checking) {
+		return;
+	} else if (_passcode->text().isEmpty()) {
 		_passcode->showError();
 		return;
 	}
@@ -133,9 +135,21 @@ void PasscodeLockWidget::submit() {
 	}
 
 	const auto passcode = _passcode->text().toUtf8();
-	const auto correct = App::main()
-		? Local::checkPasscode(passcode)
-		: (Local::readMap(passcode) != Local::ReadMapPassNeeded);
+	const auto done = crl::guard(this, [=](bool correct) {
+		checked(correct);
+	});
+	setChecking(true);
+	if (App::main()) {
+		Local::checkPasscodeAsync(passcode, done);
+	} else {
+		Local::readMapAsync(passcode, [=](Local::ReadMapState state) {
+			done(state != Local::ReadMapPassNeeded);
+		});
+	}
+}
+
+void PasscodeLockWidget::checked(bool correct) {
+	setChecking(false);
 	if (!correct) {
 		cSetPasscodeBadTries(cPasscodeBadTries() + 1);
 		cSetPasscodeLastTry(getms(true));
@@ -146,6 +160,11 @@ void PasscodeLockWidget::submit() {
 	Messenger::Instance().unlockPasscode(); // Destroys this widget.
 }
 
+void PasscodeLockWidget::setChecking(bool checking) {
+	_checking = checking;
+	_submit->setDisabled(checking);
+}
+
 void PasscodeLockWidget::error() {
 	_error = lang(lng_passcode_wrong);
 	_passcode->selectAll();
@@ -84,7 +84,7 @@ MainMenu::MainMenu(
 
 	subscribe(Auth().downloaderTaskFinished(), [this] { update(); });
 	subscribe(Auth().downloaderTaskFinished(), [this] { update(); });
-	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(Notify::PeerUpdate::Flag::UserPhoneChanged, [this](const Notify::PeerUpdate &update) {
+	subscribe(Notify::PeerUpdated(Notify::PeerUpdate::Flag::UserPhoneChanged), Notify::PeerUpdatedHandler("MainMenu::MainMenu", [this](const Notify::PeerUpdate &update) {
 		if (update.peer->isSelf()) {
 			updatePhone();
 		}
@@ -215,7 +215,8 @@ void Filler::addPinToggle() {
 
 	auto lifetime = Notify::PeerUpdateViewer(
 		peer,
-		Notify::PeerUpdate::Flag::PinnedChanged
+		Notify::PeerUpdate::Flag::PinnedChanged,
+		"Window::Filler::addPinToggle"
 	) | rpl::start_with_next([peer, pinAction, pinText] {
 		auto isPinned = App::history(peer)->isPinnedDialog();
 		pinAction->setText(pinText(isPinned));
@@ -242,7 +243,8 @@ void Filler::addFavoriteToggle() {
 
 	auto lifetime = Notify::PeerUpdateViewer(
 		peer,
-		Notify::PeerUpdate::Flag::FavoriteChanged
+		Notify::PeerUpdate::Flag::FavoriteChanged,
+		"Window::Filler::addFavoriteToggle"
 	) | rpl::start_with_next([peer, favoriteAction, favoriteText] {
 		auto isFavorite = App::history(peer)->isFavoriteDialog();
 		favoriteAction->setText(favoriteText(isFavorite));
@@ -304,7 +306,8 @@ void Filler::addToggleUnreadMark() {
 
 	auto lifetime = Notify::PeerUpdateViewer(
 		_peer,
-		Notify::PeerUpdate::Flag::UnreadViewChanged
+		Notify::PeerUpdate::Flag::UnreadViewChanged,
+		"Window::Filler::addToggleUnreadMark"
 	) | rpl::start_with_next([=] {
 		action->setText(label(peer));
 	});
@@ -342,7 +345,8 @@ void Filler::addBlockUser(not_null<UserData*> user) {
 
 	auto lifetime = Notify::PeerUpdateViewer(
 		_peer,
-		Notify::PeerUpdate::Flag::UserIsBlocked
+		Notify::PeerUpdate::Flag::UserIsBlocked,
+		"Window::Filler::addBlockUser"
 	) | rpl::start_with_next([=] {
 		blockAction->setText(blockText(user));
 	});
@@ -83,6 +83,42 @@
       '<(src_loc)/base/flat_set.h',
       '<(src_loc)/base/flat_set_tests.cpp',
     ],
+  }, {
+    'target_name': 'tests_input_fields_text_cache',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/ui/widgets/input_fields_text_cache.h',
+      '<(src_loc)/ui/widgets/input_fields_text_cache_tests.cpp',
+    ],
+  }, {
+    'target_name': 'tests_mpsc_queue',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/base/mpsc_queue.h',
+      '<(src_loc)/base/mpsc_queue_tests.cpp',
+    ],
+  }, {
+    'target_name': 'tests_timer_wheel',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/base/timer_wheel.h',
+      '<(src_loc)/base/timer_wheel_tests.cpp',
+    ],
+  }, {
+    'target_name': 'tests_text_forward_matcher',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/ui/text/text_forward_matcher.h',
+      '<(src_loc)/ui/text/text_forward_matcher_tests.cpp',
+    ],
   }, {
     'target_name': 'tests_rpl',
     'includes': [